@@ -3,6 +3,7 @@
 #include <cstdlib>
 
 #include "HalideBuffer.h"
+#include "halide_benchmark.h"
 #include "pipeline_c.h"
 #include "pipeline_native.h"
 
@@ -62,6 +63,17 @@ int main(int argc, char **argv) {
         }
     }
 
+    // The C backend emits native vector types where the compiler supports
+    // them, so its output should be within reach of the LLVM output.
+    double native_time = Halide::Tools::benchmark([&]() {
+        pipeline_native(in, out_native);
+    });
+    double c_time = Halide::Tools::benchmark([&]() {
+        pipeline_c(in, out_c);
+    });
+    printf("Native time: %f ms\n", native_time * 1e3);
+    printf("C backend time: %f ms (%.2fx native)\n", c_time * 1e3, c_time / native_time);
+
     printf("Success!\n");
     return 0;
 }
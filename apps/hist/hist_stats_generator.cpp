@@ -0,0 +1,76 @@
+#include "Halide.h"
+
+namespace {
+
+enum class HistStatsSchedule {
+    Serial,
+    Atomic,
+    Privatized,
+};
+
+// Per-bin statistics of an image: for each luma bin, the sum and the
+// sum of squares of the red channel. This is a parallel histogram of
+// float pairs, which is a stress test for atomic() updates of Tuples.
+class HistStats : public Halide::Generator<HistStats> {
+public:
+    GeneratorParam<HistStatsSchedule> schedule{
+        "schedule",
+        HistStatsSchedule::Atomic,
+        {{"serial", HistStatsSchedule::Serial},
+         {"atomic", HistStatsSchedule::Atomic},
+         {"privatized", HistStatsSchedule::Privatized}}};
+
+    Input<Buffer<float>> input{"input", 3};
+    Output<Func> output{"output", {Float(32), Float(32)}, 1};
+
+    void generate() {
+        Var x("x"), y("y");
+
+        Func Y("Y");
+        Y(x, y) = (0.299f * input(x, y, 0) +
+                   0.587f * input(x, y, 1) +
+                   0.114f * input(x, y, 2));
+
+        RDom r(0, input.width(), 0, input.height());
+        Expr bin = cast<int>(clamp(Y(r.x, r.y) * 255.0f, 0, 255));
+        Expr v = input(r.x, r.y, 0);
+
+        output(x) = Tuple(0.0f, 0.0f);
+        output(bin) += Tuple(v, v * v);
+
+        // Estimates (for autoscheduler; ignored otherwise)
+        {
+            input.dim(0).set_estimate(0, 1536);
+            input.dim(1).set_estimate(0, 2560);
+            input.dim(2).set_estimate(0, 3);
+            output.set_estimate(x, 0, 256);
+        }
+
+        // Schedule
+        if (!auto_schedule) {
+            output.bound(x, 0, 256);
+            output.compute_root();
+            if (schedule == HistStatsSchedule::Atomic) {
+                // Each element of the tuple is only updated in terms
+                // of itself, so this lowers to lock-free atomic adds
+                // on each element rather than a mutex per bin.
+                RVar ryo, ryi;
+                output.update()
+                    .atomic()
+                    .split(r.y, ryo, ryi, 16)
+                    .parallel(ryo);
+            } else if (schedule == HistStatsSchedule::Privatized) {
+                // Give each of a handful of parallel tasks its own
+                // copy of the histogram, so there's no contention on
+                // hot bins, then merge the copies.
+                Var u("u");
+                output.update()
+                    .privatize(r.y, u, 16, natural_vector_size<float>());
+            }
+        }
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(HistStats, hist_stats)
@@ -0,0 +1,55 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+
+#include "hist_stats.h"
+#include "hist_stats_privatized.h"
+#include "hist_stats_serial.h"
+
+#include "benchmark_util.h"
+
+using Halide::Runtime::Buffer;
+
+int main(int argc, char **argv) {
+    int width = 1536, height = 2560;
+    if (argc == 3) {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+
+    Buffer<float> input(width, height, 3);
+    input.for_each_value([](float &v) {
+        v = (float)rand() / RAND_MAX;
+    });
+
+    Buffer<float> sum(256), sum_sq(256);
+    Buffer<float> serial_sum(256), serial_sum_sq(256);
+    Buffer<float> private_sum(256), private_sum_sq(256);
+
+    multi_way_bench({
+        {"Serial", [&]() { hist_stats_serial(input, serial_sum, serial_sum_sq); }},
+        {"Parallel atomic", [&]() { hist_stats(input, sum, sum_sq); }},
+        {"Parallel privatized", [&]() { hist_stats_privatized(input, private_sum, private_sum_sq); }},
+    });
+
+    // The sums are accumulated in a different order, so only expect
+    // them to match approximately.
+    auto close = [](float a, float b) {
+        return std::abs(a - b) <= 1e-3f * (1 + std::abs(b));
+    };
+    for (int i = 0; i < 256; i++) {
+        if (!close(sum(i), serial_sum(i)) || !close(sum_sq(i), serial_sum_sq(i)) ||
+            !close(private_sum(i), serial_sum(i)) || !close(private_sum_sq(i), serial_sum_sq(i))) {
+            printf("Mismatch in bin %d: (%f, %f) and (%f, %f) instead of (%f, %f)\n",
+                   i, sum(i), sum_sq(i), private_sum(i), private_sum_sq(i),
+                   serial_sum(i), serial_sum_sq(i));
+            return 1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include <assert.h>
+#include <math.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <utility>
+#include <vector>
+
+#include "halide_benchmark.h"
+
+#include "AveragePoolBackward.h"
+#include "ConvolutionBackward.h"
+#include "DepthwiseConvolutionBackward.h"
+#include "MatrixMultiplyBackward.h"
+#include "MaxPoolBackward.h"
+#include "TrainStep.h"
+
+#include "HalideBuffer.h"
+
+using Halide::Runtime::Buffer;
+
+float random_float(float scale) {
+    return scale * ((float)rand() / RAND_MAX - 0.5f);
+}
+
+Buffer<float> random_buffer(std::vector<int> sizes, float scale) {
+    Buffer<float> buf(sizes);
+    buf.for_each_value([=](float &x) {
+        x = random_float(scale);
+    });
+    return buf;
+}
+
+// Compare a gradient computed by a pipeline with a naive reference.
+void check(const char *name, const Buffer<float> &actual, const Buffer<double> &expected) {
+    expected.for_each_element([&](const int *pos) {
+        double e = expected(pos);
+        double a = actual(pos);
+        if (fabs(a - e) > 1e-3 * (1 + fabs(e))) {
+            printf("Mismatch in %s at (%d, %d, ...): %g != %g\n", name, pos[0], pos[1], a, e);
+            abort();
+        }
+    });
+}
+
+template<typename F>
+void time_pipeline(const char *name, F pipeline) {
+    printf("Running %s...\n", name);
+    double time = Halide::Tools::benchmark([&]() {
+        int result = pipeline();
+        if (result != 0) {
+            printf("pipeline failed! %d\n", result);
+        }
+    });
+    printf("Done, time: %g s\n", time);
+}
+
+// Call f(window_x, window_y, input_x, input_y) for each tap of each output
+// position (x, y) of a pooling or convolution window that lies inside the
+// input.
+template<typename F>
+void for_each_tap(int x, int y, int stride, int pad_width, int pad_height,
+                  int filter_width, int filter_height, int width, int height, F f) {
+    for (int fy = 0; fy < filter_height; fy++) {
+        for (int fx = 0; fx < filter_width; fx++) {
+            int ix = x * stride + fx - pad_width;
+            int iy = y * stride + fy - pad_height;
+            if (ix >= 0 && ix < width && iy >= 0 && iy < height) {
+                f(fx, fy, ix, iy);
+            }
+        }
+    }
+}
+
+void test_convolution_backward(int C, int W, int H, int N, int output_depth) {
+    const int stride = 1, pad = 1;
+    Buffer<float> input = random_buffer({C, W, H, N}, 1.0f);
+    Buffer<float> filter = random_buffer({C, 3, 3, output_depth}, 1.0f);
+    Buffer<float> bias = random_buffer({output_depth}, 1.0f);
+    Buffer<float> d_output = random_buffer({output_depth, W, H, N}, 1.0f);
+    Buffer<float> d_input(C, W, H, N), d_filter(C, 3, 3, output_depth), d_bias(output_depth);
+    time_pipeline("ConvolutionBackward", [&]() {
+        return ConvolutionBackward(input, filter, bias, stride, pad, pad, d_output,
+                                   d_input, d_filter, d_bias);
+    });
+
+    Buffer<double> e_input(C, W, H, N), e_filter(C, 3, 3, output_depth), e_bias(output_depth);
+    e_input.fill(0);
+    e_filter.fill(0);
+    e_bias.fill(0);
+    d_output.for_each_element([&](int d, int x, int y, int n) {
+        double g = d_output(d, x, y, n);
+        e_bias(d) += g;
+        for_each_tap(x, y, stride, pad, pad, 3, 3, W, H, [&](int fx, int fy, int ix, int iy) {
+            for (int c = 0; c < C; c++) {
+                e_input(c, ix, iy, n) += g * filter(c, fx, fy, d);
+                e_filter(c, fx, fy, d) += g * input(c, ix, iy, n);
+            }
+        });
+    });
+    check("ConvolutionBackward d_input", d_input, e_input);
+    check("ConvolutionBackward d_filter", d_filter, e_filter);
+    check("ConvolutionBackward d_bias", d_bias, e_bias);
+}
+
+void test_depthwise_convolution_backward(int C, int W, int H, int N) {
+    // The generator's depth multiplier is 1.
+    const int stride = 2, pad = 1;
+    const int out_W = (W + 2 * pad - 3) / stride + 1, out_H = (H + 2 * pad - 3) / stride + 1;
+    Buffer<float> input = random_buffer({C, W, H, N}, 1.0f);
+    Buffer<float> filter = random_buffer({C, 3, 3}, 1.0f);
+    Buffer<float> bias = random_buffer({C}, 1.0f);
+    Buffer<float> d_output = random_buffer({C, out_W, out_H, N}, 1.0f);
+    Buffer<float> d_input(C, W, H, N), d_filter(C, 3, 3), d_bias(C);
+    time_pipeline("DepthwiseConvolutionBackward", [&]() {
+        return DepthwiseConvolutionBackward(input, filter, bias, stride, pad, pad, d_output,
+                                            d_input, d_filter, d_bias);
+    });
+
+    Buffer<double> e_input(C, W, H, N), e_filter(C, 3, 3), e_bias(C);
+    e_input.fill(0);
+    e_filter.fill(0);
+    e_bias.fill(0);
+    d_output.for_each_element([&](int c, int x, int y, int n) {
+        double g = d_output(c, x, y, n);
+        e_bias(c) += g;
+        for_each_tap(x, y, stride, pad, pad, 3, 3, W, H, [&](int fx, int fy, int ix, int iy) {
+            e_input(c, ix, iy, n) += g * filter(c, fx, fy);
+            e_filter(c, fx, fy) += g * input(c, ix, iy, n);
+        });
+    });
+    check("DepthwiseConvolutionBackward d_input", d_input, e_input);
+    check("DepthwiseConvolutionBackward d_filter", d_filter, e_filter);
+    check("DepthwiseConvolutionBackward d_bias", d_bias, e_bias);
+}
+
+void test_matrix_multiply_backward(int rows, int inner, int columns) {
+    // output(x, y) = bias(x) + sum_k mat_a(k, y) * mat_b(x, k)
+    Buffer<float> mat_a = random_buffer({inner, rows}, 1.0f);
+    Buffer<float> mat_b = random_buffer({columns, inner}, 1.0f);
+    Buffer<float> bias = random_buffer({columns}, 1.0f);
+    Buffer<float> d_output = random_buffer({columns, rows}, 1.0f);
+    Buffer<float> d_mat_a(inner, rows), d_mat_b(columns, inner), d_bias(columns);
+    time_pipeline("MatrixMultiplyBackward", [&]() {
+        return MatrixMultiplyBackward(mat_a, mat_b, bias, d_output, d_mat_a, d_mat_b, d_bias);
+    });
+
+    Buffer<double> e_mat_a(inner, rows), e_mat_b(columns, inner), e_bias(columns);
+    e_mat_a.fill(0);
+    e_mat_b.fill(0);
+    e_bias.fill(0);
+    d_output.for_each_element([&](int x, int y) {
+        double g = d_output(x, y);
+        e_bias(x) += g;
+        for (int k = 0; k < inner; k++) {
+            e_mat_a(k, y) += g * mat_b(x, k);
+            e_mat_b(x, k) += g * mat_a(k, y);
+        }
+    });
+    check("MatrixMultiplyBackward d_mat_a", d_mat_a, e_mat_a);
+    check("MatrixMultiplyBackward d_mat_b", d_mat_b, e_mat_b);
+    check("MatrixMultiplyBackward d_bias", d_bias, e_bias);
+}
+
+void test_pool_backward(int C, int W, int H, int N) {
+    const int stride = 2, pad = 1, filter_size = 3;
+    const int out_W = (W + 2 * pad - filter_size) / stride + 1;
+    const int out_H = (H + 2 * pad - filter_size) / stride + 1;
+    Buffer<float> input = random_buffer({C, W, H, N}, 1.0f);
+    Buffer<float> d_output = random_buffer({C, out_W, out_H, N}, 1.0f);
+    Buffer<float> d_input(C, W, H, N);
+
+    time_pipeline("AveragePoolBackward", [&]() {
+        return AveragePoolBackward(input, stride, pad, pad, filter_size, filter_size, d_output, d_input);
+    });
+    // The average is over the whole window, padding included.
+    Buffer<double> expected(C, W, H, N);
+    expected.fill(0);
+    d_output.for_each_element([&](int c, int x, int y, int n) {
+        double g = d_output(c, x, y, n) / (filter_size * filter_size);
+        for_each_tap(x, y, stride, pad, pad, filter_size, filter_size, W, H, [&](int, int, int ix, int iy) {
+            expected(c, ix, iy, n) += g;
+        });
+    });
+    check("AveragePoolBackward d_input", d_input, expected);
+
+    time_pipeline("MaxPoolBackward", [&]() {
+        return MaxPoolBackward(input, stride, pad, pad, filter_size, filter_size, d_output, d_input);
+    });
+    // The gradient goes to the first maximum of each window.
+    expected.fill(0);
+    d_output.for_each_element([&](int c, int x, int y, int n) {
+        float best = 0;
+        int best_x = -1, best_y = -1;
+        for_each_tap(x, y, stride, pad, pad, filter_size, filter_size, W, H, [&](int, int, int ix, int iy) {
+            if (best_x < 0 || input(c, ix, iy, n) > best) {
+                best = input(c, ix, iy, n);
+                best_x = ix;
+                best_y = iy;
+            }
+        });
+        expected(c, best_x, best_y, n) += d_output(c, x, y, n);
+    });
+    check("MaxPoolBackward d_input", d_input, expected);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        printf("Usage: %s C W H N [output_depth classes steps]\n", argv[0]);
+        return 0;
+    }
+
+    int C = atoi(argv[1]);
+    int W = atoi(argv[2]);
+    int H = atoi(argv[3]);
+    int N = atoi(argv[4]);
+    int output_depth = 16;
+    int classes = 4;
+    int steps = 20;
+    if (argc > 5) output_depth = atoi(argv[5]);
+    if (argc > 6) classes = atoi(argv[6]);
+    if (argc > 7) steps = atoi(argv[7]);
+
+    printf("Benchmarking training on %dx%dx%dx%d, %d filters, %d classes\n",
+           C, W, H, N, output_depth, classes);
+
+    Buffer<float> images(C, W, H, N);
+    Buffer<int32_t> labels(N);
+    images.for_each_value([](float &x) {
+        x = random_float(1.0f);
+    });
+    // Make the labels learnable: the class is the brightest input channel.
+    for (int n = 0; n < N; n++) {
+        int brightest = 0;
+        float best = -1e30f;
+        for (int c = 0; c < C; c++) {
+            float total = 0.0f;
+            for (int y = 0; y < H; y++) {
+                for (int x = 0; x < W; x++) {
+                    total += images(c, x, y, n);
+                }
+            }
+            if (total > best) {
+                best = total;
+                brightest = c;
+            }
+        }
+        labels(n) = brightest % classes;
+    }
+
+    Buffer<float> filter(C, 3, 3, output_depth), new_filter(C, 3, 3, output_depth);
+    Buffer<float> bias(output_depth), new_bias(output_depth);
+    Buffer<float> fc_weights(classes, output_depth), new_fc_weights(classes, output_depth);
+    Buffer<float> fc_bias(classes), new_fc_bias(classes);
+    filter.for_each_value([](float &x) {
+        x = random_float(0.5f);
+    });
+    fc_weights.for_each_value([](float &x) {
+        x = random_float(0.5f);
+    });
+    bias.fill(0.0f);
+    fc_bias.fill(0.0f);
+
+    // The backward pass of each layer on its own, checked against a naive
+    // implementation.
+    test_convolution_backward(C, W, H, N, output_depth);
+    test_depthwise_convolution_backward(output_depth, W, H, N);
+    test_matrix_multiply_backward(N, output_depth, classes);
+    test_pool_backward(output_depth, W, H, N);
+
+    // A full training loop: each step runs the forward pass, the backward
+    // pass and the weight update, in parallel across the batch.
+    printf("Running %d TrainStep iterations...\n", steps);
+    Buffer<float> loss = Buffer<float>::make_scalar();
+    const float learning_rate = 0.1f;
+    float first_loss = 0.0f;
+    double total_time = 0;
+    for (int step = 0; step < steps; step++) {
+        double t = Halide::Tools::benchmark(1, 1, [&]() {
+            int result = TrainStep(images, labels, learning_rate,
+                                   filter, bias, fc_weights, fc_bias,
+                                   loss, new_filter, new_bias, new_fc_weights, new_fc_bias);
+            if (result != 0) {
+                printf("pipeline failed! %d\n", result);
+            }
+        });
+        total_time += t;
+        if (step == 0) {
+            first_loss = loss();
+        }
+        std::swap(filter, new_filter);
+        std::swap(bias, new_bias);
+        std::swap(fc_weights, new_fc_weights);
+        std::swap(fc_bias, new_fc_bias);
+    }
+    printf("Done, time per step: %g s, throughput: %g images/s\n",
+           total_time / steps, N * steps / total_time);
+    printf("Loss: %g -> %g\n", first_loss, loss());
+
+    if (!(loss() < first_loss)) {
+        printf("Training did not reduce the loss\n");
+        abort();
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,5 @@
+TRAINING=$1
+# Columns are: C W H N output_depth classes steps
+$TRAINING 8 16 16 1 16 4 20
+$TRAINING 8 16 16 16 16 4 20
+$TRAINING 32 14 14 32 32 8 20
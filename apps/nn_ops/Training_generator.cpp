@@ -0,0 +1,470 @@
+// This file implements float32 backward passes for the nn_ops layers, and a
+// small end-to-end training step built from them.
+//
+// Each *Backward generator takes the inputs of the forward layer plus the
+// gradient of the loss with respect to the layer's output (d_output), and
+// produces the gradient of the loss with respect to each forward input.
+// Except for max pooling, the backward pipelines are not written by hand:
+// they are derived from float32 versions of the forward layers with
+// propagate_adjoints, and each is scheduled for its own shape.
+//
+// Tensors use the same layout as the quantized generators: activations are
+// indexed by depth, x, y, batch, and matrices by column, row.
+
+#include <Halide.h>
+#include <set>
+
+using namespace Halide;
+using Halide::BoundaryConditions::constant_exterior;
+
+namespace {
+
+// The region covered by a buffer, for use as the output bounds of
+// propagate_adjoints.
+template<typename T>
+Region buffer_region(const T &buf) {
+    Region region;
+    for (int i = 0; i < buf.dimensions(); i++) {
+        region.emplace_back(buf.dim(i).min(), buf.dim(i).extent());
+    }
+    return region;
+}
+
+// Vectorize the innermost dimension of a stage and parallelize dimension
+// parallel_dim (or nothing, if it's negative), but only where those
+// dimensions are still pure variables of the stage, which keeps the
+// schedule legal for any stage shape propagate_adjoints produces. If
+// parallel_dim is 0, the innermost dimension is split into vectors and the
+// vectors are done in parallel.
+void schedule_stage(Stage s, const std::vector<Var> &args,
+                    const std::vector<Expr> &stage_args,
+                    int parallel_dim, int vector_size) {
+    auto is_pure = [&](int d) {
+        const Internal::Variable *v = stage_args[d].as<Internal::Variable>();
+        return v && v->name == args[d].name();
+    };
+    if (parallel_dim > 0 && is_pure(parallel_dim)) {
+        s.parallel(args[parallel_dim]);
+    }
+    if (is_pure(0)) {
+        if (parallel_dim == 0) {
+            Var outer(args[0].name() + "_vectors");
+            s.split(args[0], outer, args[0], vector_size, TailStrategy::GuardWithIf)
+                .vectorize(args[0])
+                .parallel(outer);
+        } else {
+            s.vectorize(args[0], vector_size, TailStrategy::GuardWithIf);
+        }
+    }
+}
+
+// Compute a Func at root and schedule each of its stages as above.
+void schedule_root(Func f, int parallel_dim, int vector_size) {
+    f.compute_root();
+    const std::vector<Var> args = f.args();
+    schedule_stage(f, args, std::vector<Expr>(args.begin(), args.end()), parallel_dim, vector_size);
+    for (int u = 0; u < f.num_update_definitions(); u++) {
+        schedule_stage(f.update(u), args, f.update_args(u), parallel_dim, vector_size);
+    }
+}
+
+// Funcs with update definitions can't be inlined. Compute at root any that
+// the outputs of a backward pipeline use and that weren't scheduled
+// explicitly, such as the adjoints propagate_adjoints creates for the
+// intermediate stages of a layer.
+void compute_rest_at_root(const std::vector<Func> &outputs,
+                          const std::set<std::string> &scheduled) {
+    std::set<std::string> done = scheduled;
+    for (const Func &output : outputs) {
+        for (const auto &it : Internal::find_transitive_calls(output.function())) {
+            Func f(it.second);
+            if (f.has_update_definition() && done.insert(f.name()).second) {
+                f.compute_root();
+            }
+        }
+    }
+}
+
+// Schedule every Func in a backward pipeline that has update definitions:
+// the accumulations in the forward pass, and the adjoints propagate_adjoints
+// creates for each forward Func, update and input. Pure Funcs (pointwise
+// layers, and their adjoints) are left inline. The outermost dimension is
+// the batch for activations and the output channel for weights, so both the
+// forward and the backward pass are parallel across the batch. This is
+// only used for TrainStep, which differentiates a whole network; the
+// backward passes of single layers are scheduled individually.
+void schedule_backward(const Func &output, const Derivative &d, int vector_size) {
+    std::set<std::string> scheduled;
+    auto schedule = [&](Func f) {
+        if (!f.defined() || !f.has_update_definition() ||
+            !scheduled.insert(f.name()).second) {
+            return;
+        }
+        schedule_root(f, (int)f.args().size() - 1, vector_size);
+    };
+
+    for (const auto &it : Internal::find_transitive_calls(output.function())) {
+        Func f(it.second);
+        schedule(f);
+        for (int u = -1; u < f.num_update_definitions(); u++) {
+            schedule(d(f, u));
+        }
+    }
+}
+
+// Float32 forward layers. These mirror the quantized generators, without the
+// offsets, multipliers and saturation.
+
+Func zero_padded(Func input, Expr width, Expr height) {
+    return constant_exterior(input, 0.0f,
+                             {{Expr(), Expr()},
+                              {0, width},
+                              {0, height},
+                              {Expr(), Expr()}});
+}
+
+// Each layer that pads its input also returns the padded input, whose
+// adjoint the backward passes schedule.
+Func convolution(Func input, Func filter, Func bias,
+                 Expr input_depth, Expr width, Expr height,
+                 Expr filter_width, Expr filter_height,
+                 Expr stride, Expr pad_width, Expr pad_height,
+                 Func *padded_input = nullptr) {
+    Var depth("depth"), x("x"), y("y"), batch("batch");
+    Func padded = zero_padded(input, width, height);
+    if (padded_input) {
+        *padded_input = padded;
+    }
+    RDom r(0, input_depth, 0, filter_width, 0, filter_height);
+    Func convolved("convolved");
+    convolved(depth, x, y, batch) = bias(depth);
+    convolved(depth, x, y, batch) +=
+        filter(r[0], r[1], r[2], depth) *
+        padded(r[0], x * stride + r[1] - pad_width, y * stride + r[2] - pad_height, batch);
+    return convolved;
+}
+
+Func depthwise_convolution(Func input, Func filter, Func bias, int depth_multiplier,
+                           Expr width, Expr height,
+                           Expr filter_width, Expr filter_height,
+                           Expr stride, Expr pad_width, Expr pad_height,
+                           Func *padded_input) {
+    Var depth("depth"), x("x"), y("y"), batch("batch");
+    Func padded = zero_padded(input, width, height);
+    *padded_input = padded;
+    RDom r(0, filter_width, 0, filter_height);
+    Func convolved("convolved");
+    convolved(depth, x, y, batch) = bias(depth);
+    convolved(depth, x, y, batch) +=
+        filter(depth, r[0], r[1]) *
+        padded(depth / depth_multiplier, x * stride + r[0] - pad_width, y * stride + r[1] - pad_height, batch);
+    return convolved;
+}
+
+Func matrix_multiply(Func mat_a, Func mat_b, Func bias, Expr n) {
+    Var x("x"), y("y");
+    RDom k(0, n);
+    Func ab("ab");
+    ab(x, y) = bias(x);
+    ab(x, y) += mat_a(k, y) * mat_b(x, k);
+    return ab;
+}
+
+// Unlike the quantized AveragePool, this divides by the full filter area
+// at the boundary too.
+Func average_pool(Func input, Expr width, Expr height,
+                  Expr filter_width, Expr filter_height,
+                  Expr stride, Expr pad_width, Expr pad_height,
+                  Func *padded_input) {
+    Var depth("depth"), x("x"), y("y"), batch("batch");
+    Func padded = zero_padded(input, width, height);
+    *padded_input = padded;
+    RDom r(0, filter_width, 0, filter_height);
+    Func pooled("pooled");
+    pooled(depth, x, y, batch) +=
+        padded(depth, x * stride + r[0] - pad_width, y * stride + r[1] - pad_height, batch);
+    Func average("average");
+    average(depth, x, y, batch) = pooled(depth, x, y, batch) / cast<float>(filter_width * filter_height);
+    return average;
+}
+
+}  // namespace
+
+class ConvolutionBackward : public Generator<ConvolutionBackward> {
+public:
+    Input<Buffer<float>> input_{"input", 4};
+    Input<Buffer<float>> filter_{"filter", 4};
+    Input<Buffer<float>> bias_{"bias", 1};
+    Input<int> stride_{"stride"};
+    Input<int> pad_width_{"pad_width"};
+    Input<int> pad_height_{"pad_height"};
+    Input<Buffer<float>> d_output_{"d_output", 4};
+
+    Output<Buffer<float>> d_input_{"d_input", 4};
+    Output<Buffer<float>> d_filter_{"d_filter", 4};
+    Output<Buffer<float>> d_bias_{"d_bias", 1};
+
+    void generate() {
+        Func padded;
+        Func output = convolution(input_, filter_, bias_, input_.dim(0).extent(),
+                                  input_.dim(1).extent(), input_.dim(2).extent(),
+                                  filter_.dim(1).extent(), filter_.dim(2).extent(),
+                                  stride_, pad_width_, pad_height_, &padded);
+        Derivative d = propagate_adjoints(output, d_output_, buffer_region(d_output_));
+        Func d_input = d(input_), d_filter = d(filter_), d_bias = d(bias_);
+        Func d_padded = d(padded);
+        d_input_ = d_input;
+        d_filter_ = d_filter;
+        d_bias_ = d_bias;
+
+        // The input gradient scatters the output gradient back through the
+        // filter, which is independent across the batch. The filter
+        // gradient reduces over the whole batch, so it's parallel across
+        // output channels instead. The bias gradient is a sum per output
+        // channel, too small to be worth parallelizing.
+        const int vector_size = natural_vector_size<float>();
+        schedule_root(d_padded, 3, vector_size);
+        schedule_root(d_input, 3, vector_size);
+        schedule_root(d_filter, 3, vector_size);
+        schedule_root(d_bias, -1, vector_size);
+        compute_rest_at_root({d_input, d_filter, d_bias},
+                             {d_padded.name(), d_input.name(), d_filter.name(), d_bias.name()});
+    }
+};
+
+class DepthwiseConvolutionBackward : public Generator<DepthwiseConvolutionBackward> {
+public:
+    GeneratorParam<int> depth_multiplier_{"depth_multiplier", 1, 1, 8};
+
+    Input<Buffer<float>> input_{"input", 4};
+    Input<Buffer<float>> filter_{"filter", 3};
+    Input<Buffer<float>> bias_{"bias", 1};
+    Input<int> stride_{"stride", 1, 1, 2};
+    Input<int> pad_width_{"pad_width"};
+    Input<int> pad_height_{"pad_height"};
+    Input<Buffer<float>> d_output_{"d_output", 4};
+
+    Output<Buffer<float>> d_input_{"d_input", 4};
+    Output<Buffer<float>> d_filter_{"d_filter", 3};
+    Output<Buffer<float>> d_bias_{"d_bias", 1};
+
+    void generate() {
+        Func padded;
+        Func output = depthwise_convolution(input_, filter_, bias_, depth_multiplier_,
+                                            input_.dim(1).extent(), input_.dim(2).extent(),
+                                            filter_.dim(1).extent(), filter_.dim(2).extent(),
+                                            stride_, pad_width_, pad_height_, &padded);
+        Derivative d = propagate_adjoints(output, d_output_, buffer_region(d_output_));
+        Func d_input = d(input_), d_filter = d(filter_), d_bias = d(bias_);
+        Func d_padded = d(padded);
+        d_input_ = d_input;
+        d_filter_ = d_filter;
+        d_bias_ = d_bias;
+
+        // As for ConvolutionBackward, but the filter gradient has only a
+        // few taps per channel, so split its channels into vectors and do
+        // those in parallel.
+        const int vector_size = natural_vector_size<float>();
+        schedule_root(d_padded, 3, vector_size);
+        schedule_root(d_input, 3, vector_size);
+        schedule_root(d_filter, 0, vector_size);
+        schedule_root(d_bias, -1, vector_size);
+        compute_rest_at_root({d_input, d_filter, d_bias},
+                             {d_padded.name(), d_input.name(), d_filter.name(), d_bias.name()});
+    }
+};
+
+class MatrixMultiplyBackward : public Generator<MatrixMultiplyBackward> {
+public:
+    Input<Buffer<float>> mat_a_{"mat_a", 2};
+    Input<Buffer<float>> mat_b_{"mat_b", 2};
+    Input<Buffer<float>> bias_{"bias", 1};
+    Input<Buffer<float>> d_output_{"d_output", 2};
+
+    Output<Buffer<float>> d_mat_a_{"d_mat_a", 2};
+    Output<Buffer<float>> d_mat_b_{"d_mat_b", 2};
+    Output<Buffer<float>> d_bias_{"d_bias", 1};
+
+    void generate() {
+        Func output = matrix_multiply(mat_a_, mat_b_, bias_, mat_a_.dim(0).extent());
+        Derivative d = propagate_adjoints(output, d_output_, buffer_region(d_output_));
+        Func d_mat_a = d(mat_a_), d_mat_b = d(mat_b_), d_bias = d(bias_);
+        d_mat_a_ = d_mat_a;
+        d_mat_b_ = d_mat_b;
+        d_bias_ = d_bias;
+
+        // Both matrix gradients are matrix products, parallel across rows.
+        // The bias gradient is a column sum.
+        const int vector_size = natural_vector_size<float>();
+        schedule_root(d_mat_a, 1, vector_size);
+        schedule_root(d_mat_b, 1, vector_size);
+        schedule_root(d_bias, -1, vector_size);
+        compute_rest_at_root({d_mat_a, d_mat_b, d_bias},
+                             {d_mat_a.name(), d_mat_b.name(), d_bias.name()});
+    }
+};
+
+class AveragePoolBackward : public Generator<AveragePoolBackward> {
+public:
+    Input<Buffer<float>> input_{"input", 4};
+    Input<int> stride_{"stride"};
+    Input<int> pad_width_{"pad_width"};
+    Input<int> pad_height_{"pad_height"};
+    Input<int> filter_width_{"filter_width"};
+    Input<int> filter_height_{"filter_height"};
+    Input<Buffer<float>> d_output_{"d_output", 4};
+
+    Output<Buffer<float>> d_input_{"d_input", 4};
+
+    void generate() {
+        Func padded;
+        Func output = average_pool(input_, input_.dim(1).extent(), input_.dim(2).extent(),
+                                   filter_width_, filter_height_,
+                                   stride_, pad_width_, pad_height_, &padded);
+        Derivative d = propagate_adjoints(output, d_output_, buffer_region(d_output_));
+        Func d_input = d(input_);
+        Func d_padded = d(padded);
+        d_input_ = d_input;
+
+        // Spreading each output gradient over its window is independent
+        // across the batch.
+        const int vector_size = natural_vector_size<float>();
+        schedule_root(d_padded, 3, vector_size);
+        schedule_root(d_input, 3, vector_size);
+        compute_rest_at_root({d_input}, {d_padded.name(), d_input.name()});
+    }
+};
+
+// Unlike the other layers, this backward pass is written by hand.
+// propagate_adjoints can't differentiate an in-place max reduction
+// (pooled = max(pooled, ...)), because each step overwrites the value the
+// next step's derivative depends on, and writing the max as a scan it can
+// differentiate would materialize every step of the scan. Instead, find
+// where each window's maximum came from, and send the output gradient
+// there.
+class MaxPoolBackward : public Generator<MaxPoolBackward> {
+public:
+    Input<Buffer<float>> input_{"input", 4};
+    Input<int> stride_{"stride"};
+    Input<int> pad_width_{"pad_width"};
+    Input<int> pad_height_{"pad_height"};
+    Input<int> filter_width_{"filter_width"};
+    Input<int> filter_height_{"filter_height"};
+    Input<Buffer<float>> d_output_{"d_output", 4};
+
+    Output<Buffer<float>> d_input_{"d_input", 4};
+
+    void generate() {
+        Var depth("depth"), x("x"), y("y"), batch("batch");
+        Expr width = input_.dim(1).extent();
+        Expr height = input_.dim(2).extent();
+        Func padded = constant_exterior(input_, Float(32).min(),
+                                        {{Expr(), Expr()},
+                                         {0, width},
+                                         {0, height},
+                                         {Expr(), Expr()}});
+
+        // The offset within each window of its (first) maximum.
+        RDom r(0, filter_width_, 0, filter_height_);
+        Func window_argmax("window_argmax");
+        window_argmax(depth, x, y, batch) =
+            argmax(r, padded(depth, x * stride_ + r.x - pad_width_, y * stride_ + r.y - pad_height_, batch));
+
+        RDom r_out(d_output_.dim(1).min(), d_output_.dim(1).extent(),
+                   d_output_.dim(2).min(), d_output_.dim(2).extent());
+        Tuple argmax_at = window_argmax(depth, r_out.x, r_out.y, batch);
+        // The maximum is never in the padding unless a whole window is,
+        // so clamping only keeps the scatter in bounds.
+        Expr input_x = clamp(r_out.x * stride_ + argmax_at[0] - pad_width_, 0, width - 1);
+        Expr input_y = clamp(r_out.y * stride_ + argmax_at[1] - pad_height_, 0, height - 1);
+        Func d_input("d_input");
+        d_input(depth, x, y, batch) = 0.0f;
+        d_input(depth, input_x, input_y, batch) += d_output_(depth, r_out.x, r_out.y, batch);
+        d_input_ = d_input;
+
+        // Each batch is independent. Find the maxima of a batch's windows
+        // just before scattering its gradient.
+        const int vector_size = natural_vector_size<float>();
+        d_input.vectorize(depth, vector_size, TailStrategy::GuardWithIf).parallel(batch);
+        d_input.update()
+            .reorder(depth, r_out.x, r_out.y, batch)
+            .vectorize(depth, vector_size, TailStrategy::GuardWithIf)
+            .parallel(batch);
+        window_argmax.compute_at(d_input, batch)
+            .vectorize(depth, vector_size, TailStrategy::GuardWithIf);
+    }
+};
+
+// One SGD step of a small classifier:
+//   3x3 convolution -> ReLU -> global average pool -> fully connected ->
+//   softmax cross-entropy,
+// averaged over a batch. Produces the loss before the step and the updated
+// weights.
+class TrainStep : public Generator<TrainStep> {
+public:
+    Input<Buffer<float>> images_{"images", 4};
+    Input<Buffer<int32_t>> labels_{"labels", 1};
+    Input<float> learning_rate_{"learning_rate"};
+
+    Input<Buffer<float>> filter_{"filter", 4};
+    Input<Buffer<float>> bias_{"bias", 1};
+    Input<Buffer<float>> fc_weights_{"fc_weights", 2};
+    Input<Buffer<float>> fc_bias_{"fc_bias", 1};
+
+    Output<Buffer<float>> loss_{"loss", 0};
+    Output<Buffer<float>> new_filter_{"new_filter", 4};
+    Output<Buffer<float>> new_bias_{"new_bias", 1};
+    Output<Buffer<float>> new_fc_weights_{"new_fc_weights", 2};
+    Output<Buffer<float>> new_fc_bias_{"new_fc_bias", 1};
+
+    void generate() {
+        Var c("c"), x("x"), y("y"), n("n");
+        Expr width = images_.dim(1).extent();
+        Expr height = images_.dim(2).extent();
+        Expr batch_size = images_.dim(3).extent();
+        Expr channels = filter_.dim(3).extent();
+        Expr classes = fc_weights_.dim(0).extent();
+
+        Func conv = convolution(images_, filter_, bias_, images_.dim(0).extent(),
+                                width, height, 3, 3, 1, 1, 1);
+        Func relu("relu");
+        relu(c, x, y, n) = max(0.0f, conv(c, x, y, n));
+
+        RDom r_xy(0, width, 0, height);
+        Func pooled("pooled");
+        pooled(c, n) += relu(c, r_xy.x, r_xy.y, n) / cast<float>(width * height);
+
+        Func logits = matrix_multiply(pooled, fc_weights_, fc_bias_, channels);
+
+        RDom r_k(0, classes);
+        Func log_sum_exp("log_sum_exp");
+        log_sum_exp(n) = log(sum(exp(logits(r_k, n))));
+        Func target_logit("target_logit");
+        target_logit(n) = sum(select(r_k == labels_(n), logits(r_k, n), 0.0f));
+
+        RDom r_n(0, batch_size);
+        Func loss("loss");
+        loss() += (log_sum_exp(r_n) - target_logit(r_n)) / cast<float>(batch_size);
+
+        Derivative d = propagate_adjoints(loss);
+
+        loss_() = loss();
+        Var i("i"), j("j"), k("k"), l("l");
+        new_filter_(i, j, k, l) = filter_(i, j, k, l) - learning_rate_ * d(filter_)(i, j, k, l);
+        new_bias_(i) = bias_(i) - learning_rate_ * d(bias_)(i);
+        new_fc_weights_(i, j) = fc_weights_(i, j) - learning_rate_ * d(fc_weights_)(i, j);
+        new_fc_bias_(i) = fc_bias_(i) - learning_rate_ * d(fc_bias_)(i);
+
+        const int vector_size = natural_vector_size<float>();
+        schedule_backward(loss, d, vector_size);
+        new_filter_.vectorize(i, vector_size, TailStrategy::GuardWithIf).parallel(l);
+        new_fc_weights_.vectorize(i, vector_size, TailStrategy::GuardWithIf);
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(ConvolutionBackward, ConvolutionBackward)
+HALIDE_REGISTER_GENERATOR(DepthwiseConvolutionBackward, DepthwiseConvolutionBackward)
+HALIDE_REGISTER_GENERATOR(MatrixMultiplyBackward, MatrixMultiplyBackward)
+HALIDE_REGISTER_GENERATOR(AveragePoolBackward, AveragePoolBackward)
+HALIDE_REGISTER_GENERATOR(MaxPoolBackward, MaxPoolBackward)
+HALIDE_REGISTER_GENERATOR(TrainStep, TrainStep)
@@ -8,6 +8,8 @@ struct Tensor {
     Halide::Func f;
     std::vector<int> shape;
     std::string name;
+    // For conv layers, the accumulator in blocked (c % 8, i, j, c / 8) form.
+    Halide::Func accum;
 };
 
 struct WeightShape {
@@ -18,6 +20,17 @@ struct WeightShape {
     int stride;
 };
 
+// Conv weights are prepacked (see Resnet50PackWeightsGenerator below) so that
+// output channels are blocked by kOutputBlock and input channels by
+// input_block(). Outputs are also computed kOutputBlock channels at a time.
+const int kOutputBlock = 8;
+
+// The input channel block size for a layer with the given number of input
+// channels. Every layer but conv1 (3 channels) is a multiple of 8.
+int input_block(int channels) {
+    return channels % 8 == 0 ? 8 : channels;
+}
+
 // returns index of found value in array or -1 if not in array
 int find_index(int value, std::vector<int> vec) {
     std::vector<int>::iterator it = std::find(vec.begin(), vec.end(), value);
@@ -55,11 +68,12 @@ public:
     Input<Buffer<float>[16]> br2c_sig { "br2c_sig", 1 };
 
     /** weights and biases for convolutions **/
-    Input<Buffer<float>> conv1_weights{"conv1_weights", 4};
-    Input<Buffer<float>[4]> br1_conv_weights { "br1_conv_weights", 4 };
-    Input<Buffer<float>[16]> br2a_conv_weights { "br2a_conv_weights", 4 };
-    Input<Buffer<float>[16]> br2b_conv_weights { "br2b_conv_weights", 4 };
-    Input<Buffer<float>[16]> br2c_conv_weights { "br2c_conv_weights", 4 };
+    // Conv weights must already be packed by resnet50_pack_weights.
+    Input<Buffer<float>> conv1_weights{"conv1_weights", 6};
+    Input<Buffer<float>[4]> br1_conv_weights { "br1_conv_weights", 6 };
+    Input<Buffer<float>[16]> br2a_conv_weights { "br2a_conv_weights", 6 };
+    Input<Buffer<float>[16]> br2b_conv_weights { "br2b_conv_weights", 6 };
+    Input<Buffer<float>[16]> br2c_conv_weights { "br2c_conv_weights", 6 };
 
     Input<Buffer<float>> fc1000_weights{"fc1000_weights", 2};
     Input<Buffer<float>> fc1000_bias{"fc1000_bias", 1};
@@ -112,7 +126,7 @@ public:
                                      res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws,
                                      res5x_br2c_ws, res5x_br2c_ws, res5x_br2c_ws};
 
-    Var c, i, j;
+    Var c, i, j, co;
 
     void generate() {
 
@@ -217,15 +231,20 @@ public:
             }
         }
 
-        // TODO: Actually schedule this.
-        conv1.f.compute_root();
-        scaled1.f.compute_root();
-        relu1.f.compute_root();
+        // Each conv is accumulated kOutputBlock channels by a strip of
+        // pixels at a time, right where its batch norm, scale, residual
+        // add and ReLU (all inlined) consume it.
+        schedule_fused(relu1.f, {conv1});
         pool1.f.compute_root();
         for (int i = 0; i < 16; i++) {
-            br2a_relu[i].f.compute_root().vectorize(c, 8).parallel(j);
-            br2b_relu[i].f.compute_root().vectorize(c, 8).parallel(j);
-            resunit_relu[i].f.compute_root().vectorize(c, 8).parallel(j);
+            schedule_fused(br2a_relu[i].f, {br2a_conv[i]});
+            schedule_fused(br2b_relu[i].f, {br2b_conv[i]});
+            int br1_i = find_index(i, branch1_indices);
+            if (br1_i >= 0) {
+                schedule_fused(resunit_relu[i].f, {br2c_conv[i], br1_conv[br1_i]});
+            } else {
+                schedule_fused(resunit_relu[i].f, {br2c_conv[i]});
+            }
         }
         pool5.f.compute_root();
         fc1000.f.compute_root();
@@ -233,6 +252,35 @@ public:
     }
 
 private:
+    void schedule_fused(Func out, const std::vector<Tensor> &convs) {
+        // All output widths in resnet50 (112, 56, 28, 14, 7) are multiples
+        // of 7, which is also a reasonable number of accumulators to keep
+        // in registers.
+        const int strip = 7;
+        Var ci("ci"), io("io"), ii("ii");
+        out.compute_root()
+            .split(c, co, ci, kOutputBlock)
+            .split(i, io, ii, strip)
+            .reorder(ci, ii, co, io, j)
+            .vectorize(ci)
+            .parallel(j);
+        for (Tensor conv : convs) {
+            conv.accum.compute_at(out, co)
+                .vectorize(c)
+                .unroll(i);
+            std::vector<Halide::VarOrRVar> order{c, i};
+            for (const RVar &r : conv.accum.rvars()) {
+                order.push_back(r);
+            }
+            order.push_back(j);
+            order.push_back(co);
+            conv.accum.update()
+                .reorder(order)
+                .vectorize(c)
+                .unroll(i);
+        }
+    }
+
     Func pad(Func f, Expr width, Expr height) {
         Halide::Region bounds(f.dimensions());
         bounds[1].min = 0;
@@ -259,12 +307,19 @@ private:
         } else {
             padded = input.f;
         }
-        RDom r(0, input.shape[0], 0, weight_shape.w, 0, weight_shape.h);
+        // The reduction walks the packed weights sequentially: input
+        // channels within a block, then the kernel window, then the blocks.
+        int in_block = input_block(input.shape[0]);
+        RDom r(0, in_block, 0, weight_shape.w, 0, weight_shape.h, 0, input.shape[0] / in_block);
+        Expr in_c = r.w * in_block + r.x;
+        Func accum;
+        accum(c, i, j, co) += weights(c, r.x, r.y, r.z, r.w, co) * padded(in_c, weight_shape.stride * i + r.y - p, weight_shape.stride * j + r.z - p);
         Func conv;
-        conv(c, i, j) += weights(c, r.y, r.z, r.x) * padded(r.x, weight_shape.stride * i + r.y - p, weight_shape.stride * j + r.z - p);
+        conv(c, i, j) = accum(c % kOutputBlock, i, j, c / kOutputBlock);
 
         Tensor output;
         output.f = conv;
+        output.accum = accum;
         output.name = name;
         output.shape = compute_shape(input, weight_shape);
         return output;
@@ -378,6 +433,29 @@ private:
         return output;
     }
 };
+
+// Repacks conv weights once, at load time, from the (o, x, y, i) layout
+// that load_weights.py writes into the (o % 8, i % ib, x, y, i / ib, o / 8)
+// layout consumed by Resnet50Generator, where ib is input_block(i).
+class Resnet50PackWeightsGenerator : public Halide::Generator<Resnet50PackWeightsGenerator> {
+public:
+    Input<Buffer<float>> weights{"weights", 4};
+    Output<Buffer<float>> packed{"packed", 6};
+
+    void generate() {
+        Var oi("oi"), ii("ii"), x("x"), y("y"), io("io"), oo("oo");
+
+        Expr in_channels = weights.dim(3).extent();
+        Expr in_block = select(in_channels % 8 == 0, 8, in_channels);
+        packed(oi, ii, x, y, io, oo) =
+            weights(oo * kOutputBlock + oi, x, y, io * in_block + ii);
+
+        packed.dim(0).set_bounds(0, kOutputBlock);
+        packed.vectorize(oi).parallel(oo);
+    }
+};
+
 }  //namespace
 
 HALIDE_REGISTER_GENERATOR(Resnet50Generator, resnet50)
+HALIDE_REGISTER_GENERATOR(Resnet50PackWeightsGenerator, resnet50_pack_weights)
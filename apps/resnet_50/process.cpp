@@ -1,6 +1,7 @@
 #include "halide_benchmark.h"
 
 #include "resnet50.h"
+#include "resnet50_pack_weights.h"
 
 #include "HalideBuffer.h"
 #include "halide_image_io.h"
@@ -75,6 +76,18 @@ Buffer<float> load_conv_params(std::string shapefile, std::string datafile) {
     return load_buffer_from_file(datafile, shape);
 }
 
+// Repack conv weights into the blocked layout that resnet50 expects. This
+// happens once, at load time, rather than on every inference.
+Buffer<float> pack_conv_weights(Buffer<float> &weights) {
+    const int out_channels = weights.dim(0).extent();
+    const int in_channels = weights.dim(3).extent();
+    const int in_block = in_channels % 8 == 0 ? 8 : in_channels;
+    Buffer<float> packed(8, in_block, weights.dim(1).extent(), weights.dim(2).extent(),
+                         in_channels / in_block, out_channels / 8);
+    resnet50_pack_weights(weights, packed);
+    return packed;
+}
+
 Buffer<float> load_batch_norm_params(std::string shapefile, std::string datafile) {
     std::vector<int> shape = load_shape(shapefile);
     assert(shape.size());
@@ -94,14 +107,15 @@ Buffer<float> load_fc_bias(std::string shapefile, std::string datafile) {
 }
 
 int main(int argc, char **argv) {
-    if (argc < 3) {
-        printf("Usage: iterations weight_dir seed output_file");
+    if (argc < 5) {
+        printf("Usage: iterations weight_dir seed output_file [batch_size]");
         return -1;
     }
     int iterations = atoi(argv[1]);
     std::string weight_dir = argv[2];
     int seed = atoi(argv[3]);
     std::string output_file = argv[4];
+    int batch_size = argc > 5 ? atoi(argv[5]) : 8;
 
     Buffer<float> input(3, 224, 224);
     Buffer<float> output(1000);
@@ -239,13 +253,21 @@ int main(int argc, char **argv) {
     Buffer<float> fc1000_weights = load_fc_weight(weight_shapefile, weight_datafile);
     Buffer<float> fc1000_bias = load_fc_bias(bias_shapefile, bias_datafile);
 
-    std::mt19937 e2(seed);
-    input.for_each_value([&e2](float &v) {
-        v = e2() / (float)e2.max();
+    double pack_time = benchmark(1, 1, [&]() {
+        conv1_weights = pack_conv_weights(conv1_weights);
+        for (int i = 0; i < 4; i++) {
+            br1_conv_weights[i] = pack_conv_weights(br1_conv_weights[i]);
+        }
+        for (int i = 0; i < 16; i++) {
+            br2a_conv_weights[i] = pack_conv_weights(br2a_conv_weights[i]);
+            br2b_conv_weights[i] = pack_conv_weights(br2b_conv_weights[i]);
+            br2c_conv_weights[i] = pack_conv_weights(br2c_conv_weights[i]);
+        }
     });
-    printf("Running Resnet50 for %d iterations....\n", iterations);
-    double best = benchmark(iterations, 1, [&]() {
-        resnet50(input,
+    printf("Weight prepacking (once per load): %gms\n", pack_time * 1e3);
+
+    auto run = [&](Buffer<float> &in, Buffer<float> &out) {
+        resnet50(in,
                  conv1_gamma,
                  unroll_array_of_4_buffers(br1_gamma),
                  unroll_array_of_16_buffers(br2a_gamma),
@@ -273,14 +295,39 @@ int main(int argc, char **argv) {
                  unroll_array_of_16_buffers(br2c_conv_weights),
                  fc1000_weights,
                  fc1000_bias,
-                 output);
+                 out);
+    };
+
+    std::mt19937 e2(seed);
+    input.for_each_value([&e2](float &v) {
+        v = e2() / (float)e2.max();
+    });
+    printf("Running Resnet50 for %d iterations....\n", iterations);
+    double best = benchmark(iterations, 1, [&]() {
+        run(input, output);
     });
-    printf("*************************** Please note ******************************\n"
-           "This code hasn't been scheduled properly yet so this runtime \n"
-           "isn't representative of anything and should not be used as a basis\n"
-           "for any comparisons.\n");
-    printf("Execution time : %gms \n", best * 1e3);
-    printf("**********************************************************************\n");
+    printf("Single image latency: %gms\n", best * 1e3);
+
+    // Batch throughput: images run back to back against the same (already
+    // packed, and by now cache-warm) weights.
+    if (batch_size > 0) {
+        std::vector<Buffer<float>> batch_inputs, batch_outputs;
+        for (int b = 0; b < batch_size; b++) {
+            Buffer<float> in(3, 224, 224);
+            in.for_each_value([&e2](float &v) {
+                v = e2() / (float)e2.max();
+            });
+            batch_inputs.push_back(in);
+            batch_outputs.emplace_back(1000);
+        }
+        double batch_time = benchmark(iterations, 1, [&]() {
+            for (int b = 0; b < batch_size; b++) {
+                run(batch_inputs[b], batch_outputs[b]);
+            }
+        });
+        printf("Batch throughput: %g images/s (batch of %d, %gms per batch)\n",
+               batch_size / batch_time, batch_size, batch_time * 1e3);
+    }
 
     float max_class_val = -FLT_MIN;
     int max_class = 0;
@@ -210,6 +210,7 @@ function(halide_library_from_generator BASENAME)
   set(c_header_ext ".h")
   set(featurization_ext ".featurization")
   set(llvm_assembly_ext ".ll")
+  set(loop_nest_report_ext ".loop_nest.json")
   set(object_ext ${CMAKE_C_OUTPUT_EXTENSION})
   set(python_extension_ext ".py.cpp")
   set(pytorch_wrapper_ext ".pytorch.h")
@@ -515,6 +516,8 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         wasm_signext
         sve
         sve2
+        arena_allocation
+        param_profile
       )
     # Synthesize a one-or-two-char abbreviation based on the feature's position
     # in the KNOWN_FEATURES list.
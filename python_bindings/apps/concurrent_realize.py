@@ -0,0 +1,85 @@
+"""
+Runs several independent Halide pipelines from a Python thread pool.
+
+Func.realize, Pipeline.realize and compile_jit release the GIL while Halide
+compiles or runs, so pipelines driven from different Python threads overlap.
+This compares the throughput of N serial realizations against the same N
+realizations spread over a ThreadPoolExecutor.
+"""
+
+import halide as hl
+
+import numpy as np
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+W, H = 1536, 1024
+NUM_THREADS = 4
+ITERATIONS = 8
+
+
+def get_blur(seed):
+    x, y = hl.Var("x"), hl.Var("y")
+
+    input = hl.Func("input_%d" % seed)
+    input[x, y] = hl.u16((x * 7 + y * 13 + seed) % 256)
+
+    blur_x = hl.Func("blur_x_%d" % seed)
+    blur_y = hl.Func("blur_y_%d" % seed)
+
+    blur_x[x, y] = (input[x, y] + input[x + 1, y] + input[x + 2, y]) / 3
+    blur_y[x, y] = hl.u8((blur_x[x, y] + blur_x[x, y + 1] + blur_x[x, y + 2]) / 3)
+
+    # Deliberately single-threaded inside Halide, so that any speedup comes
+    # from the Python threads overlapping.
+    xi, yi = hl.Var("xi"), hl.Var("yi")
+    blur_y.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8)
+    blur_x.compute_at(blur_y, x).vectorize(x, 8)
+
+    return hl.Pipeline(blur_y)
+
+
+def run(pipeline, output):
+    for _ in range(ITERATIONS):
+        pipeline.realize(output)
+
+
+def main():
+    # Each thread gets its own Pipeline; a single Pipeline should not be
+    # realized from several threads at once.
+    pipelines = [get_blur(i) for i in range(NUM_THREADS)]
+    outputs = [hl.Buffer(hl.UInt(8), [W, H]) for _ in range(NUM_THREADS)]
+
+    # compile_jit also releases the GIL, so compilation overlaps too.
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=NUM_THREADS) as pool:
+        list(pool.map(lambda p: p.compile_jit(), pipelines))
+    print("Concurrent compile_jit of %d pipelines: %.3f s" %
+          (NUM_THREADS, time.perf_counter() - start))
+
+    start = time.perf_counter()
+    for p, out in zip(pipelines, outputs):
+        run(p, out)
+    serial = time.perf_counter() - start
+
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=NUM_THREADS) as pool:
+        list(pool.map(run, pipelines, outputs))
+    threaded = time.perf_counter() - start
+
+    total = NUM_THREADS * ITERATIONS
+    print("Serial:   %.1f realizations/s" % (total / serial))
+    print("Threaded: %.1f realizations/s (%d threads, %.2fx)" %
+          (total / threaded, NUM_THREADS, serial / threaded))
+
+    # All threads must still produce the right answer.
+    for seed, out in enumerate(outputs):
+        result = np.asarray(out)
+        ref = get_blur(seed).realize(W, H)
+        assert np.array_equal(result, np.asarray(ref))
+
+    print("Success!")
+
+
+if __name__ == "__main__":
+    main()
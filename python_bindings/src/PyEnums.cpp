@@ -144,6 +144,8 @@ void define_enums(py::module &m) {
         .value("WasmSignExt", Target::Feature::WasmSignExt)
         .value("SVE", Target::Feature::SVE)
         .value("SVE2", Target::Feature::SVE2)
+        .value("ArenaAllocation", Target::Feature::ArenaAllocation)
+        .value("ParamProfile", Target::Feature::ParamProfile)
         .value("FeatureEnd", Target::Feature::FeatureEnd);
 
     py::enum_<halide_type_code_t>(m, "TypeCode")
@@ -160,6 +162,7 @@ void define_enums(py::module &m) {
         .value("cpp_stub", Output::cpp_stub)
         .value("featurization", Output::featurization)
         .value("llvm_assembly", Output::llvm_assembly)
+        .value("loop_nest_report", Output::loop_nest_report)
         .value("object", Output::object)
         .value("python_extension", Output::python_extension)
         .value("pytorch_wrapper", Output::pytorch_wrapper)
@@ -10,12 +10,17 @@ void halide_python_error(void *, const char *msg) {
 }
 
 void halide_python_print(void *, const char *msg) {
+    // realize() releases the GIL, and this may be called from any of
+    // Halide's thread pool threads.
+    py::gil_scoped_acquire acquire;
     py::print(msg, py::arg("end") = "");
 }
 
 class HalidePythonCompileTimeErrorReporter : public CompileTimeErrorReporter {
 public:
     void warning(const char *msg) {
+        // compile_jit() and realize() release the GIL.
+        py::gil_scoped_acquire acquire;
         py::print(msg, py::arg("end") = "");
     }
 
@@ -119,7 +119,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, Buffer<> buffer, const Target &target, const ParamMap &param_map) -> void {
-                    f.realize(buffer, target);
+                    call_without_gil([&]() { f.realize(buffer, target, param_map); });
                 },
                 py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -127,14 +127,14 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, std::vector<Buffer<>> buffers, const Target &t, const ParamMap &param_map) -> void {
-                    f.realize(Realization(buffers), t);
+                    call_without_gil([&]() { f.realize(Realization(buffers), t, param_map); });
                 },
                 py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             .def(
                 "realize",
                 [](Func &f, std::vector<int32_t> sizes, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(f.realize(sizes, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return f.realize(sizes, target, param_map); }));
                 },
                 py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -142,7 +142,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(f.realize(x_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return f.realize(x_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -150,7 +150,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return f.realize(x_size, y_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -158,7 +158,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, int z_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, z_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return f.realize(x_size, y_size, z_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -166,7 +166,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, int z_size, int w_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, z_size, w_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return f.realize(x_size, y_size, z_size, w_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
@@ -203,6 +203,7 @@ void define_func(py::module &m) {
             .def("store_root", &Func::store_root)
 
             .def("store_in", &Func::store_in, py::arg("memory_type"))
+            .def("store_per_parallel_task", &Func::store_per_parallel_task)
 
             .def("compile_to", &Func::compile_to, py::arg("outputs"), py::arg("arguments"), py::arg("fn_name"), py::arg("target") = get_target_from_environment())
 
@@ -233,7 +234,7 @@ void define_func(py::module &m) {
             // TODO: useless until Module is defined.
             .def("compile_to_module", &Func::compile_to_module, py::arg("arguments"), py::arg("fn_name") = "", py::arg("target") = get_target_from_environment())
 
-            .def("compile_jit", &Func::compile_jit, py::arg("target") = get_jit_target_from_environment())
+            .def("compile_jit", &Func::compile_jit, py::arg("target") = get_jit_target_from_environment(), py::call_guard<py::gil_scoped_release>())
 
             .def("has_update_definition", &Func::has_update_definition)
             .def("num_update_definitions", &Func::num_update_definitions)
@@ -272,17 +273,17 @@ void define_func(py::module &m) {
             .def("output_buffer", &Func::output_buffer)
             .def("output_buffers", &Func::output_buffers)
 
-            .def("infer_input_bounds", (void (Func::*)(int, int, int, int, const ParamMap &)) & Func::infer_input_bounds, py::arg("x_size") = 0, py::arg("y_size") = 0, py::arg("z_size") = 0, py::arg("w_size") = 0, py::arg("param_map") = ParamMap())
+            .def("infer_input_bounds", (void (Func::*)(int, int, int, int, const ParamMap &)) & Func::infer_input_bounds, py::arg("x_size") = 0, py::arg("y_size") = 0, py::arg("z_size") = 0, py::arg("w_size") = 0, py::arg("param_map") = ParamMap(), py::call_guard<py::gil_scoped_release>())
 
             .def(
                 "infer_input_bounds", [](Func &f, Buffer<> buffer, const ParamMap &param_map) -> void {
-                    f.infer_input_bounds(buffer, param_map);
+                    call_without_gil([&]() { f.infer_input_bounds(buffer, param_map); });
                 },
                 py::arg("dst"), py::arg("param_map") = ParamMap())
 
             .def(
                 "infer_input_bounds", [](Func &f, std::vector<Buffer<>> buffer, const ParamMap &param_map) -> void {
-                    f.infer_input_bounds(Realization(buffer), param_map);
+                    call_without_gil([&]() { f.infer_input_bounds(Realization(buffer), param_map); });
                 },
                 py::arg("dst"), py::arg("param_map") = ParamMap())
 
@@ -32,6 +32,16 @@ std::vector<T> args_to_vector(const py::args &args, size_t start_offset = 0, siz
     return v;
 }
 
+// Run f() with the GIL released, so that other Python threads can make
+// progress while Halide compiles or runs a pipeline. Anything reached from
+// inside f() that touches Python objects must reacquire the GIL first
+// (see the print and error handlers in PyError.cpp).
+template<typename F>
+auto call_without_gil(F &&f) -> decltype(f()) {
+    py::gil_scoped_release release;
+    return f();
+}
+
 }  // namespace PythonBindings
 }  // namespace Halide
 
@@ -88,69 +88,69 @@ void define_pipeline(py::module &m) {
             .def("compile_to_module", &Pipeline::compile_to_module,
                  py::arg("arguments"), py::arg("fn_name"), py::arg("target") = get_target_from_environment(), py::arg("linkage") = LinkageType::ExternalPlusMetadata)
 
-            .def("compile_jit", &Pipeline::compile_jit, py::arg("target") = get_jit_target_from_environment())
+            .def("compile_jit", &Pipeline::compile_jit, py::arg("target") = get_jit_target_from_environment(), py::call_guard<py::gil_scoped_release>())
 
             .def(
                 "realize", [](Pipeline &p, Buffer<> buffer, const Target &target, const ParamMap &param_map) -> void {
-                    p.realize(Realization(buffer), target);
+                    call_without_gil([&]() { p.realize(Realization(buffer), target, param_map); });
                 },
                 py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             // This will actually allow a list-of-buffers as well as a tuple-of-buffers, but that's OK.
             .def(
                 "realize", [](Pipeline &p, std::vector<Buffer<>> buffers, const Target &t, const ParamMap &param_map) -> void {
-                    p.realize(Realization(buffers), t);
+                    call_without_gil([&]() { p.realize(Realization(buffers), t, param_map); });
                 },
                 py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             .def(
                 "realize", [](Pipeline &p, std::vector<int32_t> sizes, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(p.realize(sizes, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return p.realize(sizes, target, param_map); }));
                 },
                 py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(p.realize(x_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return p.realize(x_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return p.realize(x_size, y_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, int z_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, z_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return p.realize(x_size, y_size, z_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, int z_size, int w_size, const Target &target, const ParamMap &param_map) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, z_size, w_size, target, param_map));
+                    return realization_to_object(call_without_gil([&]() { return p.realize(x_size, y_size, z_size, w_size, target, param_map); }));
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
             .def(
                 "infer_input_bounds", [](Pipeline &p, int x_size, int y_size, int z_size, int w_size, const ParamMap &param_map) -> void {
-                    p.infer_input_bounds(x_size, y_size, z_size, w_size, param_map);
+                    call_without_gil([&]() { p.infer_input_bounds(x_size, y_size, z_size, w_size, param_map); });
                 },
                 py::arg("x_size") = 0, py::arg("y_size") = 0, py::arg("z_size") = 0, py::arg("w_size") = 0, py::arg("param_map") = ParamMap())
 
             .def(
                 "infer_input_bounds", [](Pipeline &p, Buffer<> buffer, const ParamMap &param_map) -> void {
-                    p.infer_input_bounds(Realization(buffer), param_map);
+                    call_without_gil([&]() { p.infer_input_bounds(Realization(buffer), param_map); });
                 },
                 py::arg("dst"), py::arg("param_map") = ParamMap())
             .def(
                 "infer_input_bounds", [](Pipeline &p, std::vector<Buffer<>> buffers, const ParamMap &param_map) -> void {
-                    p.infer_input_bounds(Realization(buffers), param_map);
+                    call_without_gil([&]() { p.infer_input_bounds(Realization(buffers), param_map); });
                 },
                 py::arg("dst"), py::arg("param_map") = ParamMap())
 
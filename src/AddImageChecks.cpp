@@ -576,24 +576,36 @@ Stmt add_image_checks(Stmt s,
         }
     }
 
-    // Inject the code that checks the host pointers.
+    // Gather all the checks done on every call, in the order they
+    // should be checked, into a single contiguous sequence of
+    // asserts. Codegen checks a sequence like this with one branch,
+    // and only works out which check failed on the cold path.
+    vector<Stmt> checks;
     if (!no_asserts) {
-        for (size_t i = asserts_host_non_null.size(); i > 0; i--) {
-            s = Block::make(asserts_host_non_null[i - 1], s);
-        }
-        for (size_t i = asserts_host_alignment.size(); i > 0; i--) {
-            s = Block::make(asserts_host_alignment[i - 1], s);
-        }
+        // The checks that elem_sizes are ok.
+        checks.insert(checks.end(), asserts_type_checks.begin(), asserts_type_checks.end());
+        // The checks for out-of-bounds access to the buffers.
+        checks.insert(checks.end(), asserts_required.begin(), asserts_required.end());
     }
-    // Inject the code that checks that no dimension math overflows
+
+    // The checks that the constraints are correct. We need these
+    // regardless of how NoAsserts is set, because they are what gets
+    // Halide to actually exploit the constraint.
+    checks.insert(checks.end(), asserts_constrained.begin(), asserts_constrained.end());
+
+    // The remaining checks see the constrained versions of the vars,
+    // like the rest of the program.
     if (!no_asserts) {
-        for (size_t i = dims_no_overflow_asserts.size(); i > 0; i--) {
-            s = Block::make(dims_no_overflow_asserts[i - 1], s);
+        // The checks that no dimension math overflows.
+        for (const Stmt &a : dims_no_overflow_asserts) {
+            checks.push_back(substitute(replace_with_constrained, a));
         }
-
-        // Inject the code that defines the proposed sizes.
-        for (size_t i = lets_overflow.size(); i > 0; i--) {
-            s = LetStmt::make(lets_overflow[i - 1].first, lets_overflow[i - 1].second, s);
+        // The checks of the host pointers.
+        for (const Stmt &a : asserts_host_alignment) {
+            checks.push_back(substitute(replace_with_constrained, a));
+        }
+        for (const Stmt &a : asserts_host_non_null) {
+            checks.push_back(substitute(replace_with_constrained, a));
         }
     }
 
@@ -607,22 +619,17 @@ Stmt add_image_checks(Stmt s,
     // all in reverse order compared to execution, as we incrementally
     // prepending code.
 
-    // Inject the code that checks the constraints are correct. We
-    // need these regardless of how NoAsserts is set, because they are
-    // what gets Halide to actually exploit the constraint.
-    for (size_t i = asserts_constrained.size(); i > 0; i--) {
-        s = Block::make(asserts_constrained[i - 1], s);
+    for (size_t i = checks.size(); i > 0; i--) {
+        s = Block::make(checks[i - 1], s);
     }
 
+    // Inject the code that defines the total extents used by the
+    // overflow checks. These go outside all the checks, so that they
+    // don't split up the sequence of asserts.
     if (!no_asserts) {
-        // Inject the code that checks for out-of-bounds access to the buffers.
-        for (size_t i = asserts_required.size(); i > 0; i--) {
-            s = Block::make(asserts_required[i - 1], s);
-        }
-
-        // Inject the code that checks that elem_sizes are ok.
-        for (size_t i = asserts_type_checks.size(); i > 0; i--) {
-            s = Block::make(asserts_type_checks[i - 1], s);
+        for (size_t i = lets_overflow.size(); i > 0; i--) {
+            Expr value = substitute(replace_with_constrained, lets_overflow[i - 1].second);
+            s = LetStmt::make(lets_overflow[i - 1].first, value, s);
         }
     }
 
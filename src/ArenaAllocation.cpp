@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "ArenaAllocation.h"
+#include "Bounds.h"
+#include "CodeGen_Internal.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Offsets into an arena are rounded up to this many bytes, which is
+// at least the widest native vector on any target, so that
+// allocations in the arena are as aligned as the arena itself.
+const int arena_alignment = 128;
+
+bool is_host_loop(const For *op) {
+    return ((op->device_api == DeviceAPI::None ||
+             op->device_api == DeviceAPI::Host) &&
+            op->for_type != ForType::GPUBlock &&
+            op->for_type != ForType::GPUThread &&
+            op->for_type != ForType::GPULane);
+}
+
+// Checks whether an expression depends on the contents of memory,
+// or on anything else that can change as the pipeline runs.
+class DependsOnData : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *op) override {
+        result = true;
+    }
+
+    void visit(const Call *op) override {
+        if (!op->is_pure() ||
+            op->call_type == Call::Image ||
+            op->call_type == Call::Halide) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result = false;
+};
+
+bool depends_on_data(const Expr &e) {
+    DependsOnData d;
+    e.accept(&d);
+    return d.result;
+}
+
+// Checks whether a Stmt contains any allocations.
+class ContainsAllocate : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) override {
+        result = true;
+    }
+
+public:
+    bool result = false;
+};
+
+bool contains_allocate(const Stmt &s) {
+    ContainsAllocate c;
+    s.accept(&c);
+    return c.result;
+}
+
+// Each allocation we're going to place in an arena.
+struct ArenaEntry {
+    string name;
+    // An upper bound on the size in bytes, which can be evaluated at
+    // the start of the arena's scope.
+    Expr size;
+    // The live range, in program order.
+    int begin, end;
+    // Whether it's inside a serial loop in the scope, and so would
+    // otherwise be allocated once per iteration.
+    bool in_loop;
+    // The name of the variable holding the offset into the arena,
+    // and its value.
+    string offset;
+    Expr offset_value;
+};
+
+// Walk one scope (a pipeline or the body of a parallel loop) in
+// program order, finding the allocations that can be placed in an
+// arena, their live ranges, and bounds on their sizes. Parallel and
+// device loops are separate scopes, so we don't enter them.
+class FindArenaEntries : public IRVisitor {
+public:
+    vector<ArenaEntry> entries;
+
+private:
+    using IRVisitor::visit;
+
+    int position = 0;
+    int loop_depth = 0;
+
+    // Bounds of the lets and loop variables defined inside the
+    // scope, in terms of things defined outside of it.
+    Scope<Interval> bounds;
+    Scope<> defined_inside;
+
+    // Allocations that can't go in the arena. If an allocation of
+    // the same name appears more than once (e.g. in different
+    // specializations), all of them have to be candidates.
+    std::set<string> rejected;
+
+    // Index into entries of each allocation currently live.
+    map<string, int> live;
+
+    Interval bounds_of_inside(const Expr &e) {
+        Interval b = bounds_of_expr_in_scope(e, bounds);
+        if (b.has_lower_bound()) {
+            b.min = simplify(b.min);
+            if (expr_uses_vars(b.min, defined_inside)) {
+                b.min = Interval::neg_inf();
+            }
+        }
+        if (b.has_upper_bound()) {
+            b.max = simplify(b.max);
+            if (expr_uses_vars(b.max, defined_inside)) {
+                b.max = Interval::pos_inf();
+            }
+        }
+        return b;
+    }
+
+    void visit(const LetStmt *op) override {
+        op->value.accept(this);
+        Interval b = bounds_of_inside(op->value);
+        ScopedBinding<Interval> bind(bounds, op->name, b);
+        ScopedBinding<> bind_inside(defined_inside, op->name);
+        op->body.accept(this);
+    }
+
+    void visit(const For *op) override {
+        position++;
+        if (op->for_type == ForType::Parallel || !is_host_loop(op)) {
+            return;
+        }
+        op->min.accept(this);
+        op->extent.accept(this);
+        Interval b = Interval::make_union(bounds_of_inside(op->min),
+                                          bounds_of_inside(op->min + op->extent - 1));
+        ScopedBinding<Interval> bind(bounds, op->name, b);
+        ScopedBinding<> bind_inside(defined_inside, op->name);
+        loop_depth++;
+        op->body.accept(this);
+        loop_depth--;
+        position++;
+    }
+
+    void visit(const Fork *op) override {
+        // Both sides run at the same time, so everything allocated
+        // in either side is live for the duration of the fork.
+        int begin = position++;
+        size_t first_entry = entries.size();
+        op->first.accept(this);
+        op->rest.accept(this);
+        int end = position++;
+        for (size_t i = first_entry; i < entries.size(); i++) {
+            entries[i].begin = std::min(entries[i].begin, begin);
+            entries[i].end = std::max(entries[i].end, end);
+        }
+    }
+
+    Expr size_bound(const Allocate *op) {
+        if (op->new_expr.defined() ||
+            op->extents.empty() ||
+            (op->memory_type != MemoryType::Auto &&
+             op->memory_type != MemoryType::Heap)) {
+            return Expr();
+        }
+
+        int32_t constant_size = op->constant_allocation_size();
+        if (constant_size > 0 &&
+            op->memory_type == MemoryType::Auto &&
+            can_allocation_fit_on_stack((int64_t)constant_size * op->type.bytes())) {
+            // This is going on the stack anyway
+            return Expr();
+        }
+
+        // Include the padding the code generator adds to heap
+        // allocations.
+        Expr size = make_const(Int(64), op->type.bytes());
+        for (const Expr &e : op->extents) {
+            size *= cast<int64_t>(max(e, 0));
+        }
+        size += op->type.bytes();
+
+        // The bound is evaluated before anything in the scope runs, so
+        // it can't depend on anything the scope loads or computes.
+        Interval b = bounds_of_inside(size);
+        if (!b.has_upper_bound() || depends_on_data(b.max)) {
+            return Expr();
+        }
+        return simplify(((b.max + arena_alignment - 1) / arena_alignment) * arena_alignment);
+    }
+
+    void visit(const Allocate *op) override {
+        for (const Expr &e : op->extents) {
+            e.accept(this);
+        }
+        op->condition.accept(this);
+
+        Expr size = size_bound(op);
+        if (!size.defined()) {
+            debug(3) << "Not placing " << op->name << " in an arena\n";
+            rejected.insert(op->name);
+            op->body.accept(this);
+            return;
+        }
+
+        int idx = -1;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].name == op->name) {
+                idx = (int)i;
+            }
+        }
+        position++;
+        if (idx < 0) {
+            idx = (int)entries.size();
+            entries.push_back({op->name, size, position, position, loop_depth > 0, string(), Expr()});
+        } else {
+            entries[idx].size = simplify(max(entries[idx].size, size));
+            entries[idx].in_loop |= loop_depth > 0;
+        }
+
+        auto old_live = live.find(op->name);
+        int old_idx = old_live == live.end() ? -1 : old_live->second;
+        live[op->name] = idx;
+        op->body.accept(this);
+        if (live.count(op->name)) {
+            // There was no early free
+            entries[idx].end = std::max(entries[idx].end, position);
+        }
+        position++;
+        if (old_idx >= 0) {
+            live[op->name] = old_idx;
+        } else {
+            live.erase(op->name);
+        }
+    }
+
+    void visit(const Free *op) override {
+        position++;
+        auto it = live.find(op->name);
+        if (it != live.end()) {
+            ArenaEntry &e = entries[it->second];
+            e.end = std::max(e.end, position);
+            live.erase(it);
+        }
+    }
+
+public:
+    void remove_rejected() {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [&](const ArenaEntry &e) {
+                                         return rejected.count(e.name) > 0;
+                                     }),
+                      entries.end());
+    }
+};
+
+class InjectArenas : public IRMutator {
+    using IRMutator::visit;
+
+    const Target &target;
+
+    // The new_expr for each allocation in the current arena.
+    map<string, Expr> placed;
+
+    // The lets peeled off the tops of the enclosing scopes, innermost
+    // last. Sizes and offsets are compared with these substituted in.
+    vector<std::pair<string, Expr>> outer_lets;
+
+    bool can_prove_le(const Expr &a, const Expr &b) {
+        Expr cond = a <= b;
+        for (auto it = outer_lets.rbegin(); it != outer_lets.rend(); it++) {
+            cond = substitute(it->first, it->second, cond);
+        }
+        return can_prove(cond);
+    }
+
+    Stmt visit(const Allocate *op) override {
+        auto it = placed.find(op->name);
+        if (it == placed.end()) {
+            return IRMutator::visit(op);
+        }
+        Stmt body = mutate(op->body);
+        return Allocate::make(op->name, op->type, op->memory_type, op->extents,
+                              op->condition, body, it->second, "halide_device_host_nop_free");
+    }
+
+    Stmt visit(const For *op) override {
+        if (!is_host_loop(op)) {
+            return op;
+        } else if (op->for_type == ForType::Parallel) {
+            Stmt body = inject_arena(op->body);
+            return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        } else {
+            return IRMutator::visit(op);
+        }
+    }
+
+public:
+    InjectArenas(const Target &t)
+        : target(t) {
+    }
+
+    Stmt inject_arena(const Stmt &s) {
+        // Lets at the top of the scope are defined before the arena
+        const LetStmt *let = s.as<LetStmt>();
+        if (let) {
+            outer_lets.emplace_back(let->name, let->value);
+            Stmt body = inject_arena(let->body);
+            outer_lets.pop_back();
+            return LetStmt::make(let->name, let->value, body);
+        }
+
+        // So are any statements at the top that don't allocate
+        // anything, and the arena goes inside any if without an else
+        // around the rest. At the top of a pipeline, these are the
+        // early return for bounds queries, and the checks on the input
+        // and output buffers. The arena's size must not be computed
+        // from buffers that haven't been checked yet.
+        const Block *block = s.as<Block>();
+        if (block && !contains_allocate(block->first)) {
+            Stmt first;
+            {
+                ScopedValue<map<string, Expr>> old_placed(placed, map<string, Expr>());
+                first = mutate(block->first);
+            }
+            return Block::make(first, inject_arena(block->rest));
+        }
+        const IfThenElse *if_stmt = s.as<IfThenElse>();
+        if (if_stmt && !if_stmt->else_case.defined()) {
+            return IfThenElse::make(if_stmt->condition, inject_arena(if_stmt->then_case));
+        }
+
+        FindArenaEntries finder;
+        s.accept(&finder);
+        finder.remove_rejected();
+        vector<ArenaEntry> &entries = finder.entries;
+
+        if (entries.empty() ||
+            (entries.size() == 1 && !entries[0].in_loop)) {
+            // Nothing to share or hoist. Just look for parallel loops.
+            ScopedValue<map<string, Expr>> old_placed(placed, map<string, Expr>());
+            return mutate(s);
+        }
+
+        string arena_name = unique_name("arena");
+        Expr arena = Variable::make(Handle(), arena_name);
+
+        // Greedily place each allocation at the lowest offset that
+        // provably doesn't overlap anything already placed with an
+        // overlapping live range: either the start of the arena, or
+        // the end of one of those allocations. The sizes are in
+        // general symbolic, so the offsets are too, and if we can't
+        // prove a spot is free we go after all of them.
+        vector<std::pair<string, Expr>> lets;
+        Expr total = make_zero(Int(64));
+        for (size_t i = 0; i < entries.size(); i++) {
+            vector<size_t> overlapping;
+            vector<Expr> candidates = {make_zero(Int(64))};
+            Expr offset = make_zero(Int(64));
+            for (size_t j = 0; j < i; j++) {
+                if (entries[j].begin <= entries[i].end &&
+                    entries[i].begin <= entries[j].end) {
+                    overlapping.push_back(j);
+                    Expr end_j = simplify(entries[j].offset_value + entries[j].size);
+                    candidates.push_back(end_j);
+                    offset = max(offset, end_j);
+                }
+            }
+            for (const Expr &c : candidates) {
+                bool fits = true;
+                for (size_t j : overlapping) {
+                    if (!can_prove_le(c + entries[i].size, entries[j].offset_value) &&
+                        !can_prove_le(entries[j].offset_value + entries[j].size, c)) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) {
+                    offset = c;
+                    break;
+                }
+            }
+            entries[i].offset = arena_name + "." + entries[i].name + ".offset";
+            entries[i].offset_value = simplify(offset);
+            lets.emplace_back(entries[i].offset, entries[i].offset_value);
+            Expr end_i = Variable::make(Int(64), entries[i].offset) + entries[i].size;
+            total = max(total, end_i);
+            debug(3) << "Placing " << entries[i].name << " in " << arena_name
+                     << " at " << lets.back().second
+                     << " with live range [" << entries[i].begin << ", " << entries[i].end << "]\n";
+        }
+
+        map<string, Expr> new_placed;
+        for (const ArenaEntry &e : entries) {
+            Expr ptr = reinterpret(UInt(64), arena) + cast<uint64_t>(Variable::make(Int(64), e.offset));
+            new_placed[e.name] = reinterpret(Handle(), ptr);
+        }
+
+        Stmt body;
+        {
+            ScopedValue<map<string, Expr>> old_placed(placed, new_placed);
+            body = mutate(s);
+        }
+
+        // Allocate the arena in chunks, so that its extent fits in
+        // 32 bits for any size we're willing to allocate.
+        string total_name = arena_name + ".size";
+        Expr total_var = Variable::make(Int(64), total_name);
+        Expr chunks = cast<int32_t>(total_var / arena_alignment);
+        body = Allocate::make(arena_name, UInt(8), MemoryType::Heap,
+                              {chunks, arena_alignment}, const_true(), body);
+
+        int64_t max_size = std::min(target.maximum_buffer_size(),
+                                    (int64_t)arena_alignment * 0x7fffffff);
+        Expr max_size_expr = make_const(Int(64), max_size);
+        Expr error = Call::make(Int(32), "halide_error_buffer_allocation_too_large",
+                                {arena_name, cast<uint64_t>(total_var), cast<uint64_t>(max_size_expr)},
+                                Call::Extern);
+        body = Block::make(AssertStmt::make(total_var <= max_size_expr, error), body);
+        body = LetStmt::make(total_name, simplify(total), body);
+
+        for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+            body = LetStmt::make(it->first, it->second, body);
+        }
+
+        return body;
+    }
+};
+
+}  // namespace
+
+Stmt arena_allocation(const Stmt &s, const Target &t) {
+    return InjectArenas(t).inject_arena(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,29 @@
+#ifndef HALIDE_ARENA_ALLOCATION_H
+#define HALIDE_ARENA_ALLOCATION_H
+
+/** \file
+ * Defines the lowering pass that packs heap allocations into a single
+ * arena per pipeline invocation or per parallel task.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Compute the live ranges of the heap allocations in the pipeline
+ * and in the body of each parallel loop, and give each one an offset
+ * into a single arena allocated once at the start of that scope, so
+ * that allocations whose live ranges don't overlap share
+ * storage. This replaces a halide_malloc per allocation (or per
+ * allocation per loop iteration) with one per scope. Allocations are
+ * only packed if their size can be bounded by an expression that can
+ * be evaluated at the start of the scope. Lowering only runs this
+ * pass if the target has the ArenaAllocation feature. */
+Stmt arena_allocation(const Stmt &s, const Target &t);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
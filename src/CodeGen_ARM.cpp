@@ -1064,5 +1064,61 @@ int CodeGen_ARM::native_vector_bits() const {
     return 128;
 }
 
+bool CodeGen_ARM::supports_float16_conversion() const {
+    // AArch64 always has fcvt between half and single precision.
+    return target.bits == 64;
+}
+
+Value *CodeGen_ARM::interleave_vectors(const vector<Value *> &vecs) {
+    // Interleaving n vectors of n lanes that each fit in a register is
+    // a transpose, which we can do with zip1 and zip2 (vzip on 32-bit
+    // arm).
+    const int n = (int)vecs.size();
+    const int lanes = vecs[0]->getType()->getVectorNumElements();
+    const int row_bits = lanes * vecs[0]->getType()->getScalarSizeInBits();
+    if (!target.has_feature(Target::NoNEON) &&
+        n == lanes && n >= 4 && (n & (n - 1)) == 0 &&
+        (row_bits == 64 || row_bits == 128)) {
+        return concat_vectors(transpose_by_interleaving(vecs, n));
+    }
+    return CodeGen_Posix::interleave_vectors(vecs);
+}
+
+int CodeGen_ARM::max_lookup_table_bytes() const {
+    // tbl looks up tables of up to four 16 byte registers, and vtbl up
+    // to four 8 byte registers.
+    if (target.has_feature(Target::NoNEON)) {
+        return 0;
+    }
+    return target.bits == 64 ? 64 : 32;
+}
+
+Value *CodeGen_ARM::lookup_bytes(Value *table, Value *indices) {
+    const int native_lanes = target.bits == 64 ? 16 : 8;
+    int lanes = indices->getType()->getVectorNumElements();
+    int table_bytes = table->getType()->getVectorNumElements();
+    int registers = (table_bytes + native_lanes - 1) / native_lanes;
+    internal_assert(registers <= 4);
+
+    // The table is passed as a list of registers, followed by the
+    // indices. Out of range indices give zero.
+    vector<Value *> args;
+    for (int i = 0; i < registers; i++) {
+        args.push_back(slice_vector(table, i * native_lanes, native_lanes));
+    }
+    string name = target.bits == 64 ?
+                      "llvm.aarch64.neon.tbl" + std::to_string(registers) + ".v16i8" :
+                      "llvm.arm.neon.vtbl" + std::to_string(registers);
+    llvm::Type *result_type = VectorType::get(i8_t, native_lanes);
+
+    vector<Value *> results;
+    for (int i = 0; i < lanes; i += native_lanes) {
+        args.push_back(slice_vector(indices, i, native_lanes));
+        results.push_back(call_intrin(result_type, native_lanes, name, args));
+        args.pop_back();
+    }
+    return slice_vector(concat_vectors(results), 0, lanes);
+}
+
 }  // namespace Internal
 }  // namespace Halide
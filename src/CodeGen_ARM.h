@@ -65,6 +65,10 @@ protected:
     std::string mattrs() const override;
     bool use_soft_float_abi() const override;
     int native_vector_bits() const override;
+    bool supports_float16_conversion() const override;
+    int max_lookup_table_bytes() const override;
+    llvm::Value *lookup_bytes(llvm::Value *table, llvm::Value *indices) override;
+    llvm::Value *interleave_vectors(const std::vector<llvm::Value *> &) override;
 
     // NEON can be disabled for older processors.
     bool neon_intrinsics_disabled() {
@@ -911,6 +911,24 @@ private:
 
         const char *native_vector_decl = R"INLINE_CODE(
 #if __has_attribute(ext_vector_type) || __has_attribute(vector_size)
+// Native vector comparisons produce lanes of signed integers (0 or -1)
+// with the same width as the operands.
+template <size_t Bytes> struct NativeVectorMaskElement;
+template <> struct NativeVectorMaskElement<1> { typedef int8_t type; };
+template <> struct NativeVectorMaskElement<2> { typedef int16_t type; };
+template <> struct NativeVectorMaskElement<4> { typedef int32_t type; };
+template <> struct NativeVectorMaskElement<8> { typedef int64_t type; };
+
+template <typename T> struct NativeVectorIsInteger { static const bool value = false; };
+template <> struct NativeVectorIsInteger<int8_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<int16_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<int32_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<int64_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<uint8_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<uint16_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<uint32_t> { static const bool value = true; };
+template <> struct NativeVectorIsInteger<uint64_t> { static const bool value = true; };
+
 template <typename ElementType_, size_t Lanes_>
 class NativeVector {
 public:
@@ -918,11 +936,14 @@ public:
     static const size_t Lanes = Lanes_;
     typedef NativeVector<ElementType, Lanes> Vec;
     typedef NativeVector<uint8_t, Lanes> Mask;
+    typedef typename NativeVectorMaskElement<sizeof(ElementType)>::type MaskElementType;
 
 #if __has_attribute(ext_vector_type)
     typedef ElementType_ NativeVectorType __attribute__((ext_vector_type(Lanes), aligned(sizeof(ElementType))));
+    typedef MaskElementType NativeMaskType __attribute__((ext_vector_type(Lanes), aligned(sizeof(ElementType))));
 #elif __has_attribute(vector_size) || __GNUC__
     typedef ElementType_ NativeVectorType __attribute__((vector_size(Lanes * sizeof(ElementType)), aligned(sizeof(ElementType))));
+    typedef MaskElementType NativeMaskType __attribute__((vector_size(Lanes * sizeof(ElementType)), aligned(sizeof(ElementType))));
 #endif
 
     NativeVector &operator=(const Vec &src) {
@@ -992,8 +1013,20 @@ public:
         }
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec shuffle(const Vec &a, const int32_t indices[Lanes]) {
+#if __GNUC__ && !__clang__
+        // GCC can shuffle by a mask held in a vector; the indices are always
+        // literals, so this folds to a single permute. (Clang only offers
+        // __builtin_shufflevector, which needs the indices as template-time
+        // constants, but it recognizes the loop below just as well.)
+        if (sizeof(MaskElementType) > 1 || Lanes <= 128) {
+            NativeMaskType mask;
+            for (size_t i = 0; i < Lanes; i++) {
+                mask[i] = indices[i] < 0 ? 0 : indices[i];
+            }
+            return Vec(from_native_vector, __builtin_shuffle(a.native_vector, mask));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             if (indices[i] < 0) {
@@ -1004,12 +1037,14 @@ public:
         return r;
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     template<size_t InputLanes>
     static Vec concat(size_t count, const NativeVector<ElementType, InputLanes> vecs[]) {
         Vec r(empty);
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = vecs[i / InputLanes][i % InputLanes];
+        // Copy whole input vectors at a time; as with load(), only copy the
+        // lanes in the logical type, since the native type may be padded.
+        for (size_t i = 0; i < count && i * InputLanes < Lanes; i++) {
+            const size_t lanes = (Lanes - i * InputLanes) < InputLanes ? (Lanes - i * InputLanes) : InputLanes;
+            memcpy((ElementType *)&r.native_vector + i * InputLanes, &vecs[i].native_vector, sizeof(ElementType) * lanes);
         }
         return r;
     }
@@ -1156,67 +1191,34 @@ public:
         return r;
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] < b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector < b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] <= b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector <= b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] > b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector > b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] >= b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector >= b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator==(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] == b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector == b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator!=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] != b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return mask_from_native((NativeMaskType)(a.native_vector != b.native_vector));
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec select(const Mask &cond, const Vec &true_value, const Vec &false_value) {
-        Vec r(empty);
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = cond[i] ? true_value[i] : false_value[i];
-        }
-        return r;
+        NativeMaskType mask;
+        native_from_mask(cond, mask);
+        return blend(mask, true_value, false_value);
     }
 
     template <typename OtherVec>
@@ -1231,6 +1233,14 @@ public:
         // (https://github.com/halide/Halide/issues/2080)
         return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
 #else
+#if __has_builtin(__builtin_convertvector)
+        // Integer-to-integer conversions wrap exactly as static_cast does, so
+        // those (unlike float<->int) are safe to do natively.
+        if (NativeVectorIsInteger<ElementType>::value &&
+            NativeVectorIsInteger<typename OtherVec::ElementType>::value) {
+            return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = static_cast<typename Vec::ElementType>(src.native_vector[i]);
@@ -1239,26 +1249,54 @@ public:
 #endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
+    // Same semantics (including for NaN) as ::halide_cpp_max()
     static Vec max(const Vec &a, const Vec &b) {
-        Vec r(empty);
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = ::halide_cpp_max(a[i], b[i]);
-        }
-        return r;
+        return blend((NativeMaskType)(a.native_vector > b.native_vector), a, b);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
+    // Same semantics (including for NaN) as ::halide_cpp_min()
     static Vec min(const Vec &a, const Vec &b) {
-        Vec r(empty);
+        return blend((NativeMaskType)(a.native_vector < b.native_vector), a, b);
+    }
+
+private:
+    template<typename, size_t> friend class NativeVector;
+
+    // Pick lanes from a where mask is all-ones, and from b where it is zero.
+    // Done on the bits so that it works for float lanes too.
+    static Vec blend(const NativeMaskType &mask, const Vec &a, const Vec &b) {
+        const NativeMaskType a_bits = (NativeMaskType)a.native_vector;
+        const NativeMaskType b_bits = (NativeMaskType)b.native_vector;
+        return Vec(from_native_vector, (NativeVectorType)((a_bits & mask) | (b_bits & ~mask)));
+    }
+
+    // Narrow a native comparison result to a Mask (0x00 or 0xff per lane).
+    static Mask mask_from_native(const NativeMaskType &mask) {
+#if __has_builtin(__builtin_convertvector)
+        return Mask(Mask::from_native_vector, __builtin_convertvector(mask, typename Mask::NativeVectorType));
+#else
+        Mask r(Mask::empty);
         for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = ::halide_cpp_min(a[i], b[i]);
+            r.native_vector[i] = mask[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-private:
-    template<typename, size_t> friend class NativeVector;
+    // Widen a Mask to lanes of 0 or -1 of our own width. Any nonzero
+    // Mask lane counts as true, as it does for the scalar select.
+    // (This uses an out-param, as returning a bare native vector by value
+    // draws ABI warnings from GCC.)
+    static void native_from_mask(const Mask &cond, NativeMaskType &mask) {
+#if __has_builtin(__builtin_convertvector)
+        typedef typename Mask::NativeMaskType NativeMask8;
+        mask = __builtin_convertvector((NativeMask8)(cond.native_vector != 0), NativeMaskType);
+#else
+        for (size_t i = 0; i < Lanes; i++) {
+            mask[i] = cond[i] ? -1 : 0;
+        }
+#endif
+    }
 
     template <typename ElementType, typename OtherElementType, size_t Lanes>
     friend NativeVector<ElementType, Lanes> operator<<(
@@ -2791,6 +2829,16 @@ void CodeGen_C::visit(const Prefetch *op) {
 }
 
 void CodeGen_C::visit(const IfThenElse *op) {
+    const Call *c = op->condition.as<Call>();
+    if (c && c->is_intrinsic(Call::has_target_features)) {
+        // Everything we emit is compiled with the same flags, so
+        // there's nothing to gain from the multiversioned loop
+        // nest. Just use the one for the base target.
+        internal_assert(op->else_case.defined());
+        op->else_case.accept(this);
+        return;
+    }
+
     string cond_id = print_expr(op->condition);
 
     stream << get_indent() << "if (" << cond_id << ")\n";
@@ -19,6 +19,7 @@
 #include "Deinterleave.h"
 #include "EmulateFloat16Math.h"
 #include "ExprUsesVar.h"
+#include "IREquality.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
 #include "IntegerDivisionTable.h"
@@ -27,8 +28,11 @@
 #include "LLVM_Runtime_Linker.h"
 #include "Lerp.h"
 #include "MatlabWrapper.h"
+#include "Multiversion.h"
+#include "OptimizeShuffles.h"
 #include "Pipeline.h"
 #include "Simplify.h"
+#include "Substitute.h"
 #include "Util.h"
 
 #if !(__cplusplus > 199711L || _MSC_VER >= 1800)
@@ -280,7 +284,8 @@ CodeGen_LLVM::CodeGen_LLVM(Target t)
       emit_atomic_stores(false),
 
       destructor_block(nullptr),
-      strict_float(t.has_feature(Target::StrictFloat)) {
+      strict_float(t.has_feature(Target::StrictFloat)),
+      in_multiversion(false) {
     initialize_llvm();
 }
 
@@ -628,6 +633,16 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
 
     add_external_code(input);
 
+    // Loop nests multiversioned for more CPU features may need
+    // support code that the initial module for the target lacks.
+    Target multiversion_features = target;
+    for (const auto &f : input.functions()) {
+        multiversion_features = all_multiversion_features(f.body, multiversion_features);
+    }
+    if (multiversion_features != target) {
+        add_feature_initmods_to_module(*module, target, multiversion_features);
+    }
+
     // Generate the code for this module.
     debug(1) << "Generating llvm bitcode...\n";
     for (const auto &b : input.buffers()) {
@@ -784,9 +799,21 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f, const std::string &simple_
         }
     }
 
+    // Targets without float16 arithmetic do it in float32. Widen whole
+    // expression trees at once, instead of rounding after every op.
+    Stmt body = f.body;
+    if (!strict_float && upgrade_type_for_arithmetic(Float(16)) != Float(16)) {
+        body = widen_float16_arithmetic(body);
+    }
+
+    // Gathers from small tables can be done with in-register lookups.
+    if (max_lookup_table_bytes() > 0) {
+        body = optimize_shuffles(body, 0, max_lookup_table_bytes());
+    }
+
     // Generate the function body.
     debug(1) << "Generating llvm bitcode for function " << f.name << "...\n";
-    f.body.accept(this);
+    body.accept(this);
 
     // Clean up and return.
     end_func(f.args);
@@ -1505,6 +1532,25 @@ Type CodeGen_LLVM::upgrade_type_for_argument_passing(const Type &t) const {
     }
 }
 
+bool CodeGen_LLVM::supports_float16_conversion() const {
+    return false;
+}
+
+int CodeGen_LLVM::max_lookup_table_bytes() const {
+    return 0;
+}
+
+Value *CodeGen_LLVM::lookup_bytes(Value *table, Value *indices) {
+    int lanes = indices->getType()->getVectorNumElements();
+    Value *result = UndefValue::get(indices->getType());
+    for (int i = 0; i < lanes; i++) {
+        Value *lane = ConstantInt::get(i32_t, i);
+        Value *idx = builder->CreateZExt(builder->CreateExtractElement(indices, lane), i32_t);
+        result = builder->CreateInsertElement(result, builder->CreateExtractElement(table, idx), lane);
+    }
+    return result;
+}
+
 Type CodeGen_LLVM::upgrade_type_for_storage(const Type &t) const {
     if (t.is_bfloat() || (t.is_float() && t.bits() < 32)) {
         return t.with_code(halide_type_uint);
@@ -1546,6 +1592,27 @@ void CodeGen_LLVM::visit(const Cast *op) {
     if (upgrade_type_for_arithmetic(src) != src ||
         upgrade_type_for_arithmetic(dst) != dst) {
         // Handle casts to and from types for which we don't have native support.
+        Type f32 = Float(32, dst.lanes());
+        bool src_f16 = src.is_float() && !src.is_bfloat() && src.bits() == 16;
+        bool dst_f16 = dst.is_float() && !dst.is_bfloat() && dst.bits() == 16;
+        if (supports_float16_conversion() &&
+            (src_f16 || dst_f16) && !src.is_bfloat() && !dst.is_bfloat()) {
+            // Convert to or from float32 with the native instructions,
+            // and do the rest of the cast in float32.
+            if (src_f16) {
+                value = builder->CreateFPExt(codegen(op->value), llvm_type_of(f32));
+                if (dst != f32) {
+                    std::string name = unique_name('t');
+                    sym_push(name, value);
+                    codegen(cast(dst, Variable::make(f32, name)));
+                    sym_pop(name);
+                }
+            } else {
+                value = builder->CreateFPTrunc(codegen(cast(f32, op->value)), llvm_type_of(dst));
+            }
+            return;
+        }
+
         debug(4) << "Emulating cast from " << src << " to " << dst << "\n";
         if ((src.is_float() && src.bits() < 32) ||
             (dst.is_float() && dst.bits() < 32)) {
@@ -2263,6 +2330,37 @@ Value *CodeGen_LLVM::interleave_vectors(const std::vector<Value *> &vecs) {
     }
 }
 
+vector<Value *> CodeGen_LLVM::transpose_by_interleaving(const vector<Value *> &rows, int block_lanes) {
+    const int n = (int)rows.size();
+    internal_assert(n == block_lanes && (n & (n - 1)) == 0);
+    const int lanes = rows[0]->getType()->getVectorNumElements();
+
+    // Interleave the low or high halves of each block of two rows.
+    vector<int> lo(lanes), hi(lanes);
+    for (int b = 0; b < lanes; b += n) {
+        for (int i = 0; i < n / 2; i++) {
+            lo[b + 2 * i] = b + i;
+            lo[b + 2 * i + 1] = b + i + lanes;
+            hi[b + 2 * i] = b + i + n / 2;
+            hi[b + 2 * i + 1] = b + i + n / 2 + lanes;
+        }
+    }
+
+    // Row i of the first half and row i of the second half become
+    // rows 2i and 2i + 1. After log2(n) rounds, each row has been
+    // interleaved with every other row.
+    vector<Value *> result = rows;
+    for (int round = 1; round < n; round *= 2) {
+        vector<Value *> next(n);
+        for (int i = 0; i < n / 2; i++) {
+            next[2 * i] = shuffle_vectors(result[i], result[i + n / 2], lo);
+            next[2 * i + 1] = shuffle_vectors(result[i], result[i + n / 2], hi);
+        }
+        result.swap(next);
+    }
+    return result;
+}
+
 void CodeGen_LLVM::scalarize(Expr e) {
     llvm::Type *result_type = llvm_type_of(e.type());
 
@@ -2471,8 +2569,7 @@ void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
 
     // Detect whether we can describe this as an atomic-read-modify-write,
     // otherwise fallback to a compare-and-swap loop.
-    // Currently we only test for atomicAdd.
-    Expr val_expr = op->value;
+    // Currently we test for atomicAdd, and for atomicMin/atomicMax on integers.
     Halide::Type value_type = op->value.type();
     // For atomicAdd, we check if op->value - store[index] is independent of store.
     // For llvm version < 9, the atomicRMW operations only support integers so we also check that.
@@ -2483,23 +2580,43 @@ void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
                                  op->predicate,
                                  op->alignment);
     Expr delta = simplify(common_subexpression_elimination(op->value - equiv_load));
-    bool is_atomic_add = supports_atomic_add(value_type) && !expr_uses_var(delta, op->name);
-    if (is_atomic_add) {
+    bool is_atomic_rmw = supports_atomic_add(value_type) && !expr_uses_var(delta, op->name);
+    AtomicRMWInst::BinOp rmw_op = AtomicRMWInst::Add;
+#if LLVM_VERSION >= 90
+    if (value_type.is_float()) {
+        rmw_op = AtomicRMWInst::FAdd;
+    }
+#endif
+    if (!is_atomic_rmw && value_type.is_int_or_uint()) {
+        // For atomicMin/atomicMax, we check if op->value is the
+        // min/max of store[index] and something independent of store.
+        Expr a, b;
+        if (const Min *m = op->value.as<Min>()) {
+            a = m->a;
+            b = m->b;
+            rmw_op = value_type.is_int() ? AtomicRMWInst::Min : AtomicRMWInst::UMin;
+        } else if (const Max *m = op->value.as<Max>()) {
+            a = m->a;
+            b = m->b;
+            rmw_op = value_type.is_int() ? AtomicRMWInst::Max : AtomicRMWInst::UMax;
+        }
+        if (a.defined()) {
+            if (graph_equal(a, equiv_load) && !expr_uses_var(b, op->name)) {
+                delta = b;
+                is_atomic_rmw = true;
+            } else if (graph_equal(b, equiv_load) && !expr_uses_var(a, op->name)) {
+                delta = a;
+                is_atomic_rmw = true;
+            }
+        }
+    }
+    if (is_atomic_rmw) {
         Value *val = codegen(delta);
         if (value_type.is_scalar()) {
             Value *ptr = codegen_buffer_pointer(op->name,
                                                 op->value.type(),
                                                 op->index);
-            // llvm 9 has FAdd which can be used for atomic floats.
-#if LLVM_VERSION >= 90
-            if (value_type.is_float()) {
-                builder->CreateAtomicRMW(AtomicRMWInst::FAdd, ptr, val, AtomicOrdering::Monotonic);
-            } else {
-                builder->CreateAtomicRMW(AtomicRMWInst::Add, ptr, val, AtomicOrdering::Monotonic);
-            }
-#else
-            builder->CreateAtomicRMW(AtomicRMWInst::Add, ptr, val, AtomicOrdering::Monotonic);
-#endif
+            builder->CreateAtomicRMW(rmw_op, ptr, val, AtomicOrdering::Monotonic);
         } else {
             Value *index = codegen(op->index);
             // Scalarize vector store.
@@ -2508,15 +2625,7 @@ void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
                 Value *idx = builder->CreateExtractElement(index, lane);
                 Value *v = builder->CreateExtractElement(val, lane);
                 Value *ptr = codegen_buffer_pointer(op->name, value_type.element_of(), idx);
-#if LLVM_VERSION >= 90
-                if (value_type.is_float()) {
-                    builder->CreateAtomicRMW(AtomicRMWInst::FAdd, ptr, v, AtomicOrdering::Monotonic);
-                } else {
-                    builder->CreateAtomicRMW(AtomicRMWInst::Add, ptr, v, AtomicOrdering::Monotonic);
-                }
-#else
-                builder->CreateAtomicRMW(AtomicRMWInst::Add, ptr, v, AtomicOrdering::Monotonic);
-#endif
+                builder->CreateAtomicRMW(rmw_op, ptr, v, AtomicOrdering::Monotonic);
             }
         }
     } else {
@@ -2566,7 +2675,15 @@ void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
             cmp->addIncoming(orig, bb);
             Value *val = nullptr;
             if (value_type.is_scalar()) {
-                val = codegen(op->value);
+                // Compute the new value from the value we are about
+                // to compare against rather than reloading it, so
+                // that a failed exchange retries with the value it
+                // observed.
+                string loaded_name = unique_name(op->name + ".cas_loaded");
+                Expr loaded_var = Variable::make(value_type, loaded_name);
+                sym_push(loaded_name, cmp);
+                val = codegen(substitute(equiv_load, loaded_var, op->value));
+                sym_pop(loaded_name);
             } else {
                 val = codegen(extract_lane(op->value, lane_id));
             }
@@ -3202,6 +3319,45 @@ void CodeGen_LLVM::visit(const Call *op) {
 
         llvm::CallInst *call = builder->CreateCall(base_fn->getFunctionType(), phi, call_args);
         value = call;
+    } else if (op->is_intrinsic(Call::has_target_features)) {
+        // Ask the runtime whether the CPU has these features the
+        // first time through, and cache the answer in a global. As
+        // with call_cached_indirect_function above, racing writes can
+        // only write the same value, so this needn't be threadsafe.
+        internal_assert(op->args.size() >= 2);
+        const StringImm *name = op->args[0].as<StringImm>();
+        internal_assert(name);
+        vector<Expr> words(op->args.begin() + 1, op->args.end());
+        Expr query = Call::make(Int(32), "halide_can_use_target_features",
+                                {(int)words.size(), Call::make(type_of<uint64_t *>(), Call::make_struct, words, Call::Intrinsic)},
+                                Call::Extern);
+
+        GlobalVariable *global = new GlobalVariable(
+            *module,
+            i32_t,
+            /*isConstant*/ false,
+            GlobalValue::PrivateLinkage,
+            ConstantInt::get(i32_t, -1),
+            unique_name(name->value + "_has_target_features"));
+        LoadInst *loaded_value = builder->CreateLoad(global);
+
+        BasicBlock *cached_bb = builder->GetInsertBlock();
+        BasicBlock *query_bb = BasicBlock::Create(*context, "query_target_features_bb", function);
+        BasicBlock *after_bb = BasicBlock::Create(*context, "after_query_target_features_bb", function);
+        Value *known = builder->CreateICmpSGE(loaded_value, ConstantInt::get(i32_t, 0));
+        builder->CreateCondBr(known, after_bb, query_bb, very_likely_branch);
+
+        builder->SetInsertPoint(query_bb);
+        Value *queried = codegen(query);
+        builder->CreateStore(queried, global);
+        query_bb = builder->GetInsertBlock();
+        builder->CreateBr(after_bb);
+
+        builder->SetInsertPoint(after_bb);
+        PHINode *phi = builder->CreatePHI(i32_t, 2);
+        phi->addIncoming(loaded_value, cached_bb);
+        phi->addIncoming(queried, query_bb);
+        value = builder->CreateICmpNE(phi, ConstantInt::get(i32_t, 0));
     } else if (op->is_intrinsic(Call::prefetch)) {
         user_assert((op->args.size() == 4) && is_one(op->args[2]))
             << "Only prefetch of 1 cache line is supported.\n";
@@ -3235,6 +3391,37 @@ void CodeGen_LLVM::visit(const Call *op) {
         builder->setFastMathFlags(safe_flags);
         builder->setDefaultFPMathTag(strict_fp_math_md);
         value = codegen(op->args[0]);
+    } else if (op->is_intrinsic(Call::dynamic_shuffle)) {
+        internal_assert(op->args.size() == 4);
+        Value *lut = codegen(op->args[0]);
+        Value *idx = codegen(op->args[1]);
+        int lanes = op->type.lanes();
+        int bytes = op->type.bytes();
+        int table_bytes = lut->getType()->getVectorNumElements() * bytes;
+        if (op->type.bits() == bytes * 8 && table_bytes <= max_lookup_table_bytes()) {
+            // Look up each byte of each element, at indices idx * bytes + j.
+            llvm::Type *elem_type = lut->getType()->getVectorElementType();
+            lut = builder->CreateBitCast(lut, VectorType::get(i8_t, table_bytes));
+            if (bytes > 1) {
+                idx = builder->CreateMul(idx, ConstantVector::getSplat(lanes, ConstantInt::get(i8_t, bytes)));
+                vector<int> indices(lanes * bytes);
+                vector<Constant *> offsets(lanes * bytes);
+                for (int i = 0; i < lanes * bytes; i++) {
+                    indices[i] = i / bytes;
+                    offsets[i] = ConstantInt::get(i8_t, i % bytes);
+                }
+                idx = builder->CreateAdd(shuffle_vectors(idx, indices), ConstantVector::get(offsets));
+            }
+            value = lookup_bytes(lut, idx);
+            value = builder->CreateBitCast(value, VectorType::get(elem_type, lanes));
+        } else {
+            value = UndefValue::get(VectorType::get(lut->getType()->getVectorElementType(), lanes));
+            for (int i = 0; i < lanes; i++) {
+                Value *lane = ConstantInt::get(i32_t, i);
+                Value *j = builder->CreateZExt(builder->CreateExtractElement(idx, lane), i32_t);
+                value = builder->CreateInsertElement(value, builder->CreateExtractElement(lut, j), lane);
+            }
+        }
     } else if (is_float16_transcendental(op)) {
         value = codegen(lower_float16_transcendental_to_float32_equivalent(op));
     } else if (op->is_intrinsic()) {
@@ -3264,6 +3451,60 @@ void CodeGen_LLVM::visit(const Call *op) {
         internal_assert(op->args.size() == 1);
         Expr e = Internal::halide_exp(op->args[0]);
         e.accept(this);
+    } else if (op->call_type == Call::PureExtern && op->type.is_vector() && !strict_float &&
+               (op->name == "sin_f32" || op->name == "cos_f32" || op->name == "tan_f32" ||
+                op->name == "atan2_f32" || op->name == "tanh_f32")) {
+        // The libm versions would be called once per lane, so use
+        // Halide's vectorizable versions instead.
+        if (op->name == "atan2_f32") {
+            internal_assert(op->args.size() == 2);
+            value = codegen(Internal::halide_atan2(op->args[0], op->args[1]));
+        } else if (op->name == "tanh_f32") {
+            value = codegen(Internal::halide_tanh(op->args[0]));
+        } else {
+            // The range reduction in Halide's sin, cos and tan is only
+            // exact for |x| < 8192. If any lane is outside that, call
+            // libm for the whole vector and use its results for those
+            // lanes.
+            internal_assert(op->args.size() == 1);
+            std::string x_name = unique_name('x');
+            Expr x = Variable::make(op->args[0].type(), x_name);
+            sym_push(x_name, codegen(op->args[0]));
+
+            Expr e;
+            if (op->name == "sin_f32") {
+                e = Internal::halide_sin(x);
+            } else if (op->name == "cos_f32") {
+                e = Internal::halide_cos(x);
+            } else {
+                e = Internal::halide_tan(x);
+            }
+            Value *fast = codegen(e);
+
+            // This is also true for NaNs and infinities.
+            Value *large = codegen(!(Halide::abs(x) < 8192.0f));
+            Value *none_large =
+                builder->CreateIsNull(builder->CreateBitCast(large, IntegerType::get(*context, op->type.lanes())));
+
+            BasicBlock *before_bb = builder->GetInsertBlock();
+            BasicBlock *large_bb = BasicBlock::Create(*context, "large_trig_arg_bb", function);
+            BasicBlock *after_bb = BasicBlock::Create(*context, "after_large_trig_arg_bb", function);
+            builder->CreateCondBr(none_large, after_bb, large_bb, very_likely_branch);
+
+            builder->SetInsertPoint(large_bb);
+            scalarize(Call::make(op->type, op->name, {x}, Call::PureExtern));
+            Value *exact = builder->CreateSelect(large, value, fast);
+            builder->CreateBr(after_bb);
+            large_bb = builder->GetInsertBlock();
+
+            builder->SetInsertPoint(after_bb);
+            PHINode *phi = builder->CreatePHI(fast->getType(), 2);
+            phi->addIncoming(fast, before_bb);
+            phi->addIncoming(exact, large_bb);
+            value = phi;
+
+            sym_pop(x_name);
+        }
     } else if (op->call_type == Call::PureExtern &&
                (op->name == "is_nan_f32" || op->name == "is_nan_f64")) {
         internal_assert(op->args.size() == 1);
@@ -3824,6 +4065,7 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
         function->addParamAttr(closure_arg_idx, Attribute::NoAlias);
 
         set_function_attributes_for_target(function, target);
+        set_function_cpu_attributes(function);
 
         // Make the initial basic block and jump the builder into the new function
         IRBuilderBase::InsertPoint call_site = builder->saveIP();
@@ -4034,6 +4276,117 @@ void CodeGen_LLVM::do_as_parallel_task(Stmt s) {
     do_parallel_tasks(tasks);
 }
 
+void CodeGen_LLVM::do_multiversioned(const IfThenElse *op) {
+    const Call *c = op->condition.as<Call>();
+    const string &name = c->args[0].as<StringImm>()->value;
+    Target version_target = multiversion_target(c, target);
+    if (version_target == target) {
+        // We're already compiling for these features (e.g. inside
+        // another version), so the check would always pass.
+        codegen(op->then_case);
+        return;
+    }
+
+    BasicBlock *true_bb = BasicBlock::Create(*context, "true_bb", function);
+    BasicBlock *false_bb = BasicBlock::Create(*context, "false_bb", function);
+    BasicBlock *after_bb = BasicBlock::Create(*context, "after_bb", function);
+    builder->CreateCondBr(codegen(op->condition), true_bb, false_bb);
+
+    builder->SetInsertPoint(true_bb);
+
+    // Pass everything the then case uses to the new function in a
+    // closure, as for parallel tasks.
+    Closure closure;
+    op->then_case.accept(&closure);
+    StructType *closure_t = build_closure_type(closure, buffer_t_type, context);
+    Value *closure_ptr = create_alloca_at_entry(closure_t, 1);
+    pack_closure(closure_t, closure_ptr, closure, symbol_table, buffer_t_type, builder);
+    closure_ptr = builder->CreatePointerCast(closure_ptr, i8_t->getPointerTo());
+
+    llvm::Type *args_t[] = {i8_t->getPointerTo(), i8_t->getPointerTo()};
+    FunctionType *fn_type = FunctionType::get(i32_t, args_t, false);
+
+    // Make a new function that does the then case, compiled for the
+    // target with the extra features.
+    string fn_name = name;
+    for (int i = 0; i < Target::FeatureEnd; i++) {
+        Target::Feature f = (Target::Feature)i;
+        if (version_target.has_feature(f) && !target.has_feature(f)) {
+            fn_name += "_" + Target::feature_to_name(f);
+        }
+    }
+    llvm::Function *containing_function = function;
+    function = llvm::Function::Create(fn_type, llvm::Function::InternalLinkage,
+                                      unique_name(fn_name), module.get());
+    llvm::Function *version_fn = function;
+    function->addParamAttr(1, Attribute::NoAlias);
+    // The function is compiled for more features than its caller, so
+    // llvm would refuse to inline it anyway. Say so up front.
+    function->addFnAttr(Attribute::NoInline);
+
+    Target saved_target = target;
+    bool saved_in_multiversion = in_multiversion;
+    target = version_target;
+    in_multiversion = true;
+
+    set_function_attributes_for_target(function, target);
+    set_function_cpu_attributes(function);
+
+    IRBuilderBase::InsertPoint call_site = builder->saveIP();
+    BasicBlock *block = BasicBlock::Create(*context, "entry", function);
+    builder->SetInsertPoint(block);
+
+    BasicBlock *parent_destructor_block = destructor_block;
+    destructor_block = nullptr;
+
+    Scope<Value *> saved_symbol_table;
+    symbol_table.swap(saved_symbol_table);
+
+    llvm::Function::arg_iterator iter = function->arg_begin();
+    sym_push("__user_context", iterator_to_pointer(iter));
+    ++iter;
+    iter->setName("closure");
+    Value *closure_handle = builder->CreatePointerCast(iterator_to_pointer(iter),
+                                                       closure_t->getPointerTo());
+    unpack_closure(closure, symbol_table, closure_t, closure_handle, builder);
+
+    codegen(op->then_case);
+    return_with_error_code(ConstantInt::get(i32_t, 0));
+
+    builder->restoreIP(call_site);
+    symbol_table.swap(saved_symbol_table);
+    function = containing_function;
+    destructor_block = parent_destructor_block;
+    target = saved_target;
+    in_multiversion = saved_in_multiversion;
+
+    Value *args[] = {get_user_context(), closure_ptr};
+    Value *result = builder->CreateCall(version_fn, args);
+    Value *did_succeed = builder->CreateICmpEQ(result, ConstantInt::get(i32_t, 0));
+    create_assertion(did_succeed, Expr(), result);
+    builder->CreateBr(after_bb);
+
+    builder->SetInsertPoint(false_bb);
+    if (op->else_case.defined()) {
+        codegen(op->else_case);
+    }
+    builder->CreateBr(after_bb);
+
+    builder->SetInsertPoint(after_bb);
+}
+
+void CodeGen_LLVM::set_function_cpu_attributes(llvm::Function *fn) {
+    if (!in_multiversion) {
+        // The module-wide settings apply.
+        return;
+    }
+    fn->addFnAttr("target-cpu", mcpu());
+    string attrs = mattrs();
+    if (!attrs.empty()) {
+        fn->addFnAttr("target-features", attrs);
+    }
+}
+
 void CodeGen_LLVM::visit(const Acquire *op) {
     do_as_parallel_task(op);
 }
@@ -4169,37 +4522,52 @@ void CodeGen_LLVM::codegen_asserts(const vector<const AssertStmt *> &asserts) {
         return;
     }
 
-    internal_assert(asserts.size() <= 63);
-
-    // Mix all the conditions together into a bitmask
-
-    Expr bitmask = cast<uint64_t>(1) << 63;
-    for (size_t i = 0; i < asserts.size(); i++) {
-        bitmask = bitmask | (cast<uint64_t>(!asserts[i]->condition) << i);
+    // Evaluate all the conditions once, and AND them together, so
+    // that the common case is a single well-predicted branch however
+    // many checks there are.
+    vector<string> names;
+    Value *all_ok = nullptr;
+    for (const auto *a : asserts) {
+        Value *c = codegen(a->condition);
+        names.push_back(unique_name("assert_condition"));
+        sym_push(names.back(), c);
+        all_ok = all_ok ? builder->CreateAnd(all_ok, c) : c;
     }
 
-    Expr switch_case = count_trailing_zeros(bitmask);
-
     BasicBlock *no_errors_bb = BasicBlock::Create(*context, "no_errors_bb", function);
+    BasicBlock *errors_bb = BasicBlock::Create(*context, "assert_failed", function);
+    builder->CreateCondBr(all_ok, no_errors_bb, errors_bb, very_likely_branch);
+
+    // In the cold path, work out which assertion failed first. Mix
+    // the conditions together into bitmasks of up to 63 at a time,
+    // and switch on the index of the lowest set bit to the correct
+    // failure.
+    builder->SetInsertPoint(errors_bb);
+    for (size_t start = 0; start < asserts.size(); start += 63) {
+        size_t end = std::min(asserts.size(), start + 63);
+        Expr bitmask = cast<uint64_t>(1) << 63;
+        for (size_t i = start; i < end; i++) {
+            Expr c = Variable::make(Bool(), names[i]);
+            bitmask = bitmask | (cast<uint64_t>(!c) << (int)(i - start));
+        }
+        Expr case_idx = cast<int32_t>(count_trailing_zeros(bitmask));
+
+        // If none of this group failed, try the next one.
+        BasicBlock *next_bb = (end == asserts.size()) ? no_errors_bb : BasicBlock::Create(*context, "assert_failed", function);
+        auto *switch_inst = builder->CreateSwitch(codegen(case_idx), next_bb, end - start);
+        for (size_t i = start; i < end; i++) {
+            BasicBlock *fail_bb = BasicBlock::Create(*context, "assert_failed", function);
+            switch_inst->addCase(ConstantInt::get(IntegerType::get(*context, 32), (int)(i - start)), fail_bb);
+            builder->SetInsertPoint(fail_bb);
+            Value *v = codegen(asserts[i]->message);
+            builder->CreateRet(v);
+        }
+        builder->SetInsertPoint(next_bb);
+    }
 
-    // Now switch on the bitmask to the correct failure
-    Expr case_idx = cast<int32_t>(count_trailing_zeros(bitmask));
-    llvm::SmallVector<uint32_t, 64> weights;
-    weights.push_back(1 << 30);
-    for (int i = 0; i < (int)asserts.size(); i++) {
-        weights.push_back(0);
+    for (const string &name : names) {
+        sym_pop(name);
     }
-    llvm::MDBuilder md_builder(*context);
-    llvm::MDNode *switch_very_likely_branch = md_builder.createBranchWeights(weights);
-    auto *switch_inst = builder->CreateSwitch(codegen(case_idx), no_errors_bb, asserts.size(), switch_very_likely_branch);
-    for (int i = 0; i < (int)asserts.size(); i++) {
-        BasicBlock *fail_bb = BasicBlock::Create(*context, "assert_failed", function);
-        switch_inst->addCase(ConstantInt::get(IntegerType::get(*context, 32), i), fail_bb);
-        builder->SetInsertPoint(fail_bb);
-        Value *v = codegen(asserts[i]->message);
-        builder->CreateRet(v);
-    }
-    builder->SetInsertPoint(no_errors_bb);
 }
 
 void CodeGen_LLVM::visit(const Block *op) {
@@ -4209,7 +4577,7 @@ void CodeGen_LLVM::visit(const Block *op) {
         vector<const AssertStmt *> asserts;
         asserts.push_back(a);
         Stmt s = op->rest;
-        while ((op = s.as<Block>()) && (a = op->first.as<AssertStmt>()) && is_pure(a->condition) && asserts.size() < 63) {
+        while ((op = s.as<Block>()) && (a = op->first.as<AssertStmt>()) && is_pure(a->condition)) {
             asserts.push_back(a);
             s = op->rest;
         }
@@ -4230,6 +4598,12 @@ void CodeGen_LLVM::visit(const Provide *op) {
 }
 
 void CodeGen_LLVM::visit(const IfThenElse *op) {
+    const Call *c = op->condition.as<Call>();
+    if (c && c->is_intrinsic(Call::has_target_features)) {
+        do_multiversioned(op);
+        return;
+    }
+
     BasicBlock *true_bb = BasicBlock::Create(*context, "true_bb", function);
     BasicBlock *false_bb = BasicBlock::Create(*context, "false_bb", function);
     BasicBlock *after_bb = BasicBlock::Create(*context, "after_bb", function);
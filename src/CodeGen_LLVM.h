@@ -136,6 +136,23 @@ protected:
      * of functions as. */
     virtual Type upgrade_type_for_argument_passing(const Type &) const;
 
+    /** Can casts between float16 and float32 use native conversion
+     * instructions, rather than being emulated with integer math? */
+    virtual bool supports_float16_conversion() const;
+
+    /** The size in bytes of the largest table that the target can look
+     * up a vector of bytes in without going to memory (e.g. with pshufb
+     * or tbl). Gathers that provably read from a range of a buffer no
+     * bigger than this are done with a dense load of the range and a
+     * dynamic_shuffle. Zero if the target can't do this. */
+    virtual int max_lookup_table_bytes() const;
+
+    /** Look up each byte of a vector of byte indices in a vector of up
+     * to max_lookup_table_bytes() bytes. Out of range indices give
+     * an undefined result. The default implementation does it one lane
+     * at a time. */
+    virtual llvm::Value *lookup_bytes(llvm::Value *table, llvm::Value *indices);
+
     /** State needed by llvm for code generation, including the
      * current module, function, context, builder, and most recently
      * generated llvm value. */
@@ -294,7 +311,9 @@ protected:
     void create_assertion(llvm::Value *condition, Expr message, llvm::Value *error_code = nullptr);
     // @}
 
-    /** Codegen a block of asserts with pure conditions */
+    /** Codegen a block of asserts with pure conditions. All the
+     * conditions are checked together with a single branch, and only
+     * the failure path works out which one failed. */
     void codegen_asserts(const std::vector<const AssertStmt *> &asserts);
 
     /** Codegen a call to do_parallel_tasks */
@@ -315,6 +334,17 @@ protected:
     void do_parallel_tasks(const std::vector<ParallelTask> &tasks);
     void do_as_parallel_task(Stmt s);
 
+    /** Codegen an IfThenElse conditioned on the has_target_features
+     * intrinsic. The then case is compiled into a separate function
+     * for the target with those features, which is called if the CPU
+     * has them. */
+    void do_multiversioned(const IfThenElse *op);
+
+    /** If we're currently generating code for more CPU features than
+     * the module as a whole, mark a new function as being compiled
+     * for them. */
+    void set_function_cpu_attributes(llvm::Function *fn);
+
     /** Return the the pipeline with the given error code. Will run
      * the destructor block. */
     void return_with_error_code(llvm::Value *error_code);
@@ -447,6 +477,14 @@ protected:
      * an arbitrary number of vectors.*/
     virtual llvm::Value *interleave_vectors(const std::vector<llvm::Value *> &);
 
+    /** Transpose a square block held as a vector per row, with log2(n)
+     * rounds of interleaving the low or high halves of pairs of rows,
+     * which most targets can do with one instruction (e.g. punpckl and
+     * punpckh, or zip1 and zip2). If the rows are wider than
+     * block_lanes, each block_lanes-wide slice of the rows is a
+     * separate block. Returns the rows of the transposed block(s). */
+    std::vector<llvm::Value *> transpose_by_interleaving(const std::vector<llvm::Value *> &rows, int block_lanes);
+
     /** Generate a call to a vector intrinsic or runtime inlined
      * function. The arguments are sliced up into vectors of the width
      * given by 'intrin_lanes', the intrinsic is called on each
@@ -519,6 +557,10 @@ private:
     /** Turn off all unsafe math flags in scopes while this is set. */
     bool strict_float;
 
+    /** Set while generating the body of a multiversioned loop nest
+     * (see do_multiversioned). */
+    bool in_multiversion;
+
     /** Embed an instance of halide_filter_metadata_t in the code, using
      * the given name (by convention, this should be ${FUNCTIONNAME}_metadata)
      * as extern "C" linkage. Note that the return value is a function-returning-
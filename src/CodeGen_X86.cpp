@@ -386,6 +386,49 @@ void CodeGen_X86::visit(const Call *op) {
     CodeGen_Posix::visit(op);
 }
 
+void CodeGen_X86::visit(const Load *op) {
+    // Use vpgatherdd or vgatherdps for gathers of 32-bit elements
+    // where the index isn't a ramp.
+    if (target.has_feature(Target::AVX2) &&
+        op->type.is_vector() && op->type.bits() == 32 &&
+        !op->index.as<Ramp>() && is_one(op->predicate)) {
+        Value *base = codegen_buffer_pointer(op->name, op->type.element_of(), ConstantInt::get(i32_t, 0));
+        base = builder->CreatePointerCast(base, i8_t->getPointerTo());
+        Value *index = codegen(op->index);
+
+        llvm::Type *slice_type = VectorType::get(llvm_type_of(op->type.element_of()), 8);
+        llvm::Type *index_type = VectorType::get(i32_t, 8);
+        const char *name = op->type.is_float() ? "llvm.x86.avx2.gather.d.ps.256" : "llvm.x86.avx2.gather.d.d.256";
+        llvm::Function *fn = module->getFunction(name);
+        if (!fn) {
+            FunctionType *fn_type =
+                FunctionType::get(slice_type, {slice_type, base->getType(), index_type, slice_type, i8_t}, false);
+            fn = llvm::Function::Create(fn_type, llvm::Function::ExternalLinkage, name, module.get());
+        }
+
+        int lanes = op->type.lanes();
+        vector<Value *> slices;
+        for (int i = 0; i < lanes; i += 8) {
+            // Only lanes with the sign bit of the mask set are loaded,
+            // so the lanes past the end of the vector are left alone.
+            vector<Constant *> mask(8);
+            for (int j = 0; j < 8; j++) {
+                mask[j] = ConstantInt::get(i32_t, i + j < lanes ? -1 : 0);
+            }
+            Value *slice_mask = builder->CreateBitCast(ConstantVector::get(mask), slice_type);
+            Value *slice_index = slice_vector(index, i, 8);
+            CallInst *gather = builder->CreateCall(fn, {Constant::getNullValue(slice_type), base, slice_index,
+                                                        slice_mask, ConstantInt::get(i8_t, 4)});
+            add_tbaa_metadata(gather, op->name, op->index);
+            slices.push_back(gather);
+        }
+        value = slice_vector(concat_vectors(slices), 0, lanes);
+        return;
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
 string CodeGen_X86::mcpu() const {
     if (target.has_feature(Target::AVX512_Cannonlake)) return "cannonlake";
     if (target.has_feature(Target::AVX512_Skylake)) return "skylake-avx512";
@@ -451,6 +494,85 @@ int CodeGen_X86::native_vector_bits() const {
     }
 }
 
+bool CodeGen_X86::supports_float16_conversion() const {
+    // vcvtph2ps and vcvtps2ph
+    return target.has_feature(Target::F16C);
+}
+
+int CodeGen_X86::max_lookup_table_bytes() const {
+    // Up to four pshufbs and blends.
+    return target.has_feature(Target::SSE41) ? 64 : 0;
+}
+
+Value *CodeGen_X86::lookup_bytes(Value *table, Value *indices) {
+    // pshufb looks up 16 byte tables, and the avx2 version looks up a
+    // separate table in each 128-bit half. Look up each 16 byte chunk
+    // of the table in turn, and keep the results for the indices that
+    // are at least the start of that chunk.
+    const bool avx2 = target.has_feature(Target::AVX2);
+    const int native_lanes = avx2 ? 32 : 16;
+    const char *pshufb = avx2 ? "llvm.x86.avx2.pshuf.b" : "llvm.x86.ssse3.pshuf.b.128";
+
+    int lanes = indices->getType()->getVectorNumElements();
+    int padded_lanes = ((lanes + native_lanes - 1) / native_lanes) * native_lanes;
+    int table_bytes = table->getType()->getVectorNumElements();
+    indices = slice_vector(indices, 0, padded_lanes);
+    table = slice_vector(table, 0, ((table_bytes + 15) / 16) * 16);
+    llvm::Type *result_type = indices->getType();
+
+    Value *result = nullptr;
+    for (int start = 0; start < table_bytes; start += 16) {
+        vector<int> chunk_indices(padded_lanes);
+        for (int i = 0; i < padded_lanes; i++) {
+            chunk_indices[i] = start + i % 16;
+        }
+        Value *chunk = shuffle_vectors(table, chunk_indices);
+        Value *chunk_start = ConstantVector::getSplat(padded_lanes, ConstantInt::get(i8_t, start));
+        Value *chunk_result = call_intrin(result_type, native_lanes, pshufb,
+                                          {chunk, builder->CreateSub(indices, chunk_start)});
+        if (result) {
+            result = builder->CreateSelect(builder->CreateICmpUGE(indices, chunk_start), chunk_result, result);
+        } else {
+            result = chunk_result;
+        }
+    }
+    return slice_vector(result, 0, lanes);
+}
+
+Value *CodeGen_X86::interleave_vectors(const vector<Value *> &vecs) {
+    // Interleaving n vectors of n lanes is a transpose. The unpack
+    // instructions interleave within each 128-bit lane.
+    const int n = (int)vecs.size();
+    const int lanes = vecs[0]->getType()->getVectorNumElements();
+    const int row_bits = lanes * vecs[0]->getType()->getScalarSizeInBits();
+    if (n == lanes && n >= 4 && (n & (n - 1)) == 0) {
+        if (row_bits == 128) {
+            return concat_vectors(transpose_by_interleaving(vecs, n));
+        } else if (row_bits == 256 && target.has_feature(Target::AVX2)) {
+            // Swap the off-diagonal 128-bit quarters of the block with
+            // vperm2i128, then transpose within each 128-bit lane.
+            const int h = n / 2;
+            vector<int> lo(n), hi(n);
+            for (int i = 0; i < h; i++) {
+                lo[i] = i;
+                lo[i + h] = i + n;
+                hi[i] = i + h;
+                hi[i + h] = i + h + n;
+            }
+            vector<Value *> left(h), right(h);
+            for (int i = 0; i < h; i++) {
+                left[i] = shuffle_vectors(vecs[i], vecs[i + h], lo);
+                right[i] = shuffle_vectors(vecs[i], vecs[i + h], hi);
+            }
+            vector<Value *> rows = transpose_by_interleaving(left, h);
+            vector<Value *> right_rows = transpose_by_interleaving(right, h);
+            rows.insert(rows.end(), right_rows.begin(), right_rows.end());
+            return concat_vectors(rows);
+        }
+    }
+    return CodeGen_Posix::interleave_vectors(vecs);
+}
+
 int CodeGen_X86::vector_lanes_for_slice(const Type &t) const {
     // We don't want to pad all the way out to natural_vector_size,
     // because llvm generates crappy code. Better to use a smaller
@@ -27,6 +27,10 @@ protected:
     std::string mattrs() const override;
     bool use_soft_float_abi() const override;
     int native_vector_bits() const override;
+    bool supports_float16_conversion() const override;
+    int max_lookup_table_bytes() const override;
+    llvm::Value *lookup_bytes(llvm::Value *table, llvm::Value *indices) override;
+    llvm::Value *interleave_vectors(const std::vector<llvm::Value *> &) override;
 
     int vector_lanes_for_slice(const Type &t) const;
 
@@ -40,6 +44,7 @@ protected:
     void visit(const Sub *) override;
     void visit(const Cast *) override;
     void visit(const Call *) override;
+    void visit(const Load *) override;
     void visit(const GT *) override;
     void visit(const LT *) override;
     void visit(const LE *) override;
@@ -6,6 +6,7 @@
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "IRVisitor.h"
 #include "ModulusRemainder.h"
 #include "Scope.h"
 #include "Simplify.h"
@@ -168,6 +169,34 @@ private:
     }
 };
 
+// Checks whether a let value can be moved above some stores: it must
+// not load from any of the buffers stored to, or call anything impure.
+class CanHoistAboveStores : public IRVisitor {
+    const std::set<std::string> &store_names;
+
+    using IRVisitor::visit;
+
+    void visit(const Load *op) override {
+        if (store_names.count(op->name)) {
+            result = false;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        if (!op->is_pure()) {
+            result = false;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result = true;
+    CanHoistAboveStores(const std::set<std::string> &store_names)
+        : store_names(store_names) {
+    }
+};
+
 Stmt collect_strided_stores(Stmt stmt, const std::string &name, int stride, int max_stores,
                             std::vector<Stmt> lets, std::vector<Stmt> &stores) {
 
@@ -723,8 +752,113 @@ class Interleaver : public IRMutator {
         return stmt;
     }
 
+    // Look for a run of N dense stores of N-lane loads from the same
+    // buffer with the same stride and consecutive bases, e.g. from
+    // f(x, y) = g(y, x) vectorized over x and unrolled over y. The
+    // loads read an N x N block of g a column at a time. Replace them
+    // with N dense loads of the rows of the block, transposed in
+    // registers by interleaving them.
+    HALIDE_NEVER_INLINE Stmt transpose_stores(const Block *op) {
+        // Collect the stores. As in gather_stores, let stmts around
+        // and between them are pulled out, and rewrapped around the
+        // result.
+        std::vector<const LetStmt *> let_stmts;
+        std::vector<const Store *> stores;
+        const Load *load = nullptr;
+        const Ramp *r0 = nullptr;
+        int lanes = 0;
+        Stmt rest = op;
+        do {
+            while (const LetStmt *let = rest.as<LetStmt>()) {
+                let_stmts.push_back(let);
+                rest = let->body;
+            }
+            const Block *block = rest.as<Block>();
+            Stmt s = block ? block->first : rest;
+            rest = block ? block->rest : Stmt();
+            while (const LetStmt *let = s.as<LetStmt>()) {
+                // A let wrapping a store can't also wrap the stmts
+                // after it.
+                if (rest.defined()) return Stmt();
+                let_stmts.push_back(let);
+                s = let->body;
+            }
+
+            const Store *si = s.as<Store>();
+            if (!si || !is_one(si->predicate)) return Stmt();
+            const Load *li = si->value.as<Load>();
+            if (!li || !is_one(li->predicate) || si->name == li->name) return Stmt();
+            const Ramp *ri = li->index.as<Ramp>();
+            if (!ri) return Stmt();
+
+            if (stores.empty()) {
+                load = li;
+                r0 = ri;
+                lanes = r0->lanes;
+                if (is_one(r0->stride)) return Stmt();
+                if (lanes < 4 || lanes > 16 || (lanes & (lanes - 1)) != 0) return Stmt();
+            }
+
+            const Ramp *store_ramp = si->index.as<Ramp>();
+            if (!store_ramp || !is_one(store_ramp->stride) || store_ramp->lanes != lanes) return Stmt();
+
+            // Load i is column i of the block.
+            if (li->name != load->name || ri->lanes != lanes || !equal(ri->stride, r0->stride)) return Stmt();
+            if (!is_const(simplify(ri->base - r0->base), (int64_t)stores.size())) return Stmt();
+
+            stores.push_back(si);
+        } while ((int)stores.size() < lanes && rest.defined());
+
+        if ((int)stores.size() < lanes) return Stmt();
+
+        // The lets are all moved above the stores.
+        std::set<std::string> store_names;
+        for (const Store *si : stores) {
+            store_names.insert(si->name);
+        }
+        if (store_names.count(load->name)) return Stmt();
+        for (const LetStmt *let : let_stmts) {
+            CanHoistAboveStores check(store_names);
+            let->value.accept(&check);
+            if (!check.result) return Stmt();
+        }
+
+        Type t = load->type;
+        std::vector<Expr> rows;
+        for (int i = 0; i < lanes; i++) {
+            Expr base = simplify(r0->base + i * r0->stride);
+            rows.push_back(Load::make(t, load->name, Ramp::make(base, make_one(base.type()), lanes),
+                                      load->image, load->param, const_true(lanes), ModulusRemainder()));
+        }
+
+        std::string name = unique_name('t');
+        Expr transposed = Variable::make(t.with_lanes(lanes * lanes), name);
+        std::vector<Stmt> new_stores;
+        for (int i = 0; i < lanes; i++) {
+            const Store *si = stores[i];
+            Expr value = Shuffle::make_slice(transposed, i * lanes, 1, lanes);
+            new_stores.push_back(Store::make(si->name, value, si->index, si->param, si->predicate, si->alignment));
+        }
+        Stmt stmt = LetStmt::make(name, Shuffle::make_interleave(rows), Block::make(new_stores));
+        if (rest.defined()) {
+            stmt = Block::make(stmt, mutate(rest));
+        }
+
+        // Rewrap the let statements we pulled off.
+        while (!let_stmts.empty()) {
+            const LetStmt *let = let_stmts.back();
+            stmt = LetStmt::make(let->name, let->value, stmt);
+            let_stmts.pop_back();
+        }
+
+        return stmt;
+    }
+
     Stmt visit(const Block *op) override {
         Stmt s = gather_stores(op);
+        if (!s.defined()) {
+            s = transpose_stores(op);
+        }
         if (s.defined()) {
             return s;
         } else {
@@ -24,7 +24,9 @@ Expr extract_lane(Expr vec, int lane);
 
 /** Look through a statement for expressions of the form select(ramp %
  * 2 == 0, a, b) and replace them with calls to an interleave
- * intrinsic */
+ * intrinsic. Also combines runs of strided stores into interleaving
+ * stores, and runs of stores of strided loads that read a square block
+ * a column at a time into dense loads transposed in registers. */
 Stmt rewrite_interleavings(Stmt s);
 
 void deinterleave_vector_test();
@@ -185,5 +185,141 @@ Expr lower_float16_cast(const Cast *op) {
     return cast(dst, val);
 }
 
+namespace {
+
+bool is_float16_or_bfloat16(const Type &t) {
+    return t.is_bfloat() || (t.is_float() && t.bits() == 16);
+}
+
+class WidenFloat16Arithmetic : public IRMutator {
+    using IRMutator::visit;
+
+    // Compute a float16 or bfloat16 expression in float32 instead,
+    // without rounding the intermediate results.
+    Expr widen(const Expr &e) {
+        Type f32 = Float(32, e.type().lanes());
+        if (const Add *op = e.as<Add>()) {
+            return Add::make(widen(op->a), widen(op->b));
+        } else if (const Sub *op = e.as<Sub>()) {
+            return Sub::make(widen(op->a), widen(op->b));
+        } else if (const Mul *op = e.as<Mul>()) {
+            return Mul::make(widen(op->a), widen(op->b));
+        } else if (const Div *op = e.as<Div>()) {
+            return Div::make(widen(op->a), widen(op->b));
+        } else if (const Min *op = e.as<Min>()) {
+            return Min::make(widen(op->a), widen(op->b));
+        } else if (const Max *op = e.as<Max>()) {
+            return Max::make(widen(op->a), widen(op->b));
+        } else if (const Select *op = e.as<Select>()) {
+            return Select::make(mutate(op->condition), widen(op->true_value), widen(op->false_value));
+        } else if (const Broadcast *op = e.as<Broadcast>()) {
+            return Broadcast::make(widen(op->value), op->lanes);
+        } else if (const FloatImm *op = e.as<FloatImm>()) {
+            // The value is already representable in 16 bits.
+            return FloatImm::make(f32, op->value);
+        } else if (const Call *op = e.as<Call>()) {
+            auto it = transcendental_remapping.find(op->name);
+            if (it != transcendental_remapping.end()) {
+                std::vector<Expr> new_args;
+                for (const Expr &arg : op->args) {
+                    new_args.push_back(widen(arg));
+                }
+                return Call::make(f32, it->second, new_args, op->call_type,
+                                  op->func, op->value_index, op->image, op->param);
+            }
+        }
+        return cast(f32, mutate(e));
+    }
+
+    // Compute the whole tree rooted at e in float32, and round the
+    // result once.
+    Expr narrow(const Expr &e) {
+        return cast(e.type(), widen(e));
+    }
+
+    template<typename T>
+    Expr visit_arithmetic(const T *op) {
+        if (is_float16_or_bfloat16(op->type)) {
+            return narrow(op);
+        }
+        return IRMutator::visit(op);
+    }
+
+    template<typename T>
+    Expr visit_comparison(const T *op) {
+        if (is_float16_or_bfloat16(op->a.type())) {
+            return T::make(widen(op->a), widen(op->b));
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Add *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Sub *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Mul *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Div *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Min *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Max *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const Select *op) override {
+        return visit_arithmetic(op);
+    }
+
+    Expr visit(const EQ *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const NE *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const LT *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const LE *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const GT *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const GE *op) override {
+        return visit_comparison(op);
+    }
+
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::strict_float)) {
+            return op;
+        } else if (is_float16_or_bfloat16(op->type) && is_float16_transcendental(op)) {
+            return narrow(op);
+        }
+        return IRMutator::visit(op);
+    }
+};
+
+}  // namespace
+
+Stmt widen_float16_arithmetic(const Stmt &s) {
+    return WidenFloat16Arithmetic().mutate(s);
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -26,6 +26,12 @@ Expr bfloat16_to_float32(Expr e);
 Expr lower_float16_cast(const Cast *op);
 //@}
 
+/** Compute trees of float16 and bfloat16 arithmetic in float32,
+ * converting the leaves up once and rounding the result once, instead
+ * of rounding back to 16 bits after every operation. Anything inside
+ * strict_float is left alone. */
+Stmt widen_float16_arithmetic(const Stmt &s);
+
 }  // namespace Internal
 }  // namespace Halide
 
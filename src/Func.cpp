@@ -609,6 +609,47 @@ Func Stage::rfactor(RVar r, Var v) {
     return rfactor({{r, v}});
 }
 
+Func Stage::privatize(RVar r, Var u, int copies, int vector_width) {
+    user_assert(!definition.is_init()) << "privatize() must be called on an update definition\n";
+    user_assert(copies > 0 && vector_width > 0)
+        << "In schedule for " << name()
+        << ", privatize() requires a positive number of copies and vector width\n";
+
+    // Check legality up front, so that the error is in terms of
+    // privatize rather than the rfactor we use to implement it.
+    user_assert(prove_associativity(function.name(), definition.args(), definition.values()).associative())
+        << "Failed to call privatize() on " << name()
+        << " since it can't prove associativity of the operator\n";
+
+    const vector<ReductionVariable> &rvars = definition.schedule().rvars();
+    const auto &rv = std::find_if(rvars.begin(), rvars.end(),
+                                  [&r](const ReductionVariable &rv) { return var_name_match(rv.var, r.name()); });
+    user_assert(rv != rvars.end())
+        << "In schedule for " << name()
+        << ", can't privatize " << r.name()
+        << " since it is not an unsplit variable of the reduction domain\n"
+        << dump_argument_list();
+
+    // Divide the reduction domain into one slice per copy.
+    Expr slice = (rv->extent + (copies - 1)) / copies;
+    RVar ro(r.name() + "_copy"), ri(r.name() + "_serial");
+    split(r, ro, ri, slice, TailStrategy::GuardWithIf);
+
+    // Each copy of the output is reduced into by its own task. The
+    // copies live for the duration of the merge stage.
+    Func intm = rfactor(ro, u);
+    intm.compute_at(LoopLevel(function, Var::outermost(), (int)stage_index));
+    intm.update(0).parallel(u);
+
+    if (!dim_vars.empty()) {
+        // Merge the copies, vectorized across the elements of the output.
+        intm.vectorize(dim_vars[0], vector_width);
+        reorder(dim_vars[0], ro).vectorize(dim_vars[0], vector_width, TailStrategy::GuardWithIf);
+    }
+
+    return intm;
+}
+
 Func Stage::rfactor(vector<pair<RVar, Var>> preserved) {
     user_assert(!definition.is_init()) << "rfactor() must be called on an update definition\n";
 
@@ -2023,9 +2064,30 @@ Func &Func::store_in(MemoryType t) {
     return *this;
 }
 
+Func &Func::store_per_parallel_task() {
+    invalidate_cache();
+    func.schedule().store_per_parallel_task() = true;
+    return *this;
+}
+
 Func &Func::async() {
+    return async(1);
+}
+
+Func &Func::async(int depth) {
+    user_assert(depth >= 1)
+        << "Async depth for Func " << name() << " must be at least one, not " << depth << "\n";
     invalidate_cache();
     func.schedule().async() = true;
+    func.schedule().async_depth() = depth;
+    return *this;
+}
+
+Func &Func::multiversion(const std::vector<Target::Feature> &features) {
+    user_assert(!features.empty())
+        << "Func " << name() << " must be multiversioned for at least one target feature\n";
+    invalidate_cache();
+    func.schedule().multiversions().push_back(features);
     return *this;
 }
 
@@ -189,6 +189,43 @@ public:
     Func rfactor(RVar r, Var v);
     // @}
 
+    /** Parallelize a scatter-reduction into a small output (e.g. a
+     * histogram) by giving each parallel task a private copy of the
+     * output. The RVar 'r' is split into 'copies' pieces, and the
+     * outer piece is rfactored into the pure Var 'u' of an
+     * intermediate Func. The intermediate is computed at the
+     * outermost loop of this Func, with its update parallelized over
+     * 'u', so each task reduces into its own copy without atomics or
+     * contention. This update definition becomes a merge of the
+     * copies, vectorized by 'vector_width' along the innermost pure
+     * Var of this Func. Like rfactor(), this will throw an error if
+     * it can't prove the update is associative. The intermediate
+     * Func is returned for further scheduling.
+     *
+     * For example:
+     \code
+     hist(x) = 0;
+     hist(clamp(input(r.x, r.y), 0, 255)) += 1;
+     hist.compute_root().update().privatize(r.y, u, 8);
+     \endcode
+     * is equivalent to:
+     \code
+     for x:
+       hist(x) = 0
+     for u:
+       for x:
+         hist_intm(x, u) = 0
+     parallel for u = 0 to 7:
+       for r.y.serial in [0, ceil(height / 8)):
+         for r.x:
+           hist_intm(clamp(input(r.x, r.y), 0, 255), u) += 1
+     for u = 0 to 7:
+       vectorized for x:
+         hist(x) += hist_intm(x, u)
+     \endcode
+     */
+    Func privatize(RVar r, Var u, int copies, int vector_width = 8);
+
     /** Schedule the iteration over this stage to be fused with another
      * stage 's' from outermost loop to a given LoopLevel. 'this' stage will
      * be computed AFTER 's' in the innermost fused dimension. There should not
@@ -2016,6 +2053,14 @@ public:
      * Then g will be computed at each row of f and stored in a buffer
      * with an extent in y of 2, alternately storing each computed row
      * of g in row y=0 or y=1.
+     *
+     * Storage is also folded automatically where possible, without a
+     * call to this method. If the footprint in a dimension is bounded
+     * by an expression that doesn't vary over the realization (e.g. a
+     * blur with a runtime radius) rather than by a constant, the fold
+     * factor is computed at runtime as the next power of two above
+     * that bound, capped at the extent of the realization. Bounds of
+     * 2^30 or more aren't folded.
      */
     Func &fold_storage(Var dim, Expr extent, bool fold_forward = true);
 
@@ -2151,6 +2196,24 @@ public:
      */
     Func &memoize();
 
+    /** If this Func is stored outside a parallel loop, computed
+     * inside it, and slides over a serial loop directly inside it,
+     * give each iteration of the parallel loop its own storage.
+     * Every strip then warms up and slides its own window, and its
+     * storage is only as big as one strip's footprint, so storage
+     * folding can fold it. For example:
+     *
+     \code
+     g.split(y, yo, yi, 16).parallel(yo);
+     f.store_root().compute_at(g, yi).store_per_parallel_task();
+     \endcode
+     *
+     * is stored as if it were store_at(g, yo), but you don't need to
+     * know which loop will be parallel when scheduling f. Does
+     * nothing if there's no such parallel loop, f is used outside it,
+     * or f is async. */
+    Func &store_per_parallel_task();
+
     /** Produce this Func asynchronously in a separate
      * thread. Consumers will be run by the task system when the
      * production is complete. If this Func's store level is different
@@ -2170,6 +2233,53 @@ public:
      */
     Func &async();
 
+    /** Produce this Func asynchronously, as above, but let the
+     * producer run up to depth iterations of the consuming loop
+     * ahead of the consumer. When storage folding picks the fold
+     * factor automatically, the folded buffer is grown into a ring
+     * buffer big enough to hold depth footprints of the consumer, so
+     * that a consumer iteration that runs long does not immediately
+     * stall the producer. An explicit fold factor set with
+     * \ref Func::fold_storage is used as-is, and a warning is given
+     * that the depth has no effect. async(1) is equivalent to
+     * async(). */
+    Func &async(int depth);
+
+    /** Also compile the production of this Func for a CPU with the
+     * given extra target features, and pick between that version and
+     * the one for the base target at runtime. Only the loop nests of
+     * this Func are compiled twice, so this is a cheaper alternative
+     * to compiling the whole pipeline for several targets when a few
+     * hot loops are all that benefit from e.g. AVX2 or AVX-512. May be
+     * called more than once to add several versions; they are tried
+     * in the order they were added, and the base target is used if
+     * none of them are available. Versions whose features the target
+     * being compiled for already has are ignored. Only applies to
+     * ahead-of-time compilation to object code; JIT compilation and
+     * the C backend just use the base target's version.
+     *
+     * The check of whether the features are available is done each
+     * time the Func is produced. Its result is cached, so the check
+     * itself is a load and a branch, but each extra version is an
+     * outlined function: every production that takes it packs the
+     * values the loop nest uses into a closure and makes a call, as a
+     * parallel task does. A Func that is produced often for little
+     * work (e.g. compute_at an inner loop) will be slowed down by
+     * this, so prefer multiversioning Funcs computed at an outer loop
+     * level.
+     *
+     * If the Func's realizations are traced, each production emits a
+     * halide_trace_tag event of the form "multiversion <features>",
+     * naming the extra features of the version that runs (none for
+     * the base target's version).
+     \code
+     f.vectorize(x, 16).parallel(y)
+      .multiversion({Target::AVX512_Skylake})
+      .multiversion({Target::AVX2, Target::FMA});
+     \endcode
+     */
+    Func &multiversion(const std::vector<Target::Feature> &features);
+
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
      * separate the loop level at which storage occurs from the loop
@@ -5,6 +5,9 @@
 #include "BoundaryConditions.h"
 #include "Derivative.h"
 #include "Generator.h"
+#include "GeneratorServer.h"
+#include "IRMutator.h"
+#include "IROperator.h"
 #include "IRPrinter.h"
 #include "Module.h"
 #include "Simplify.h"
@@ -112,6 +115,136 @@ Func make_param_func(const Parameter &p, const std::string &name) {
     return f;
 }
 
+struct ShapeSpecialization {
+    int width, height, stride;
+};
+
+// Parse a list of the form "1920x1080:2048,640x480". The stride of
+// the second dimension is optional, and defaults to the width.
+std::vector<ShapeSpecialization> parse_shape_specializations(const std::string &s) {
+    std::vector<ShapeSpecialization> result;
+    for (const std::string &tok : split_string(s, ",")) {
+        if (tok.empty()) continue;
+        ShapeSpecialization shape;
+        char x = 0, colon = 0;
+        std::istringstream iss(tok);
+        iss >> shape.width >> x >> shape.height;
+        bool ok = !iss.fail() && x == 'x';
+        shape.stride = shape.width;
+        if (ok && !iss.eof()) {
+            iss >> colon >> shape.stride;
+            ok = !iss.fail() && colon == ':';
+        }
+        ok = ok && (iss >> std::ws).eof();
+        user_assert(ok && shape.width > 0 && shape.height > 0 && shape.stride >= shape.width)
+            << "Unable to parse shape specialization \"" << tok << "\": "
+            << "expected a width and height, and optionally a stride, as in 1920x1080:2048\n";
+        result.push_back(shape);
+    }
+    return result;
+}
+
+// The condition under which an output is a given shape.
+Expr output_has_shape(const Func &f, const ShapeSpecialization &shape) {
+    Expr cond = const_true();
+    for (const OutputImageParam &b : f.output_buffers()) {
+        cond = cond &&
+               b.dim(0).extent() == shape.width &&
+               b.dim(1).extent() == shape.height &&
+               b.dim(1).stride() == shape.stride;
+    }
+    return cond;
+}
+
+// The histogram of values recorded for each argument of one
+// pipeline, as printed by halide_param_profile_report. Each entry is
+// a count and the values.
+using ParamProfile = std::map<std::string, std::vector<std::pair<uint64_t, std::vector<int64_t>>>>;
+
+ParamProfile read_param_profile(const std::string &filename, const std::string &pipeline_name) {
+    std::ifstream f(filename);
+    user_assert(f.is_open()) << "Unable to open specialization profile " << filename << "\n";
+    ParamProfile result;
+    std::string line;
+    while (std::getline(f, line)) {
+        // Ignore anything else the program printed.
+        std::istringstream iss(line);
+        std::string tag, pipeline, name;
+        uint64_t count;
+        iss >> tag >> pipeline >> name >> count;
+        if (iss.fail() || tag != "halide_param_profile" || pipeline != pipeline_name) {
+            continue;
+        }
+        std::vector<int64_t> values;
+        int64_t v;
+        while (iss >> v) {
+            values.push_back(v);
+        }
+        result[name].emplace_back(count, values);
+    }
+    return result;
+}
+
+// The values of an argument that account for at least 10% of the
+// calls recorded, most frequent first, at most four of them.
+std::vector<std::vector<int64_t>> hot_values(const ParamProfile &profile, const std::string &name) {
+    std::vector<std::vector<int64_t>> result;
+    auto it = profile.find(name);
+    if (it == profile.end()) {
+        return result;
+    }
+    auto entries = it->second;
+    uint64_t total = 0;
+    for (const auto &e : entries) {
+        total += e.first;
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const std::pair<uint64_t, std::vector<int64_t>> &a,
+                        const std::pair<uint64_t, std::vector<int64_t>> &b) {
+                         return a.first > b.first;
+                     });
+    for (const auto &e : entries) {
+        if (result.size() >= 4 || e.first * 10 < total) {
+            break;
+        }
+        result.push_back(e.second);
+    }
+    return result;
+}
+
+// A custom lowering pass that reports which specialization of the
+// output a call to the pipeline is going to take. The shape
+// specializations come first, then the specializations for hot scalar
+// values.
+class InjectShapeDispatch : public IRMutator {
+    Stmt report;
+
+public:
+    InjectShapeDispatch(const std::string &pipeline_name, const Func &output) {
+        // The index of the first specialization whose condition holds,
+        // or the number of specializations if none do. These are the
+        // conditions of the branches lowering makes for the
+        // specializations, so the index is the branch taken.
+        Expr buf = Variable::make(type_of<struct halide_buffer_t *>(),
+                                  output.output_buffers()[0].name() + ".buffer");
+        const std::vector<Specialization> &specializations =
+            output.function().definition().specializations();
+        Expr path = (int)specializations.size();
+        for (int i = (int)specializations.size() - 1; i >= 0; i--) {
+            path = select(specializations[i].condition, i, path);
+        }
+        Expr call = Call::make(Int(32), "halide_shape_dispatch", {pipeline_name, path}, Call::Extern);
+        Expr is_bounds_query = Call::make(Bool(), Call::buffer_is_bounds_query, {buf}, Call::Extern);
+        report = IfThenElse::make(!is_bounds_query, Evaluate::make(call));
+    }
+
+    using IRMutator::mutate;
+
+    Stmt mutate(const Stmt &s) override {
+        return Block::make(report, s);
+    }
+};
+
 }  // namespace
 
 std::vector<Type> parse_halide_type_list(const std::string &types) {
@@ -231,7 +364,9 @@ private:
             // These are always propagated specially.
             if (p->name == "target" ||
                 p->name == "auto_schedule" ||
-                p->name == "machine_params") continue;
+                p->name == "machine_params" ||
+                p->name == "shape_specializations" ||
+                p->name == "specialization_profile") continue;
             if (p->is_synthetic_param()) continue;
             out.push_back(p);
         }
@@ -769,7 +904,15 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
         "     find one. Flags across all of the targets that do not affect runtime code\n"
         "     generation, such as `no_asserts` and `no_runtime`, are ignored.\n"
         "\n"
-        " -s  The name of an autoscheduler to set as the default.\n";
+        " -s  The name of an autoscheduler to set as the default.\n"
+        "\n"
+        "gengen -server SOCKET_PATH [-j NUM_THREADS]\n"
+        "\n"
+        " Run as a compile server: accept gengen command lines on a unix domain socket\n"
+        " and run up to NUM_THREADS of them at a time (default: one per core), each in\n"
+        " its own forked process with the client's working directory and environment.\n"
+        " When HL_GENGEN_SERVER is set to the socket path, gengen sends its job to the\n"
+        " server if one is running and has the generator, and otherwise runs it itself.\n";
 
     std::map<std::string, std::string> flags_info = {
         {"-d", "0"},
@@ -983,7 +1126,7 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
 }
 
 #ifdef WITH_EXCEPTIONS
-int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
+int generate_filter_main_job(int argc, char **argv, std::ostream &cerr) {
     try {
         return generate_filter_main_inner(argc, argv, cerr);
     } catch (std::runtime_error &err) {
@@ -992,11 +1135,22 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
     }
 }
 #else
-int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
+int generate_filter_main_job(int argc, char **argv, std::ostream &cerr) {
     return generate_filter_main_inner(argc, argv, cerr);
 }
 #endif
 
+int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
+    if (argc >= 2 && std::string(argv[1]) == "-server") {
+        return generator_server_main(argc, argv, cerr, generate_filter_main_job);
+    }
+    int result = 0;
+    if (run_on_generator_server(argc, argv, cerr, &result)) {
+        return result;
+    }
+    return generate_filter_main_job(argc, argv, cerr);
+}
+
 GeneratorParamBase::GeneratorParamBase(const std::string &name)
     : name(name) {
     ObjectInstanceRegistry::register_instance(this, 0, ObjectInstanceRegistry::GeneratorParam,
@@ -1410,6 +1564,77 @@ Module GeneratorBase::build_module(const std::string &function_name,
         auto_schedule_results = pipeline.auto_schedule(get_target(), get_machine_params());
     }
 
+    const std::string &name = function_name.empty() ? generator_registered_name : function_name;
+    std::vector<ShapeSpecialization> shapes = parse_shape_specializations(shape_specializations);
+    std::vector<Expr> hot_param_conditions;
+    if (!specialization_profile.value().empty()) {
+        // Specialize for the argument values a previous run of the
+        // pipeline, compiled with the param_profile feature, saw
+        // most often.
+        const GeneratorParamInfo &pi = param_info();
+        ParamProfile profile = read_param_profile(specialization_profile, name);
+        for (const auto &buf : pipeline.outputs()[0].output_buffers()) {
+            for (const auto &v : hot_values(profile, buf.name() + ".shape")) {
+                if (v.size() != 3) continue;
+                ShapeSpecialization shape{(int)v[0], (int)v[1], (int)v[2]};
+                bool seen = false;
+                for (const auto &s : shapes) {
+                    seen |= (s.width == shape.width && s.height == shape.height && s.stride == shape.stride);
+                }
+                if (!seen) {
+                    debug(1) << "Specializing " << name << " for hot output shape "
+                             << shape.width << "x" << shape.height << ":" << shape.stride << "\n";
+                    shapes.push_back(shape);
+                }
+            }
+        }
+        for (const auto *input : pi.inputs()) {
+            for (const auto &p : input->parameters_) {
+                if (p.is_buffer() || !(p.type().is_int() || p.type().is_uint() || p.type().is_bool())) {
+                    continue;
+                }
+                Expr var = Variable::make(p.type(), p.name(), p);
+                for (const auto &v : hot_values(profile, p.name())) {
+                    if (v.size() != 1) continue;
+                    debug(1) << "Specializing " << name << " for hot value " << p.name() << " == " << v[0] << "\n";
+                    hot_param_conditions.push_back(var == make_const(p.type(), v[0]));
+                }
+            }
+        }
+    }
+
+    std::vector<Func> outputs = pipeline.outputs();
+    if (!shapes.empty()) {
+        // Add a specialization of each output for each of the
+        // expected shapes. Within them the output extents and
+        // strides are constants, so the simplifier can fold away
+        // the general stride handling and many of the checks. Other
+        // shapes take the original, generic path.
+        for (Func f : outputs) {
+            if (f.dimensions() < 2) continue;
+            for (const auto &shape : shapes) {
+                f.specialize(output_has_shape(f, shape));
+            }
+        }
+        user_assert(outputs[0].dimensions() >= 2)
+            << "shape_specializations requires the first output to have at least two dimensions.\n";
+    }
+
+    // These come after the shape specializations, so they are only
+    // taken by calls that match none of the shapes.
+    for (Func f : outputs) {
+        for (const Expr &cond : hot_param_conditions) {
+            f.specialize(cond);
+        }
+    }
+
+    if (!shapes.empty() || !hot_param_conditions.empty()) {
+        user_assert(outputs[0].function().definition().specializations().size() < halide_shape_dispatch_max_paths)
+            << "Too many specializations: " << shapes.size() << " shapes and "
+            << hot_param_conditions.size() << " hot values\n";
+        pipeline.add_custom_lowering_pass(new InjectShapeDispatch(name, outputs[0]));
+    }
+
     const GeneratorParamInfo &pi = param_info();
     std::vector<Argument> filter_arguments;
     for (const auto *input : pi.inputs()) {
@@ -229,6 +229,27 @@
  *    being targeted which may be used to enhance the automatically-generated
  *    schedule.
  *
+ *  There are also optional GeneratorParams used when building a Module (e.g. by
+ *  GenGen), which Generators should not read:
+ *
+ *      GeneratorParam<std::string> shape_specializations{"shape_specializations", ""};
+ *      GeneratorParam<std::string> specialization_profile{"specialization_profile", ""};
+ *
+ *  - 'shape_specializations' is a comma-separated list of output shapes, each of
+ *    the form WIDTHxHEIGHT or WIDTHxHEIGHT:STRIDE (e.g. "1920x1080:2048,640x480").
+ *    Each output Func gets a specialization for each shape, with constant
+ *    extents and row stride, checked in order before the generic schedule. The
+ *    pipeline calls halide_shape_dispatch() with the index of the path taken, so
+ *    the default runtime can report how often each shape was hit.
+ *  - 'specialization_profile' is the path of a file containing the output of
+ *    halide_param_profile_report() from a run of the pipeline compiled with the
+ *    param_profile target feature. Each output shape that accounted for at least
+ *    10% of calls is added to the shape specializations, and each output Func
+ *    gets a specialization for each integer scalar Input value that accounted
+ *    for at least 10% of calls (at most four per Input). These are tried after
+ *    the shape specializations, and are reported to halide_shape_dispatch() as
+ *    the paths following them.
+ *
  * Generators are added to a global registry to simplify AOT build mechanics; this
  * is done by simply using the HALIDE_REGISTER_GENERATOR macro at global scope:
  *
@@ -2226,6 +2247,7 @@ public:
     HALIDE_FORWARD_METHOD(Func, hexagon)
     HALIDE_FORWARD_METHOD(Func, in)
     HALIDE_FORWARD_METHOD(Func, memoize)
+    HALIDE_FORWARD_METHOD(Func, multiversion)
     HALIDE_FORWARD_METHOD_CONST(Func, num_update_definitions)
     HALIDE_FORWARD_METHOD_CONST(Func, output_types)
     HALIDE_FORWARD_METHOD_CONST(Func, outputs)
@@ -3273,6 +3295,10 @@ private:
 
     bool inputs_set{false};
     std::string generator_registered_name, generator_stub_name;
+
+    // Only used when building a Module; see the class comment.
+    GeneratorParam<std::string> shape_specializations{"shape_specializations", ""};
+    GeneratorParam<std::string> specialization_profile{"specialization_profile", ""};
     Pipeline pipeline;
 
     // Return our GeneratorParamInfo.
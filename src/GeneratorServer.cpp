@@ -0,0 +1,462 @@
+#include "GeneratorServer.h"
+#include "Generator.h"
+#include "ThreadPool.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+extern char **environ;
+#endif
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+#ifdef _WIN32
+
+int generator_server_main(int argc, char **argv, std::ostream &cerr, GenerateFilterMainFn run_job) {
+    cerr << "-server is not supported on Windows\n";
+    return 1;
+}
+
+bool run_on_generator_server(int argc, char **argv, std::ostream &cerr, int *result) {
+    return false;
+}
+
+#else
+
+namespace {
+
+// The exit code a server replies with for a job it won't run.
+const int32_t kJobNotServed = -1000;
+
+// A request is the identity of the client's executable, its working
+// directory, its environment, and the job's command line, each a count
+// followed by that many length-prefixed strings. A reply is the job's
+// exit code and everything it wrote to stdout and stderr.
+
+bool write_all(int fd, const void *data, size_t size) {
+    const char *p = (const char *)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool read_all(int fd, void *data, size_t size) {
+    char *p = (char *)data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool write_string(int fd, const string &s) {
+    uint32_t size = (uint32_t)s.size();
+    return write_all(fd, &size, sizeof(size)) &&
+           write_all(fd, s.data(), s.size());
+}
+
+bool read_string(int fd, string *s) {
+    uint32_t size;
+    if (!read_all(fd, &size, sizeof(size))) {
+        return false;
+    }
+    s->resize(size);
+    return size == 0 || read_all(fd, &(*s)[0], size);
+}
+
+bool write_strings(int fd, const vector<string> &strings) {
+    uint32_t count = (uint32_t)strings.size();
+    bool ok = write_all(fd, &count, sizeof(count));
+    for (size_t i = 0; ok && i < strings.size(); i++) {
+        ok = write_string(fd, strings[i]);
+    }
+    return ok;
+}
+
+bool read_strings(int fd, vector<string> *strings) {
+    uint32_t count = 0;
+    bool ok = read_all(fd, &count, sizeof(count));
+    for (uint32_t i = 0; ok && i < count; i++) {
+        strings->emplace_back();
+        ok = read_string(fd, &strings->back());
+    }
+    return ok;
+}
+
+// Read everything from fd until the other end is closed.
+string read_until_closed(int fd) {
+    string result;
+    char buf[4096];
+    while (true) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        result.append(buf, n);
+    }
+    return result;
+}
+
+// Identifies the executable of this process: its path, and the
+// device, inode and modification time of the file. A server only runs
+// jobs for clients with the same identity, so that a server built from
+// other sources, which may register generators with the same names,
+// never runs the job instead of the client. Returns the empty string
+// if the executable can't be found.
+string executable_identity() {
+    char path[PATH_MAX];
+#ifdef __APPLE__
+    char exe[PATH_MAX];
+    uint32_t size = sizeof(exe);
+    if (_NSGetExecutablePath(exe, &size) != 0 || !realpath(exe, path)) {
+        return string();
+    }
+#else
+    if (!realpath("/proc/self/exe", path)) {
+        return string();
+    }
+#endif
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return string();
+    }
+    return string(path) + ":" + std::to_string((uint64_t)st.st_dev) +
+           ":" + std::to_string((uint64_t)st.st_ino) +
+           ":" + std::to_string((int64_t)st.st_mtime);
+}
+
+bool make_socket_address(const string &path, sockaddr_un *addr, std::ostream &cerr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr->sun_path)) {
+        cerr << "Generator server socket path is too long: " << path << "\n";
+        return false;
+    }
+    strncpy(addr->sun_path, path.c_str(), sizeof(addr->sun_path) - 1);
+    return true;
+}
+
+// Only serve the user running the server. The socket is also created
+// without group or world access, but this doesn't depend on the
+// permissions of the directory it's in.
+bool is_same_user(int fd) {
+#ifdef SO_PEERCRED
+    ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 &&
+           cred.uid == geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+}
+
+// Held while forking a job and closing the parent's copy of the write
+// end of its output pipe, so that no other job's child inherits it and
+// keeps the pipe open after this job is done.
+std::mutex fork_mutex;
+
+// Run a job in a child process forked from the server. Jobs can't
+// share a process: Halide has process-wide state (the debug level,
+// caches initialized from environment variables, plugins loaded with
+// -p, the default autoscheduler set with -s, and anything a
+// generator's own static state touches), and an error in a build
+// without exceptions aborts. The child starts with everything the
+// server has already loaded and initialized. It runs in the client's
+// working directory with the client's environment, and its stdout and
+// stderr, including warnings and debug output, are captured for the
+// client.
+int32_t run_forked_job(const string &cwd, vector<string> &env, vector<string> &args,
+                       GenerateFilterMainFn run_job, string *output) {
+    int out[2];
+    pid_t pid;
+    {
+        std::lock_guard<std::mutex> lock(fork_mutex);
+        if (pipe(out) != 0) {
+            return kJobNotServed;
+        }
+        pid = fork();
+        if (pid != 0) {
+            close(out[1]);
+        }
+    }
+    if (pid < 0) {
+        close(out[0]);
+        return kJobNotServed;
+    }
+
+    if (pid == 0) {
+        close(out[0]);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(out[1], STDERR_FILENO);
+        close(out[1]);
+        if (chdir(cwd.c_str()) != 0) {
+            fprintf(stderr, "Generator server could not change to %s: %s\n", cwd.c_str(), strerror(errno));
+            _exit(1);
+        }
+#ifdef __APPLE__
+        static char *no_env[] = {nullptr};
+        environ = no_env;
+#else
+        clearenv();
+#endif
+        for (string &e : env) {
+            putenv(&e[0]);
+        }
+        vector<char *> argv;
+        for (string &a : args) {
+            argv.push_back(&a[0]);
+        }
+        argv.push_back(nullptr);
+        int result = run_job((int)args.size(), argv.data(), std::cerr);
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(nullptr);
+        // Skip the server's atexit handlers and static destructors.
+        _exit(result);
+    }
+
+    *output = read_until_closed(out[0]);
+    close(out[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        *output += "Generator job killed by signal " + std::to_string(WTERMSIG(status)) + "\n";
+    }
+    return 1;
+}
+
+void serve_job(int fd, const string *identity, const vector<string> *generator_names,
+               GenerateFilterMainFn run_job) {
+    if (!is_same_user(fd)) {
+        close(fd);
+        return;
+    }
+
+    string client_identity, cwd;
+    vector<string> env, args;
+    if (!read_string(fd, &client_identity) ||
+        !read_string(fd, &cwd) ||
+        !read_strings(fd, &env) ||
+        !read_strings(fd, &args) ||
+        args.empty()) {
+        close(fd);
+        return;
+    }
+
+    // Turn away jobs from other executables, and for generators that
+    // aren't linked into this binary. The client will run them itself.
+    int32_t result = 0;
+    string output;
+    auto g = std::find(args.begin(), args.end(), "-g");
+    if (identity->empty() || client_identity != *identity) {
+        result = kJobNotServed;
+    } else if (g != args.end() && g + 1 != args.end() &&
+               std::find(generator_names->begin(), generator_names->end(), *(g + 1)) == generator_names->end()) {
+        result = kJobNotServed;
+    } else {
+        result = run_forked_job(cwd, env, args, run_job, &output);
+    }
+
+    // If the client has gone away there's nobody to tell.
+    if (write_all(fd, &result, sizeof(result))) {
+        write_string(fd, output);
+    }
+    close(fd);
+}
+
+}  // namespace
+
+int generator_server_main(int argc, char **argv, std::ostream &cerr, GenerateFilterMainFn run_job) {
+    const char kUsage[] = "gengen -server SOCKET_PATH [-j NUM_THREADS]\n";
+    if (argc != 3 && argc != 5) {
+        cerr << kUsage;
+        return 1;
+    }
+    string socket_path = argv[2];
+    size_t num_threads = ThreadPool<void>::num_processors_online();
+    if (argc == 5) {
+        int j = string(argv[3]) == "-j" ? atoi(argv[4]) : 0;
+        if (j <= 0) {
+            cerr << kUsage;
+            return 1;
+        }
+        num_threads = j;
+    }
+
+    sockaddr_un addr;
+    if (!make_socket_address(socket_path, &addr, cerr)) {
+        return 1;
+    }
+
+    // A client that goes away mid-reply shouldn't take the server
+    // down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        cerr << "Could not create generator server socket: " << strerror(errno) << "\n";
+        return 1;
+    }
+    // Remove the socket left behind by a previous server, and create
+    // the new one with access for this user only. Anything else at
+    // that path is left alone.
+    struct stat st;
+    if (lstat(socket_path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            cerr << "Not starting a generator server on " << socket_path
+                 << ": a file that isn't a socket is already there\n";
+            close(listen_fd);
+            return 1;
+        }
+        unlink(socket_path.c_str());
+    }
+    mode_t old_umask = umask(0077);
+    int bind_result = bind(listen_fd, (sockaddr *)&addr, sizeof(addr));
+    umask(old_umask);
+    if (bind_result != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0) {
+        cerr << "Could not listen on " << socket_path << ": " << strerror(errno) << "\n";
+        close(listen_fd);
+        return 1;
+    }
+
+    cerr << "Serving generator jobs on " << socket_path
+         << " with " << num_threads << " threads\n";
+
+    // The pool's threads only talk to clients and wait for the
+    // children that run the jobs, so they never hold any of Halide's
+    // locks when another thread forks.
+    const string identity = executable_identity();
+    if (identity.empty()) {
+        cerr << "Generator server can't identify its own executable, so it won't serve any jobs\n";
+    }
+    const vector<string> generator_names = GeneratorRegistry::enumerate();
+    ThreadPool<void> pool(num_threads);
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            cerr << "Generator server stopped accepting jobs: " << strerror(errno) << "\n";
+            break;
+        }
+        pool.async(serve_job, fd, &identity, &generator_names, run_job);
+    }
+
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return 1;
+}
+
+bool run_on_generator_server(int argc, char **argv, std::ostream &cerr, int *result) {
+    string socket_path = get_env_variable("HL_GENGEN_SERVER");
+    if (socket_path.empty()) {
+        return false;
+    }
+
+    // The job runs in this process's working directory and
+    // environment, so relative paths in its arguments (-o, or a
+    // GeneratorParam like specialization_profile) and HL_*
+    // variables mean the same as they would here.
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        return false;
+    }
+    vector<string> env;
+    for (char **e = environ; *e; e++) {
+        env.emplace_back(*e);
+    }
+    vector<string> args(argv, argv + argc);
+    string identity = executable_identity();
+    if (identity.empty()) {
+        return false;
+    }
+
+    sockaddr_un addr;
+    if (!make_socket_address(socket_path, &addr, cerr)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        // No server running. Not an error; just do it ourselves.
+        close(fd);
+        return false;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int32_t code = 0;
+    string output;
+    bool ok = write_string(fd, identity) &&
+              write_string(fd, cwd) &&
+              write_strings(fd, env) &&
+              write_strings(fd, args) &&
+              read_all(fd, &code, sizeof(code)) &&
+              read_string(fd, &output);
+    close(fd);
+
+    // If the server went away or couldn't start the job, run it here.
+    if (!ok || code == kJobNotServed) {
+        return false;
+    }
+    cerr << output;
+    *result = code;
+    return true;
+}
+
+#endif
+
+}  // namespace Internal
+}  // namespace Halide
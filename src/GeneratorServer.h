@@ -0,0 +1,45 @@
+#ifndef HALIDE_GENERATOR_SERVER_H
+#define HALIDE_GENERATOR_SERVER_H
+
+/** \file
+ *
+ * A compile server mode for generator binaries, so that a build that
+ * runs many generators pays for process startup and LLVM
+ * initialization once rather than once per generator.
+ */
+
+#include <iostream>
+#include <string>
+
+namespace Halide {
+namespace Internal {
+
+/** The signature of generate_filter_main() */
+typedef int (*GenerateFilterMainFn)(int argc, char **argv, std::ostream &cerr);
+
+/** Implements "gengen -server SOCKET_PATH [-j NUM_THREADS]". Listens on
+ * a unix domain socket at SOCKET_PATH, which only the current user can
+ * connect to, and runs each job a client sends (a gengen command line)
+ * with run_job, at most NUM_THREADS (defaulting to the number of cores)
+ * at a time. Each job runs in its own process forked from the server,
+ * in the client's working directory and environment, and everything it
+ * writes to stdout and stderr is sent back to the client. Jobs from
+ * clients that aren't this same executable (by path, inode and
+ * modification time), and jobs for generators not registered in this
+ * binary, are turned away, so that the client can run them itself.
+ * Fails if something other than a socket is already at SOCKET_PATH.
+ * Runs until killed. */
+int generator_server_main(int argc, char **argv, std::ostream &cerr, GenerateFilterMainFn run_job);
+
+/** If the environment variable HL_GENGEN_SERVER names the socket of a
+ * running generator server, send it this command line, copy what the
+ * job wrote to stdout and stderr into cerr, set *result to its exit
+ * code, and return true. Returns false if there's no server to talk
+ * to or the server won't run the job; the caller should then run the
+ * job in-process. */
+bool run_on_generator_server(int argc, char **argv, std::ostream &cerr, int *result);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -599,6 +599,7 @@ const char *const intrinsic_op_names[] = {
     "glsl_texture_store",
     "glsl_varying",
     "gpu_thread_barrier",
+    "has_target_features",
     "if_then_else",
     "if_then_else_mask",
     "image_load",
@@ -512,6 +512,7 @@ struct Call : public ExprNode<Call> {
         glsl_texture_store,
         glsl_varying,
         gpu_thread_barrier,
+        has_target_features,
         if_then_else,
         if_then_else_mask,
         image_load,
@@ -712,6 +712,158 @@ Expr halide_erf(Expr x_full) {
     return result;
 }
 
+namespace {
+
+// Subtract the nearest multiple k of pi/2 from x, leaving a value in
+// [-pi/4, pi/4]. pi/2 is split into four parts with few enough bits
+// that the products with k are exact for |x| < 8192 (Cody and Waite).
+// CodeGen_LLVM calls libm for lanes outside that range.
+void range_reduce_trig(const Expr &x, Expr *reduced, Expr *quadrant) {
+    Type type = x.type();
+    Expr k_real = floor(x * 0.636619772367581343f + 0.5f);
+    Expr r = x - k_real * 1.5703125f;
+    r -= k_real * 4.8351287841796875e-4f;
+    r -= k_real * 3.138557076454162598e-7f;
+    r -= k_real * 6.077100628276710381e-11f;
+    *reduced = r;
+    *quadrant = cast(Int(32, type.lanes()), k_real);
+}
+
+// Polynomials for sin and cos on [-pi/4, pi/4], from Cephes.
+Expr sin_reduced(const Expr &x) {
+    float coeff[] = {
+        -1.9515295891e-4f,
+        8.3321608736e-3f,
+        -1.6666654611e-1f};
+    Expr x2 = x * x;
+    return evaluate_polynomial(x2, coeff, sizeof(coeff) / sizeof(coeff[0])) * x2 * x + x;
+}
+
+Expr cos_reduced(const Expr &x) {
+    float coeff[] = {
+        2.443315711809948e-5f,
+        -1.388731625493765e-3f,
+        4.166664568298827e-2f};
+    Expr x2 = x * x;
+    return evaluate_polynomial(x2, coeff, sizeof(coeff) / sizeof(coeff[0])) * x2 * x2 - x2 * 0.5f + 1.0f;
+}
+
+Expr halide_sin_cos(const Expr &x_full, bool is_cos) {
+    Type type = x_full.type();
+    internal_assert(type.element_of() == Float(32));
+
+    Expr x, k;
+    range_reduce_trig(x_full, &x, &k);
+    if (is_cos) {
+        k += 1;
+    }
+
+    // Odd quadrants use the other function, and the upper two
+    // quadrants are negated.
+    Expr result = select((k & 1) == 1, cos_reduced(x), sin_reduced(x));
+    result = select((k & 2) == 2, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+}  // namespace
+
+Expr halide_sin(Expr x) {
+    return halide_sin_cos(x, false);
+}
+
+Expr halide_cos(Expr x) {
+    return halide_sin_cos(x, true);
+}
+
+Expr halide_tan(Expr x_full) {
+    Type type = x_full.type();
+    internal_assert(type.element_of() == Float(32));
+
+    Expr x, k;
+    range_reduce_trig(x_full, &x, &k);
+
+    // tan on [-pi/4, pi/4], from Cephes.
+    float coeff[] = {
+        9.38540185543e-3f,
+        3.11992232697e-3f,
+        2.44301354525e-2f,
+        5.34112807005e-2f,
+        1.33387994085e-1f,
+        3.33331568548e-1f};
+    Expr x2 = x * x;
+    Expr result = evaluate_polynomial(x2, coeff, sizeof(coeff) / sizeof(coeff[0])) * x2 * x + x;
+
+    // In odd quadrants, tan(x + pi/2) = -1 / tan(x)
+    result = select((k & 1) == 1, -1.0f / result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr halide_atan2(Expr y, Expr x) {
+    Type type = x.type();
+    internal_assert(type.element_of() == Float(32) && y.type() == type);
+    Type int_type = Int(32, type.lanes());
+
+    // Compute the angle in the first octant, then reflect it into
+    // place. Using the ratio of the smaller to the larger magnitude
+    // avoids dividing by zero or overflowing.
+    Expr ax = abs(x), ay = abs(y);
+    Expr hi = max(ax, ay), lo = min(ax, ay);
+    Expr t = select(hi == 0.0f, make_zero(type),
+                    hi == lo, make_one(type),  // Both infinite
+                    lo / hi);
+
+    // Reduce further to [-tan(pi/8), tan(pi/8)] using
+    // atan(t) = pi/4 + atan((t - 1) / (t + 1))
+    Expr large = t > 0.414213562373095f;
+    t = select(large, (t - 1.0f) / (t + 1.0f), t);
+
+    // atan on [-tan(pi/8), tan(pi/8)], from Cephes.
+    float coeff[] = {
+        8.05374449538e-2f,
+        -1.38776856032e-1f,
+        1.99777106478e-1f,
+        -3.33329491539e-1f};
+    Expr t2 = t * t;
+    Expr result = evaluate_polynomial(t2, coeff, sizeof(coeff) / sizeof(coeff[0])) * t2 * t + t;
+    result += select(large, 0.785398163397448f, 0.0f);
+
+    result = select(ay > ax, 1.57079632679489662f - result, result);
+    // Use the sign bits, so that negative zeros give the same
+    // results as in libm.
+    result = select(reinterpret(int_type, x) < 0, 3.14159265358979324f - result, result);
+    result = select(reinterpret(int_type, y) < 0, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr halide_tanh(Expr x_full) {
+    Type type = x_full.type();
+    internal_assert(type.element_of() == Float(32));
+
+    Expr x = abs(x_full);
+
+    // Near zero, an odd polynomial from Cephes.
+    float coeff[] = {
+        -5.70498872745e-3f,
+        2.06390887954e-2f,
+        -5.37397155531e-2f,
+        1.33314422036e-1f,
+        -3.33332819422e-1f};
+    Expr x2 = x * x;
+    Expr small = evaluate_polynomial(x2, coeff, sizeof(coeff) / sizeof(coeff[0])) * x2 * x + x;
+
+    // Elsewhere, 1 - 2 / (e^2x + 1). This rounds to one for x > 9.1,
+    // so clamp x to keep e^2x finite.
+    Expr large = 1.0f - 2.0f / (halide_exp(min(x, 10.0f) * 2.0f) + 1.0f);
+
+    Expr result = select(x < 0.625f, small, large);
+    result = select(x_full < 0.0f, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
 Expr raise_to_integer_power(Expr e, int64_t p) {
     Expr result;
     if (p == 0) {
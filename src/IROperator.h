@@ -194,6 +194,20 @@ Expr halide_exp(Expr a);
 Expr halide_erf(Expr a);
 // @}
 
+/** Halide's vectorizable trigonometric and hyperbolic functions for
+ * Float(32), used in place of libm's for vectorized code. sin and cos
+ * are within 3 ulp of the correctly rounded result, tan and atan2
+ * within 4 ulp, and tanh within 2 ulp. sin, cos and tan are only
+ * this accurate for |a| < 8192; codegen calls libm for lanes outside
+ * that range. */
+// @{
+Expr halide_sin(Expr a);
+Expr halide_cos(Expr a);
+Expr halide_tan(Expr a);
+Expr halide_atan2(Expr y, Expr x);
+Expr halide_tanh(Expr a);
+// @}
+
 /** Raise an expression to an integer power by repeatedly multiplying
  * it by itself. */
 Expr raise_to_integer_power(Expr a, int64_t b);
@@ -798,8 +812,12 @@ inline Tuple tuple_select(const Expr &c0, const Tuple &v0, const Expr &c1, const
 // @}
 
 /** Return the sine of a floating-point expression. If the argument is
- * not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * not floating-point, it is cast to Float(32). For vectors of
+ * Float(32), uses a vectorizable implementation accurate to 3 ulp,
+ * which falls back to the system sin function for vectors with any
+ * lane outside |x| < 8192. Otherwise calls the system sin
+ * function, which does not vectorize well. The StrictFloat target
+ * feature selects the system function for vectors too. */
 Expr sin(Expr x);
 
 /** Return the arcsine of a floating-point expression. If the argument
@@ -808,8 +826,12 @@ Expr sin(Expr x);
 Expr asin(Expr x);
 
 /** Return the cosine of a floating-point expression. If the argument
- * is not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * is not floating-point, it is cast to Float(32). For vectors of
+ * Float(32), uses a vectorizable implementation accurate to 3 ulp,
+ * which falls back to the system cos function for vectors with any
+ * lane outside |x| < 8192. Otherwise calls the system cos
+ * function, which does not vectorize well. The StrictFloat target
+ * feature selects the system function for vectors too. */
 Expr cos(Expr x);
 
 /** Return the arccosine of a floating-point expression. If the
@@ -818,8 +840,12 @@ Expr cos(Expr x);
 Expr acos(Expr x);
 
 /** Return the tangent of a floating-point expression. If the argument
- * is not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * is not floating-point, it is cast to Float(32). For vectors of
+ * Float(32), uses a vectorizable implementation accurate to 4 ulp,
+ * which falls back to the system tan function for vectors with any
+ * lane outside |x| < 8192. Otherwise calls the system tan
+ * function, which does not vectorize well. The StrictFloat target
+ * feature selects the system function for vectors too. */
 Expr tan(Expr x);
 
 /** Return the arctangent of a floating-point expression. If the
@@ -828,8 +854,10 @@ Expr tan(Expr x);
 Expr atan(Expr x);
 
 /** Return the angle of a floating-point gradient. If the argument is
- * not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * not floating-point, it is cast to Float(32). For vectors of
+ * Float(32), uses a vectorizable implementation accurate to 4 ulp,
+ * unless the target has the StrictFloat feature. Otherwise calls the
+ * system atan2 function, which does not vectorize well. */
 Expr atan2(Expr y, Expr x);
 
 /** Return the hyperbolic sine of a floating-point expression.  If the
@@ -853,8 +881,10 @@ Expr cosh(Expr x);
 Expr acosh(Expr x);
 
 /** Return the hyperbolic tangent of a floating-point expression.  If
- * the argument is not floating-point, it is cast to Float(32). Does
- * not vectorize well. */
+ * the argument is not floating-point, it is cast to Float(32). For
+ * vectors of Float(32), uses a vectorizable implementation accurate
+ * to 2 ulp, unless the target has the StrictFloat feature. Otherwise
+ * calls the system tanh function, which does not vectorize well. */
 Expr tanh(Expr x);
 
 /** Return the hyperbolic arctangent of a floating-point expression.
@@ -0,0 +1,261 @@
+#include "InvariantDivision.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The names of the values computed before a loop for one divisor.
+struct Divisor {
+    Expr value;
+    string magic, shift1, shift2, mask, sign;
+};
+
+bool is_supported_type(Type t) {
+    return (t.is_int() || t.is_uint()) &&
+           (t.bits() == 8 || t.bits() == 16 || t.bits() == 32);
+}
+
+// Compute the values the divisions by d inside a loop need, and wrap
+// the loop in them. With N bits, l = ceil(log2(|d|)), the multiplier
+// is floor(2^N * (2^l - |d|) / |d|) + 1, and the quotient of n is
+// (t + ((n - t) >> min(l, 1))) >> max(l - 1, 0), where t is the high
+// half of n times the multiplier. This needs no special case for
+// |d| == 1.
+Stmt compute_divisor(const Divisor &div, Stmt s) {
+    Expr d = div.value;
+    Type t = d.type();
+    int bits = t.bits();
+    Type ut = t.with_code(Type::UInt);
+    Type wide = ut.with_bits(bits * 2);
+
+    vector<pair<string, Expr>> lets;
+    Expr abs_d = d;
+    if (t.is_int()) {
+        // All ones if d is negative. Division rounds such that the
+        // remainder is positive, so n / d == -(n / |d|) for negative d.
+        lets.emplace_back(div.sign, d >> make_const(t, bits - 1));
+        Expr sign = Variable::make(t, div.sign);
+        // Subtract in the unsigned type, as |INT_MIN| overflows the
+        // signed one.
+        abs_d = cast(ut, d ^ sign) - cast(ut, sign);
+    }
+    string abs_name = div.magic + ".abs";
+    lets.emplace_back(abs_name, abs_d);
+    abs_d = Variable::make(ut, abs_name);
+
+    // Division by zero gives zero. Divide by one instead and mask off
+    // the result.
+    Expr nonzero_d = cast(wide, max(abs_d, make_one(ut)));
+
+    // ceil(log2(|d|)) is the number of bits in |d| - 1. Shifting in a
+    // one first keeps the argument of the count nonzero.
+    string log2_name = div.magic + ".log2";
+    Expr x = nonzero_d - make_one(wide);
+    lets.emplace_back(log2_name, make_const(wide, bits * 2 - 1) -
+                                     count_leading_zeros(x * make_const(wide, 2) + make_one(wide)));
+    Expr l = Variable::make(wide, log2_name);
+
+    Expr magic = (((make_one(wide) << l) - nonzero_d) << make_const(wide, bits)) / nonzero_d + make_one(wide);
+    lets.emplace_back(div.magic, cast(ut, magic));
+    lets.emplace_back(div.shift1, cast(ut, min(l, make_one(wide))));
+    lets.emplace_back(div.shift2, cast(ut, max(l, make_one(wide)) - make_one(wide)));
+    lets.emplace_back(div.mask, select(abs_d == make_zero(ut), make_zero(t), cast(t, ut.max())));
+
+    for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+        s = LetStmt::make(it->first, it->second, s);
+    }
+    return s;
+}
+
+// Replace the divisions in a loop body whose divisors don't depend on
+// anything the loop body defines.
+class ReplaceInvariantDivision : public IRMutator {
+    using IRMutator::visit;
+
+    Scope<> defined;
+
+    Expr invariant_divisor(Type t, const Expr &b) {
+        if (!is_supported_type(t) || is_const(b)) {
+            return Expr();
+        }
+        Expr d = b;
+        if (t.is_vector()) {
+            const Broadcast *bc = b.as<Broadcast>();
+            if (!bc || !bc->value.type().is_scalar()) {
+                return Expr();
+            }
+            d = bc->value;
+        }
+        if (expr_uses_vars(d, defined) || !is_pure(d)) {
+            return Expr();
+        }
+        return d;
+    }
+
+    Divisor find_or_add(const Expr &d) {
+        for (const Divisor &div : divisors) {
+            if (equal(div.value, d)) {
+                return div;
+            }
+        }
+        string prefix = unique_name('d');
+        divisors.push_back({d, prefix + ".magic", prefix + ".shift1",
+                            prefix + ".shift2", prefix + ".mask", prefix + ".sign"});
+        return divisors.back();
+    }
+
+    Expr quotient(const Expr &n, const Divisor &div) {
+        Type t = n.type();
+        int bits = t.bits();
+        int lanes = t.lanes();
+        Type ut = t.with_code(Type::UInt);
+        Type wide = ut.with_bits(bits * 2);
+        auto scalar = [&](const string &name, Type st) {
+            Expr v = Variable::make(st, name);
+            return lanes > 1 ? Broadcast::make(v, lanes) : v;
+        };
+
+        string n_name = unique_name('n');
+        Expr num = Variable::make(t, n_name);
+        string sign_name, u_name = unique_name('u');
+        Expr sign, u;
+        if (t.is_int()) {
+            // Flip the bits of negative numerators, divide, and flip
+            // them back, to round towards negative infinity.
+            sign_name = unique_name('s');
+            sign = Variable::make(t, sign_name);
+            u = cast(ut, num ^ sign);
+        } else {
+            u = num;
+        }
+        Expr u_var = Variable::make(ut, u_name);
+
+        // Multiply-keep-high-half
+        Expr hi = cast(ut, (cast(wide, u_var) * cast(wide, scalar(div.magic, ut.element_of()))) >>
+                               make_const(wide, bits));
+        Expr q = (hi + ((u_var - hi) >> scalar(div.shift1, ut.element_of()))) >>
+                 scalar(div.shift2, ut.element_of());
+
+        if (t.is_int()) {
+            Expr dsign = scalar(div.sign, t.element_of());
+            q = cast(t, q) ^ sign;
+            // Negating INT_MIN overflows, so do it in the unsigned type.
+            q = cast(t, cast(ut, q ^ dsign) - cast(ut, dsign));
+        }
+        q = q & scalar(div.mask, t.element_of());
+
+        q = Let::make(u_name, u, q);
+        if (t.is_int()) {
+            q = Let::make(sign_name, num >> make_const(t, bits - 1), q);
+        }
+        return Let::make(n_name, n, q);
+    }
+
+    Expr visit(const Div *op) override {
+        Expr a = mutate(op->a);
+        Expr b = mutate(op->b);
+        Expr d = invariant_divisor(op->type, b);
+        if (!d.defined()) {
+            if (a.same_as(op->a) && b.same_as(op->b)) {
+                return op;
+            }
+            return Div::make(a, b);
+        }
+        return quotient(a, find_or_add(d));
+    }
+
+    Expr visit(const Mod *op) override {
+        Expr a = mutate(op->a);
+        Expr b = mutate(op->b);
+        Expr d = invariant_divisor(op->type, b);
+        if (!d.defined()) {
+            if (a.same_as(op->a) && b.same_as(op->b)) {
+                return op;
+            }
+            return Mod::make(a, b);
+        }
+        Divisor div = find_or_add(d);
+        string n_name = unique_name('n');
+        Expr num = Variable::make(a.type(), n_name);
+        Expr mask = Variable::make(op->type.element_of(), div.mask);
+        if (op->type.is_vector()) {
+            mask = Broadcast::make(mask, op->type.lanes());
+        }
+        // The quotient is zero when b is zero, and so is the result.
+        Expr r = (num - quotient(num, div) * b) & mask;
+        return Let::make(n_name, a, r);
+    }
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        ScopedBinding<> bind(defined, op->name);
+        Expr body = mutate(op->body);
+        return Let::make(op->name, value, body);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        Expr value = mutate(op->value);
+        ScopedBinding<> bind(defined, op->name);
+        Stmt body = mutate(op->body);
+        return LetStmt::make(op->name, value, body);
+    }
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+        ScopedBinding<> bind(defined, op->name);
+        return IRMutator::visit(op);
+    }
+
+public:
+    vector<Divisor> divisors;
+
+    ReplaceInvariantDivision(const string &loop_var) {
+        defined.push(loop_var);
+    }
+};
+
+class OptimizeInvariantDivision : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+
+        // Divisors that are invariant in this loop are computed
+        // before it. Then look for divisors that are only invariant in
+        // loops further in.
+        ReplaceInvariantDivision replacer(op->name);
+        Stmt body = replacer.mutate(op->body);
+        body = mutate(body);
+
+        Stmt s = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        for (auto it = replacer.divisors.rbegin(); it != replacer.divisors.rend(); it++) {
+            s = compute_divisor(*it, s);
+        }
+        return s;
+    }
+};
+
+}  // namespace
+
+Stmt optimize_invariant_division(const Stmt &s) {
+    return OptimizeInvariantDivision().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
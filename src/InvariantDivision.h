@@ -0,0 +1,27 @@
+#ifndef HALIDE_INVARIANT_DIVISION_H
+#define HALIDE_INVARIANT_DIVISION_H
+
+/** \file
+ * Defines the lowering pass that replaces integer division by
+ * loop-invariant values with multiplies and shifts.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find integer divisions and mods inside loops whose divisor is not
+ * a constant but doesn't change inside the loop, e.g. a division by a
+ * scalar Param. Computes a multiplier and shifts for each such divisor
+ * before the loop (using the method of Granlund and Montgomery, as in
+ * libdivide), and replaces the divisions inside the loop with a
+ * multiply-keep-high-half and shifts, which unlike division vectorize
+ * on x86 and ARM. Handles 8, 16 and 32-bit integers. Device loops are
+ * left alone. */
+Stmt optimize_invariant_division(const Stmt &s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
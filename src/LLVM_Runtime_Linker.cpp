@@ -123,6 +123,7 @@ DECLARE_CPP_INITMOD(osx_get_symbol)
 DECLARE_CPP_INITMOD(osx_host_cpu_count)
 DECLARE_CPP_INITMOD(osx_opengl_context)
 DECLARE_CPP_INITMOD(osx_yield)
+DECLARE_CPP_INITMOD(param_profile)
 DECLARE_CPP_INITMOD(posix_abort)
 DECLARE_CPP_INITMOD(posix_allocator)
 DECLARE_CPP_INITMOD(posix_clock)
@@ -146,6 +147,7 @@ DECLARE_CPP_INITMOD(qurt_threads)
 DECLARE_CPP_INITMOD(qurt_threads_tsan)
 DECLARE_CPP_INITMOD(qurt_yield)
 DECLARE_CPP_INITMOD(runtime_api)
+DECLARE_CPP_INITMOD(shape_dispatch)
 DECLARE_CPP_INITMOD(ssp)
 DECLARE_CPP_INITMOD(to_string)
 DECLARE_CPP_INITMOD(trace_helper)
@@ -744,6 +746,8 @@ std::unique_ptr<llvm::Module> link_with_wasm_jit_runtime(llvm::LLVMContext *c, c
     modules.push_back(get_initmod_metadata(c, bits_64, debug));
     modules.push_back(get_initmod_float16_t(c, bits_64, debug));
     modules.push_back(get_initmod_errors(c, bits_64, debug));
+    modules.push_back(get_initmod_shape_dispatch(c, bits_64, debug));
+    modules.push_back(get_initmod_param_profile(c, bits_64, debug));
     modules.push_back(get_initmod_posix_abort(c, bits_64, debug));
     modules.push_back(get_initmod_msan_stubs(c, bits_64, debug));
 
@@ -974,6 +978,8 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
             modules.push_back(get_initmod_metadata(c, bits_64, debug));
             modules.push_back(get_initmod_float16_t(c, bits_64, debug));
             modules.push_back(get_initmod_errors(c, bits_64, debug));
+            modules.push_back(get_initmod_shape_dispatch(c, bits_64, debug));
+            modules.push_back(get_initmod_param_profile(c, bits_64, debug));
 
             // Note that we deliberately include this module, even if Target::LegacyBufferWrappers
             // isn't enabled: it isn't much code, and it makes it much easier to
@@ -1250,6 +1256,39 @@ std::unique_ptr<llvm::Module> get_initial_module_for_ptx_device(Target target, l
 }
 #endif
 
+void add_feature_initmods_to_module(llvm::Module &module, const Target &base, const Target &t) {
+    llvm::LLVMContext *c = &module.getContext();
+    std::vector<std::unique_ptr<llvm::Module>> modules;
+    if (t.arch == Target::X86) {
+        if (t.has_feature(Target::SSE41) && !base.has_feature(Target::SSE41)) {
+            modules.push_back(get_initmod_x86_sse41_ll(c));
+        }
+        if (t.has_feature(Target::AVX) && !base.has_feature(Target::AVX)) {
+            modules.push_back(get_initmod_x86_avx_ll(c));
+        }
+        if (t.has_feature(Target::AVX2) && !base.has_feature(Target::AVX2)) {
+            modules.push_back(get_initmod_x86_avx2_ll(c));
+        }
+    }
+
+    for (auto &m : modules) {
+        m->setDataLayout(module.getDataLayout());
+        m->setTargetTriple(module.getTargetTriple());
+        // These are only called from the functions compiled for t,
+        // and must not survive into the object file on their own, as
+        // they would be compiled for the base target.
+        for (auto &f : *m) {
+            if (!f.isDeclaration()) {
+                f.setLinkage(llvm::GlobalValue::LinkOnceODRLinkage);
+            }
+        }
+        bool failed = llvm::Linker::linkModules(module, std::move(m));
+        if (failed) {
+            internal_error << "Failure linking in feature-specific initial modules\n";
+        }
+    }
+}
+
 void add_bitcode_to_module(llvm::LLVMContext *context, llvm::Module &module,
                            const std::vector<uint8_t> &bitcode, const std::string &name) {
     llvm::StringRef sb = llvm::StringRef((const char *)&bitcode[0], bitcode.size());
@@ -27,6 +27,12 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target, llvm::LLVMCo
 /** Create an llvm module containing the support code for ptx device. */
 std::unique_ptr<llvm::Module> get_initial_module_for_ptx_device(Target, llvm::LLVMContext *c);
 
+/** Link the target-specific support code that code compiled for
+ * target t needs, and that the initial module for target base lacks,
+ * into an existing module. Used when some functions in the module are
+ * compiled for more CPU features than the module as a whole. */
+void add_feature_initmods_to_module(llvm::Module &module, const Target &base, const Target &t);
+
 /** Link a block of llvm bitcode into an llvm module. */
 void add_bitcode_to_module(llvm::LLVMContext *context, llvm::Module &module,
                            const std::vector<uint8_t> &bitcode, const std::string &name);
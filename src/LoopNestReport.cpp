@@ -0,0 +1,358 @@
+#include "LoopNestReport.h"
+#include "Bounds.h"
+#include "Debug.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "RegionCosts.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Substitute.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+string json_string(const string &s) {
+    std::ostringstream os;
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (c == '\n') {
+            os << "\\n";
+        } else if ((unsigned char)c < 0x20) {
+            // Nothing else in a printed Expr should need escaping.
+            os << ' ';
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+    return os.str();
+}
+
+template<typename T>
+string json_printed(const T &x) {
+    std::ostringstream os;
+    os << x;
+    return json_string(os.str());
+}
+
+// The measured time per run of each Func in each pipeline, in
+// milliseconds, read from the output of halide_profiler_snapshot_report.
+typedef map<string, map<string, double>> MeasuredTimes;
+
+MeasuredTimes read_measured_times(const string &filename) {
+    MeasuredTimes result;
+    std::ifstream f(filename);
+    user_assert(f.is_open()) << "Could not open profile " << filename << "\n";
+    string line;
+    while (std::getline(f, line)) {
+        std::istringstream in(line);
+        string tag, pipeline, func;
+        uint64_t time;
+        int runs, sampled_runs;
+        in >> tag;
+        if (tag != "halide_profiler_snapshot") {
+            continue;
+        }
+        if (in >> pipeline >> func >> time >> runs >> sampled_runs && sampled_runs > 0) {
+            result[pipeline][func] = time / (sampled_runs * 1000000.0);
+        }
+    }
+    return result;
+}
+
+class LoopNestReport : public IRVisitor {
+    using IRVisitor::visit;
+
+    std::ostream &out;
+    const map<string, double> *measured = nullptr;
+
+    // The estimated values of the variables that are known to be
+    // constant. Names of arguments with estimates are never rebound.
+    map<string, Expr> constants;
+    set<string> estimated_args;
+
+    // Bounds on the loop variables and any other integer variables
+    // that aren't constant.
+    Scope<Interval> bounds;
+
+    // How many times the current statement runs per call of the
+    // function, or negative if unknown.
+    double trips = 1;
+
+    struct Production {
+        double arith = 0, bytes_loaded = 0, bytes_stored = 0;
+        bool known = true;
+        int vector_width = 1;
+    };
+    vector<Production> productions;
+
+    int indent = 0;
+    vector<bool> need_comma;
+
+    Indentation get_indent() const {
+        return Indentation{indent};
+    }
+
+    void open_array() {
+        out << "[";
+        indent += 2;
+        need_comma.push_back(false);
+    }
+
+    void close_array() {
+        indent -= 2;
+        if (need_comma.back()) {
+            out << "\n"
+                << get_indent();
+        }
+        need_comma.pop_back();
+        out << "]";
+    }
+
+    void begin_item() {
+        if (need_comma.back()) {
+            out << ",";
+        }
+        need_comma.back() = true;
+        out << "\n"
+            << get_indent();
+    }
+
+    // An upper bound on the value of e, if one can be found.
+    bool upper_bound(const Expr &e, int64_t *result) {
+        Expr v = simplify(substitute(constants, e));
+        if (const int64_t *i = as_const_int(v)) {
+            *result = *i;
+            return true;
+        }
+        Interval b = bounds_of_expr_in_scope(v, bounds);
+        if (b.has_upper_bound()) {
+            if (const int64_t *i = as_const_int(simplify(b.max))) {
+                *result = *i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    string estimate_json(bool known, double value) {
+        if (!known) {
+            return "null";
+        }
+        std::ostringstream os;
+        os << value;
+        return os.str();
+    }
+
+    void visit(const LetStmt *op) override {
+        if (estimated_args.count(op->name)) {
+            op->body.accept(this);
+            return;
+        }
+        Expr value = simplify(substitute(constants, op->value));
+        if (is_const(value)) {
+            auto old = constants.find(op->name);
+            Expr old_value = old == constants.end() ? Expr() : old->second;
+            constants[op->name] = value;
+            op->body.accept(this);
+            if (old_value.defined()) {
+                constants[op->name] = old_value;
+            } else {
+                constants.erase(op->name);
+            }
+        } else if (value.type().is_int() || value.type().is_uint()) {
+            ScopedBinding<Interval> bind(bounds, op->name, bounds_of_expr_in_scope(value, bounds));
+            op->body.accept(this);
+        } else {
+            op->body.accept(this);
+        }
+    }
+
+    void visit(const For *op) override {
+        int64_t extent = 0;
+        bool known_extent = upper_bound(op->extent, &extent);
+        double old_trips = trips;
+        trips = (known_extent && trips >= 0) ? trips * extent : -1;
+
+        begin_item();
+        out << "{\"kind\": \"loop\", \"name\": " << json_string(op->name)
+            << ", \"for_type\": " << json_printed(op->for_type);
+        if (op->device_api != DeviceAPI::None) {
+            out << ", \"device_api\": " << json_printed(op->device_api);
+        }
+        out << ", \"min\": " << json_printed(op->min)
+            << ", \"extent\": " << json_printed(op->extent)
+            << ", \"estimated_extent\": " << estimate_json(known_extent, extent)
+            << ", \"estimated_trips\": " << estimate_json(trips >= 0, trips)
+            << ", \"body\": ";
+        open_array();
+        {
+            Expr loop_min = simplify(substitute(constants, op->min));
+            Expr loop_max = simplify(substitute(constants, op->min + op->extent - 1));
+            Interval b(bounds_of_expr_in_scope(loop_min, bounds).min,
+                       bounds_of_expr_in_scope(loop_max, bounds).max);
+            ScopedBinding<Interval> bind(bounds, op->name, b);
+            op->body.accept(this);
+        }
+        close_array();
+        out << "}";
+
+        trips = old_trips;
+    }
+
+    void visit(const ProducerConsumer *op) override {
+        if (!op->is_producer) {
+            op->body.accept(this);
+            return;
+        }
+
+        begin_item();
+        out << "{\"kind\": \"produce\", \"name\": " << json_string(op->name)
+            << ", \"body\": ";
+        open_array();
+        productions.emplace_back();
+        op->body.accept(this);
+        Production p = productions.back();
+        productions.pop_back();
+        close_array();
+
+        out << ", \"vector_width\": " << p.vector_width
+            << ", \"estimated_arith\": " << estimate_json(p.known, p.arith)
+            << ", \"estimated_bytes_loaded\": " << estimate_json(p.known, p.bytes_loaded)
+            << ", \"estimated_bytes_stored\": " << estimate_json(p.known, p.bytes_stored);
+        if (measured) {
+            auto it = measured->find(op->name);
+            if (it != measured->end()) {
+                out << ", \"measured_ms_per_run\": " << it->second;
+            }
+        }
+        out << "}";
+    }
+
+    void visit(const Store *op) override {
+        if (productions.empty()) {
+            return;
+        }
+        Production &p = productions.back();
+        p.vector_width = std::max(p.vector_width, op->value.type().lanes());
+        if (trips < 0) {
+            p.known = false;
+            return;
+        }
+        Cost cost = compute_expr_cost(op->value, false);
+        const int64_t *arith = as_const_int(cost.arith);
+        const int64_t *memory = as_const_int(cost.memory);
+        if (!arith || !memory) {
+            p.known = false;
+            return;
+        }
+        p.arith += trips * *arith;
+        p.bytes_loaded += trips * *memory;
+        p.bytes_stored += trips * op->value.type().bytes() * op->value.type().lanes();
+    }
+
+    void visit(const Allocate *op) override {
+        double bytes = op->type.bytes() * op->type.lanes();
+        bool known = true;
+        begin_item();
+        out << "{\"kind\": \"allocate\", \"name\": " << json_string(op->name)
+            << ", \"type\": " << json_printed(op->type)
+            << ", \"memory_type\": " << json_printed(op->memory_type)
+            << ", \"extents\": [";
+        for (size_t i = 0; i < op->extents.size(); i++) {
+            int64_t extent = 0;
+            if (upper_bound(op->extents[i], &extent)) {
+                bytes *= extent;
+            } else {
+                known = false;
+            }
+            out << (i > 0 ? ", " : "") << json_printed(op->extents[i]);
+        }
+        out << "], \"estimated_bytes\": " << estimate_json(known, bytes) << "}";
+
+        op->body.accept(this);
+    }
+
+public:
+    LoopNestReport(std::ostream &out)
+        : out(out) {
+    }
+
+    void print(const Module &m, const MeasuredTimes &times) {
+        out << "{\"name\": " << json_string(m.name())
+            << ", \"target\": " << json_string(m.target().to_string())
+            << ", \"functions\": ";
+        need_comma.push_back(false);
+        open_array();
+        for (const LoweredFunc &f : m.functions()) {
+            constants.clear();
+            estimated_args.clear();
+            for (const LoweredArgument &arg : f.args) {
+                const ArgumentEstimates &e = arg.argument_estimates;
+                if (arg.is_buffer()) {
+                    for (size_t i = 0; i < e.buffer_estimates.size(); i++) {
+                        const Range &r = e.buffer_estimates[i];
+                        string prefix = arg.name + ".";
+                        string suffix = "." + std::to_string(i);
+                        if (r.min.defined()) {
+                            constants[prefix + "min" + suffix] = r.min;
+                            estimated_args.insert(prefix + "min" + suffix);
+                        }
+                        if (r.extent.defined()) {
+                            constants[prefix + "extent" + suffix] = r.extent;
+                            estimated_args.insert(prefix + "extent" + suffix);
+                        }
+                    }
+                } else if (e.scalar_estimate.defined()) {
+                    constants[arg.name] = e.scalar_estimate;
+                    estimated_args.insert(arg.name);
+                }
+            }
+            auto it = times.find(f.name);
+            measured = it == times.end() ? nullptr : &it->second;
+
+            begin_item();
+            out << "{\"name\": " << json_string(f.name) << ", \"body\": ";
+            open_array();
+            f.body.accept(this);
+            close_array();
+            out << "}";
+        }
+        close_array();
+        need_comma.pop_back();
+        out << "}\n";
+    }
+};
+
+}  // namespace
+
+void print_loop_nest_report(const string &filename, const Module &m) {
+    MeasuredTimes times;
+    string profile = get_env_variable("HL_LOOP_NEST_PROFILE");
+    if (!profile.empty()) {
+        debug(1) << "Reading measured times from " << profile << "\n";
+        times = read_measured_times(profile);
+    }
+    std::ofstream file(filename);
+    LoopNestReport report(file);
+    report.print(m, times);
+}
+
+}  // namespace Internal
+}  // namespace Halide
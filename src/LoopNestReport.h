@@ -0,0 +1,28 @@
+#ifndef HALIDE_LOOP_NEST_REPORT_H
+#define HALIDE_LOOP_NEST_REPORT_H
+
+/** \file
+ * Defines a function to dump the loop nests of a Module, annotated
+ * with estimated costs, to a JSON file.
+ */
+
+#include "Module.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Dump the loop nests of each function in a Module to filename as
+ * JSON. Each loop records its estimated extent and trip count, each
+ * allocation its estimated size, and each Func production its vector
+ * width and the estimated arithmetic and memory cost of its stores,
+ * using the cost model of RegionCosts. Estimates are derived from the
+ * estimates of the arguments, and are null where they are unknown. If
+ * the environment variable HL_LOOP_NEST_PROFILE names a file holding
+ * the output of halide_profiler_snapshot_report, the measured time per
+ * run of each Func is included too. */
+void print_loop_nest_report(const std::string &filename, const Module &m);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
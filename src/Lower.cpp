@@ -9,6 +9,7 @@
 #include "AddImageChecks.h"
 #include "AddParameterChecks.h"
 #include "AllocationBoundsInference.h"
+#include "ArenaAllocation.h"
 #include "AsyncProducers.h"
 #include "BoundSmallAllocations.h"
 #include "Bounds.h"
@@ -33,10 +34,13 @@
 #include "InjectHostDevBufferCopies.h"
 #include "InjectOpenGLIntrinsics.h"
 #include "Inline.h"
+#include "InvariantDivision.h"
 #include "LICM.h"
 #include "LoopCarry.h"
 #include "LowerWarpShuffles.h"
 #include "Memoization.h"
+#include "Multiversion.h"
+#include "ParallelLoopFusion.h"
 #include "PartitionLoops.h"
 #include "Prefetch.h"
 #include "Profiling.h"
@@ -230,6 +234,11 @@ Module lower(const vector<Function> &output_funcs,
     debug(2) << "Lowering after dynamically skipping stages:\n"
              << s << "\n\n";
 
+    debug(1) << "Fusing parallel loops...\n";
+    s = fuse_parallel_loops(s, env);
+    debug(2) << "Lowering after fusing parallel loops:\n"
+             << s << "\n\n";
+
     debug(1) << "Forking asynchronous producers...\n";
     s = fork_async_producers(s, env);
     debug(2) << "Lowering after forking asynchronous producers:\n"
@@ -392,6 +401,13 @@ Module lower(const vector<Function> &output_funcs,
                  << s << "\n\n";
     }
 
+    if (t.has_feature(Target::ArenaAllocation)) {
+        debug(1) << "Packing heap allocations into arenas...\n";
+        s = arena_allocation(s, t);
+        debug(2) << "Lowering after packing heap allocations into arenas:\n"
+                 << s << "\n\n";
+    }
+
     if (t.has_feature(Target::CUDA)) {
         debug(1) << "Injecting warp shuffles...\n";
         s = lower_warp_shuffles(s);
@@ -419,12 +435,24 @@ Module lower(const vector<Function> &output_funcs,
     debug(2) << "Lowering after lowering unsafe promises:\n"
              << s << "\n\n";
 
+    debug(1) << "Optimizing division by loop invariants...\n";
+    s = optimize_invariant_division(s);
+    debug(2) << "Lowering after optimizing division by loop invariants:\n"
+             << s << "\n\n";
+
     s = remove_dead_allocations(s);
     s = simplify(s);
     s = loop_invariant_code_motion(s);
     debug(1) << "Lowering after final simplification:\n"
              << s << "\n\n";
 
+    // This must come after the last simplification, which would
+    // otherwise notice that both sides of the dispatch are the same.
+    debug(1) << "Multiversioning loop nests...\n";
+    s = multiversion_loops(s, env, t);
+    debug(2) << "Lowering after multiversioning loop nests:\n"
+             << s << "\n\n";
+
     if (t.arch != Target::Hexagon && (t.features_any_of({Target::HVX_64, Target::HVX_128}))) {
         debug(1) << "Splitting off Hexagon offload...\n";
         s = inject_hexagon_rpc(s, t, result_module);
@@ -452,6 +480,13 @@ Module lower(const vector<Function> &output_funcs,
         }
     }
 
+    if (t.has_feature(Target::ParamProfile)) {
+        debug(1) << "Injecting parameter profiling...\n";
+        s = inject_param_profiling(s, pipeline_name, public_args);
+        debug(2) << "Lowering after injecting parameter profiling:\n"
+                 << s << "\n\n";
+    }
+
     vector<InferredArgument> inferred_args = infer_arguments(s, outputs);
     for (const InferredArgument &arg : inferred_args) {
         if (arg.param.defined() && arg.param.name() == "__user_context") {
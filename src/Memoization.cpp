@@ -170,19 +170,23 @@ class KeyInfo {
         return size_t(1) << i;
     }
 
-    // TODO: Using the full names in the key results in a (hopefully incredibly
-    // slight) performance difference based on how one names filters and
-    // functions. It is arguably a little easier to debug if something
-    // goes wrong as one doesn't need to destructure the cache key by hand
-    // in the debugger. Also, if a pointer is used, a counter must also be
-    // put in the cache key to avoid aliasing on reuse of the address in
-    // JIT situations where code is regenerated into the same region of
-    // memory.
-    //
-    // There is a plan to change the hash function used in the cache and
-    // after that happens, we'll measure performance again and maybe decide
-    // to choose one path or the other (see Git history for the implementation.
-    // It was deleted as part of the address_of intrinsic cleanup).
+    // The filter and function are identified in the key by a 64-bit
+    // hash of their names, computed at compile time and stored as an
+    // immediate, followed by the number of the compilation. The names
+    // alone are not enough: the cache outlives JIT compilations, and
+    // a Func can be redefined and recompiled under the same names, so
+    // the compilation number keeps its keys apart from the old ones.
+    uint64_t name_id() const {
+        std::string names = std::to_string(top_level_name.size()) + ":" + top_level_name +
+                            std::to_string(function_name.size()) + ":" + function_name;
+        // 64-bit FNV-1a
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : names) {
+            h ^= (uint8_t)c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
 
 public:
     KeyInfo(const Function &function, const std::string &name, int memoize_instance)
@@ -191,7 +195,7 @@ public:
           memoize_instance(memoize_instance) {
         dependencies.visit_function(function);
         size_t size_so_far = 0;
-        size_so_far += Handle().bytes() + 4;
+        size_so_far += 8 + 4;
 
         size_t needed_alignment = parameters_alignment();
         if (needed_alignment > 1) {
@@ -217,18 +221,15 @@ public:
         std::vector<Stmt> writes;
         Expr index = Expr(0);
 
-        // Store a pointer to a string identifying the filter and
-        // function. Assume this will be unique due to CSE. This can
-        // break with loading and unloading of code, though the name
-        // mechanism can also break in those conditions.
+        // Store the id of the filter and function. This is 64 bits
+        // regardless of the size of a pointer.
         writes.push_back(Store::make(key_name,
-                                     StringImm::make(std::to_string(top_level_name.size()) + ":" + top_level_name +
-                                                     std::to_string(function_name.size()) + ":" + function_name),
-                                     (index / Handle().bytes()), Parameter(), const_true(), ModulusRemainder()));
-        size_t alignment = Handle().bytes();
-        index += Handle().bytes();
+                                     make_const(UInt(64), name_id()),
+                                     (index / 8), Parameter(), const_true(), ModulusRemainder()));
+        size_t alignment = 8;
+        index += 8;
 
-        // Halide compilation is not threadsafe anyway...
+        // Then the number of the compilation.
         writes.push_back(Store::make(key_name,
                                      memoize_instance,
                                      (index / Int(32).bytes()),
@@ -433,10 +434,9 @@ private:
 Stmt inject_memoization(Stmt s, const std::map<std::string, Function> &env,
                         const std::string &name,
                         const std::vector<Function> &outputs) {
-    // Cache keys use the addresses of names of Funcs. For JIT, a
-    // counter for the pipeline is needed as the address may be reused
-    // across pipelines. This isn't a problem when using full names as
-    // the function names already are uniquefied by a counter.
+    // Cache keys use a hash of the names of Funcs, which are the same
+    // when a Func is redefined and recompiled under the same names, so
+    // each compilation also gets a number of its own.
     static std::atomic<int> memoize_instance{0};
 
     InjectMemoization injector(env, memoize_instance++, name, outputs);
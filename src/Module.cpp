@@ -13,6 +13,7 @@
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
 #include "LLVM_Runtime_Linker.h"
+#include "LoopNestReport.h"
 #include "Pipeline.h"
 #include "PythonExtensionGen.h"
 #include "StmtToHtml.h"
@@ -46,6 +47,7 @@ std::map<Output, OutputInfo> get_output_info(const Target &target) {
         {Output::cpp_stub, {"cpp_stub", ".stub.h"}},
         {Output::featurization, {"featurization", ".featurization"}},
         {Output::llvm_assembly, {"llvm_assembly", ".ll"}},
+        {Output::loop_nest_report, {"loop_nest_report", ".loop_nest.json"}},
         {Output::object, {"object", is_windows_coff ? ".obj" : ".o"}},
         {Output::python_extension, {"python_extension", ".py.cpp"}},
         {Output::pytorch_wrapper, {"pytorch_wrapper", ".pytorch.h"}},
@@ -562,6 +564,10 @@ void Module::compile(const std::map<Output, std::string> &output_files) const {
         debug(1) << "Module.compile(): stmt_html " << output_files.at(Output::stmt_html) << "\n";
         Internal::print_to_html(output_files.at(Output::stmt_html), *this);
     }
+    if (contains(output_files, Output::loop_nest_report)) {
+        debug(1) << "Module.compile(): loop_nest_report " << output_files.at(Output::loop_nest_report) << "\n";
+        Internal::print_loop_nest_report(output_files.at(Output::loop_nest_report), *this);
+    }
 
     // If there are submodules, recursively lower submodules to
     // buffers on a copy of the module being compiled, then compile
@@ -572,6 +578,7 @@ void Module::compile(const std::map<Output, std::string> &output_files) const {
         ;
         output_files_copy.erase(Output::stmt_html);
         ;
+        output_files_copy.erase(Output::loop_nest_report);
         resolve_submodules().compile(output_files_copy);
         return;
     }
@@ -28,6 +28,7 @@ enum class Output {
     cpp_stub,
     featurization,
     llvm_assembly,
+    loop_nest_report,
     object,
     python_extension,
     pytorch_wrapper,
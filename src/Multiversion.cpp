@@ -0,0 +1,193 @@
+#include "Multiversion.h"
+#include "Debug.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "runtime/HalideRuntime.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The same layout halide_can_use_target_features expects.
+constexpr int kFeaturesWordCount = (Target::FeatureEnd + 63) / (sizeof(uint64_t) * 8);
+
+Expr has_target_features(const string &name, const Target &t) {
+    uint64_t words[kFeaturesWordCount] = {0};
+    for (int i = 0; i < Target::FeatureEnd; ++i) {
+        if (t.has_feature((Target::Feature)i)) {
+            words[i >> 6] |= ((uint64_t)1) << (i & 63);
+        }
+    }
+    vector<Expr> args = {StringImm::make(name)};
+    for (int i = 0; i < kFeaturesWordCount; ++i) {
+        args.push_back(UIntImm::make(UInt(64), words[i]));
+    }
+    // Not pure, so that nothing hoists it out of the IfThenElse
+    // condition, which is how the backend finds it.
+    return Call::make(Bool(), Call::has_target_features, args, Call::Intrinsic);
+}
+
+// A halide_trace_tag event of the form "multiversion <features>",
+// saying which version of a Func's production is running. The base
+// version's tag lists no features.
+Stmt trace_version(const string &name, const Target &version, const Target &base) {
+    string tag = "multiversion";
+    for (int i = 0; i < Target::FeatureEnd; i++) {
+        Target::Feature f = (Target::Feature)i;
+        if (version.has_feature(f) && !base.has_feature(f)) {
+            tag += " " + Target::feature_to_name(f);
+        }
+    }
+    Expr no_values = Call::make(type_of<void *>(), Call::make_struct, {}, Call::Intrinsic);
+    Expr no_coords = Call::make(type_of<int32_t *>(), Call::make_struct, {}, Call::Intrinsic);
+    vector<Expr> args = {Expr(name), no_values, no_coords,
+                         (int)halide_type_int, 32, 1,
+                         (int)halide_trace_tag,
+                         Variable::make(Int(32), "pipeline.trace_id"), 0, 0,
+                         Expr(tag)};
+    return Evaluate::make(Call::make(Int(32), Call::trace, args, Call::Extern));
+}
+
+// Async producers synchronize through semaphores across the task
+// system, and device loops are compiled by a different backend, so
+// leave loop nests containing either alone.
+class CanMultiversion : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Acquire *op) override {
+        result = false;
+    }
+
+    void visit(const Fork *op) override {
+        result = false;
+    }
+
+    void visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result = true;
+};
+
+class MultiversionLoops : public IRMutator {
+    using IRMutator::visit;
+
+    const map<string, Function> &env;
+    const Target &target;
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const ProducerConsumer *op) override {
+        Stmt body = mutate(op->body);
+        auto it = env.find(op->name);
+        if (op->is_producer && it != env.end()) {
+            const auto &versions = it->second.schedule().multiversions();
+            CanMultiversion check;
+            body.accept(&check);
+            if (!versions.empty() && check.result) {
+                // If the Func's realizations are traced, say which
+                // version runs each time.
+                const bool traced = it->second.is_tracing_realizations() ||
+                                    target.features_any_of({Target::TraceLoads, Target::TraceStores, Target::TraceRealizations});
+                auto traced_body = [&](const Target &version) {
+                    return traced ? Block::make(trace_version(op->name, version, target), body) : body;
+                };
+                // Build the chain from the back, so that the first
+                // version added is the first one tried.
+                Stmt dispatch = traced_body(target);
+                for (size_t i = versions.size(); i > 0; i--) {
+                    Target version = target;
+                    for (Target::Feature f : versions[i - 1]) {
+                        version.set_feature(f);
+                    }
+                    if (version == target) {
+                        continue;
+                    }
+                    debug(3) << "Multiversioning " << op->name << " for " << version << "\n";
+                    dispatch = IfThenElse::make(has_target_features(op->name, version), traced_body(version), dispatch);
+                }
+                body = dispatch;
+            }
+        }
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return ProducerConsumer::make(op->name, op->is_producer, body);
+    }
+
+public:
+    MultiversionLoops(const map<string, Function> &env, const Target &t)
+        : env(env), target(t) {
+    }
+};
+
+class FindMultiversionFeatures : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) override {
+        if (op->is_intrinsic(Call::has_target_features)) {
+            result = multiversion_target(op, result);
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    Target result;
+    FindMultiversionFeatures(const Target &t)
+        : result(t) {
+    }
+};
+
+}  // namespace
+
+Stmt multiversion_loops(const Stmt &s, const map<string, Function> &env, const Target &t) {
+    if (t.has_feature(Target::JIT)) {
+        // The runtime query isn't linked into JIT modules, and the
+        // JIT compiles for the host it runs on anyway.
+        return s;
+    }
+    return MultiversionLoops(env, t).mutate(s);
+}
+
+Target multiversion_target(const Call *c, const Target &t) {
+    internal_assert(c->is_intrinsic(Call::has_target_features) &&
+                    c->args.size() == kFeaturesWordCount + 1);
+    Target result = t;
+    for (int i = 0; i < Target::FeatureEnd; ++i) {
+        const uint64_t *word = as_const_uint(c->args[1 + (i >> 6)]);
+        internal_assert(word);
+        if ((*word >> (i & 63)) & 1) {
+            result.set_feature((Target::Feature)i);
+        }
+    }
+    return result;
+}
+
+Target all_multiversion_features(const Stmt &s, const Target &t) {
+    FindMultiversionFeatures finder(t);
+    s.accept(&finder);
+    return finder.result;
+}
+
+}  // namespace Internal
+}  // namespace Halide
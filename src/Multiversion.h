@@ -0,0 +1,37 @@
+#ifndef HALIDE_MULTIVERSION_H
+#define HALIDE_MULTIVERSION_H
+
+/** \file
+ *
+ * Defines the lowering pass that compiles the loop nests of Funcs
+ * scheduled with Func::multiversion for several sets of CPU features.
+ */
+
+#include <map>
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Wrap the body of the production of each Func that has been
+ * multiversioned in a chain of IfThenElse nodes that check whether the
+ * CPU supports each requested set of features, using the
+ * has_target_features intrinsic. The backend compiles the then case
+ * of each into a separate function for the target with those
+ * features. Does nothing when JIT compiling. */
+Stmt multiversion_loops(const Stmt &s, const std::map<std::string, Function> &env, const Target &t);
+
+/** The target that the then case of an IfThenElse conditioned on a
+ * has_target_features intrinsic should be compiled for, when the
+ * enclosing code is being compiled for t. */
+Target multiversion_target(const Call *c, const Target &t);
+
+/** t, plus the features of every multiversioned loop nest in s. */
+Target all_multiversion_features(const Stmt &s, const Target &t);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
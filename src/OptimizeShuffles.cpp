@@ -0,0 +1,163 @@
+#include "OptimizeShuffles.h"
+#include "Bounds.h"
+#include "CSE.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include <algorithm>
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+Expr span_of_bounds(const Interval &bounds) {
+    internal_assert(bounds.is_bounded());
+
+    const Min *min_min = bounds.min.as<Min>();
+    const Max *min_max = bounds.min.as<Max>();
+    const Min *max_min = bounds.max.as<Min>();
+    const Max *max_max = bounds.max.as<Max>();
+    const Add *min_add = bounds.min.as<Add>();
+    const Add *max_add = bounds.max.as<Add>();
+    const Sub *min_sub = bounds.min.as<Sub>();
+    const Sub *max_sub = bounds.max.as<Sub>();
+
+    if (min_min && max_min && equal(min_min->b, max_min->b)) {
+        return span_of_bounds({min_min->a, max_min->a});
+    } else if (min_max && max_max && equal(min_max->b, max_max->b)) {
+        return span_of_bounds({min_max->a, max_max->a});
+    } else if (min_add && max_add && equal(min_add->b, max_add->b)) {
+        return span_of_bounds({min_add->a, max_add->a});
+    } else if (min_sub && max_sub && equal(min_sub->b, max_sub->b)) {
+        return span_of_bounds({min_sub->a, max_sub->a});
+    } else {
+        return bounds.max - bounds.min;
+    }
+}
+
+namespace {
+
+// Replace indirect loads with dynamic_shuffle intrinsics where
+// possible.
+class OptimizeShuffles : public IRMutator {
+    int lut_alignment;
+    int max_lut_bytes;
+    Scope<Interval> bounds;
+    std::vector<std::pair<string, Expr>> lets;
+
+    using IRMutator::visit;
+
+    template<typename NodeType, typename T>
+    NodeType visit_let(const T *op) {
+        // We only care about vector lets.
+        if (op->value.type().is_vector()) {
+            bounds.push(op->name, bounds_of_expr_in_scope(op->value, bounds));
+        }
+        NodeType node = IRMutator::visit(op);
+        if (op->value.type().is_vector()) {
+            bounds.pop(op->name);
+        }
+        return node;
+    }
+
+    Expr visit(const Let *op) override {
+        lets.push_back({op->name, op->value});
+        Expr expr = visit_let<Expr>(op);
+        lets.pop_back();
+        return expr;
+    }
+    Stmt visit(const LetStmt *op) override {
+        return visit_let<Stmt>(op);
+    }
+
+    Expr visit(const Load *op) override {
+        if (!is_one(op->predicate)) {
+            // TODO(psuriana): We shouldn't mess with predicated load for now.
+            return IRMutator::visit(op);
+        }
+        if (!op->type.is_vector() || op->index.as<Ramp>()) {
+            // Don't handle scalar or simple vector loads.
+            return IRMutator::visit(op);
+        }
+
+        Expr index = mutate(op->index);
+        Interval unaligned_index_bounds = bounds_of_expr_in_scope(index, bounds);
+        if (unaligned_index_bounds.is_bounded()) {
+            // The lookup table can't have more than 256 elements, as
+            // dynamic_shuffle takes 8-bit indices.
+            int max_extent = std::min(256, max_lut_bytes / op->type.bytes());
+
+            // We want to try both the unaligned and aligned
+            // bounds. The unaligned bounds might fit in 256 elements,
+            // while the aligned bounds do not.
+            vector<Interval> candidates;
+            ModulusRemainder alignment;
+            if (lut_alignment > 0) {
+                int align = std::max(1, lut_alignment / op->type.bytes());
+                candidates.push_back({(unaligned_index_bounds.min / align) * align,
+                                      ((unaligned_index_bounds.max + align) / align) * align - 1});
+                alignment = ModulusRemainder(align, 0);
+            }
+            candidates.push_back(unaligned_index_bounds);
+
+            for (const Interval &index_bounds : candidates) {
+                Expr index_span = span_of_bounds(index_bounds);
+                index_span = common_subexpression_elimination(index_span);
+                index_span = simplify(index_span);
+
+                const int64_t *const_span = as_const_int(index_span);
+                // Without padding, we can't load more than the range
+                // the index might be in.
+                bool fits = lut_alignment > 0 ?
+                                can_prove(index_span < max_extent) :
+                                const_span && *const_span < max_extent;
+                if (fits) {
+                    // This is a lookup within a small array. We can
+                    // use dynamic_shuffle for this.
+                    int const_extent = const_span ? *const_span + 1 : max_extent;
+                    Expr base = simplify(index_bounds.min);
+
+                    // Load all of the possible indices loaded from the
+                    // LUT. Note that with lut_alignment, for clamped ramps,
+                    // this loads up to 1 vector past the max.
+                    // CodeGen_Hexagon::allocation_padding returns a native
+                    // vector size to account for this.
+                    Expr lut = Load::make(op->type.with_lanes(const_extent), op->name,
+                                          Ramp::make(base, 1, const_extent),
+                                          op->image, op->param, const_true(const_extent), alignment);
+
+                    // We know the size of the LUT is not more than 256, so we
+                    // can safely cast the index to 8 bit, which
+                    // dynamic_shuffle requires.
+                    index = simplify(cast(UInt(8).with_lanes(op->type.lanes()), index - base));
+                    return Call::make(op->type, "dynamic_shuffle", {lut, index, 0, const_extent - 1}, Call::PureIntrinsic);
+                }
+                // Only the first iteration of this loop is aligned.
+                alignment = ModulusRemainder();
+            }
+        }
+        if (!index.same_as(op->index)) {
+            return Load::make(op->type, op->name, index, op->image, op->param, op->predicate, op->alignment);
+        } else {
+            return op;
+        }
+    }
+
+public:
+    OptimizeShuffles(int lut_alignment, int max_lut_bytes)
+        : lut_alignment(lut_alignment), max_lut_bytes(max_lut_bytes) {
+    }
+};
+
+}  // namespace
+
+Stmt optimize_shuffles(Stmt s, int lut_alignment, int max_lut_bytes) {
+    return OptimizeShuffles(lut_alignment, max_lut_bytes).mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,34 @@
+#ifndef HALIDE_OPTIMIZE_SHUFFLES_H
+#define HALIDE_OPTIMIZE_SHUFFLES_H
+
+/** \file
+ * Defines a lowering pass that replaces gathers from small ranges of
+ * memory with a dense load and a dynamic_shuffle.
+ */
+
+#include "Expr.h"
+#include "Interval.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find an upper bound of bounds.max - bounds.min. */
+Expr span_of_bounds(const Interval &bounds);
+
+/** Replace vector loads with arbitrary indices whose indices provably
+ * lie within a small range with a dense load of that range (a lookup
+ * table), and a dynamic_shuffle of it by the indices relative to the
+ * start of the range. Only lookup tables of at most 256 elements and
+ * at most max_lut_bytes bytes are made.
+ *
+ * If lut_alignment is nonzero, the range is first rounded out to a
+ * multiple of lut_alignment bytes, and ranges that are not a constant
+ * size are loaded as 256 elements. Both may load past the end of the
+ * buffer, so the target must pad allocations to allow it. If
+ * lut_alignment is zero, only the elements in the range are loaded. */
+Stmt optimize_shuffles(Stmt s, int lut_alignment, int max_lut_bytes);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
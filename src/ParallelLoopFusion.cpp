@@ -0,0 +1,336 @@
+#include <set>
+
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "ParallelLoopFusion.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Find the Funcs written to in a loop body that are realized
+// outside of it, and the coordinates of every write.
+class FindProvides : public IRVisitor {
+    using IRVisitor::visit;
+
+    set<string> inner_realizations;
+
+    void visit(const Realize *op) override {
+        inner_realizations.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Provide *op) override {
+        IRVisitor::visit(op);
+        if (!inner_realizations.count(op->name)) {
+            provides[op->name].push_back(op->args);
+        }
+    }
+
+public:
+    map<string, vector<vector<Expr>>> provides;
+};
+
+// Find the coordinates of every read of the given Funcs. Accesses
+// we can't reason about (e.g. passing the buffer to an extern stage,
+// or writing to it) make a Func unsafe.
+class FindAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    const map<string, vector<vector<Expr>>> &funcs;
+
+    void visit(const Call *op) override {
+        IRVisitor::visit(op);
+        if (funcs.count(op->name)) {
+            if (op->call_type == Call::Halide) {
+                calls[op->name].push_back(op->args);
+            } else {
+                unsafe.insert(op->name);
+            }
+        }
+    }
+
+    void visit(const Provide *op) override {
+        IRVisitor::visit(op);
+        if (funcs.count(op->name)) {
+            unsafe.insert(op->name);
+        }
+    }
+
+    void visit(const Variable *op) override {
+        if (op->type.is_handle()) {
+            for (const auto &f : funcs) {
+                if (starts_with(op->name, f.first + ".")) {
+                    unsafe.insert(f.first);
+                }
+            }
+        }
+    }
+
+public:
+    map<string, vector<vector<Expr>>> calls;
+    set<string> unsafe;
+
+    FindAccesses(const map<string, vector<vector<Expr>>> &funcs)
+        : funcs(funcs) {
+    }
+};
+
+bool is_var(const Expr &e, const string &name) {
+    const Variable *v = e.as<Variable>();
+    return v && v->name == name;
+}
+
+bool is_fusable_loop(const For *op) {
+    return (op &&
+            op->for_type == ForType::Parallel &&
+            (op->device_api == DeviceAPI::None ||
+             op->device_api == DeviceAPI::Host));
+}
+
+class FuseParallelLoops : public IRMutator {
+    using IRMutator::visit;
+
+    const map<string, Function> &env;
+
+    // The lets enclosing the current Stmt, used to prove the two
+    // loops have the same bounds.
+    vector<pair<string, Expr>> enclosing_lets;
+
+    bool is_async(const string &name) {
+        auto it = env.find(name);
+        return it == env.end() || it->second.schedule().async();
+    }
+
+    // Check that iteration i of loop2 only reads values of the Funcs
+    // produced in loop1 that iteration i of loop1 writes. This holds
+    // if there's some dimension of each Func that loop1 always writes
+    // at its loop variable, and loop2 always reads at its loop
+    // variable.
+    bool dependencies_permit_fusion(const For *loop1, const For *loop2,
+                                    const vector<pair<string, Expr>> &lets) {
+        FindProvides provides;
+        loop1->body.accept(&provides);
+        if (provides.provides.empty()) {
+            return false;
+        }
+        for (const auto &p : provides.provides) {
+            if (is_async(p.first)) {
+                return false;
+            }
+        }
+
+        // The bounds of the second loop can't depend on the first.
+        FindAccesses bounds_accesses(provides.provides);
+        loop2->min.accept(&bounds_accesses);
+        loop2->extent.accept(&bounds_accesses);
+        for (const auto &l : lets) {
+            l.second.accept(&bounds_accesses);
+        }
+        if (!bounds_accesses.calls.empty() || !bounds_accesses.unsafe.empty()) {
+            return false;
+        }
+
+        FindAccesses accesses(provides.provides);
+        loop2->body.accept(&accesses);
+        if (!accesses.unsafe.empty()) {
+            return false;
+        }
+        for (const auto &c : accesses.calls) {
+            const vector<vector<Expr>> &writes = provides.provides[c.first];
+            const vector<vector<Expr>> &reads = c.second;
+            bool found_dim = false;
+            for (size_t d = 0; d < writes[0].size() && !found_dim; d++) {
+                bool ok = true;
+                for (const auto &w : writes) {
+                    ok &= (d < w.size() && is_var(w[d], loop1->name));
+                }
+                for (const auto &r : reads) {
+                    ok &= (d < r.size() && is_var(r[d], loop2->name));
+                }
+                found_dim = ok;
+            }
+            if (!found_dim) {
+                debug(3) << "Not fusing " << loop1->name << " and " << loop2->name
+                         << " because of the accesses to " << c.first << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Try to fuse the parallel loop at the start of the first half of
+    // a block with the parallel loop that produces the next stage in
+    // the second half. Returns an undefined Stmt on failure.
+    Stmt fuse(const Block *op) {
+        vector<pair<string, Expr>> lets;
+
+        // The first half is the production of a stage (or an
+        // already-fused loop), which is a parallel loop preceded by
+        // some lets.
+        Stmt first = op->first;
+        string producer;
+        const ProducerConsumer *pc = first.as<ProducerConsumer>();
+        if (pc && pc->is_producer) {
+            producer = pc->name;
+            first = pc->body;
+        }
+        while (const LetStmt *l = first.as<LetStmt>()) {
+            lets.emplace_back(l->name, l->value);
+            first = l->body;
+        }
+        const For *loop1 = first.as<For>();
+        if (!is_fusable_loop(loop1)) {
+            return Stmt();
+        }
+
+        // The second half is the consumption of that stage, which
+        // starts with the production of the next one, possibly
+        // inside the realizations of other stages.
+        Stmt rest = op->rest;
+        vector<string> consumers;
+        vector<const Realize *> realizes;
+        while (true) {
+            const ProducerConsumer *c = rest.as<ProducerConsumer>();
+            const Realize *r = rest.as<Realize>();
+            if (c && !c->is_producer) {
+                consumers.push_back(c->name);
+                rest = c->body;
+            } else if (r) {
+                realizes.push_back(r);
+                rest = r->body;
+            } else {
+                break;
+            }
+        }
+        Stmt remainder;
+        if (const Block *b = rest.as<Block>()) {
+            rest = b->first;
+            remainder = b->rest;
+        }
+        pc = rest.as<ProducerConsumer>();
+        if (!pc || !pc->is_producer || is_async(pc->name)) {
+            return Stmt();
+        }
+        string producer2 = pc->name;
+        Stmt second = pc->body;
+        size_t first_lets = lets.size();
+        while (const LetStmt *l = second.as<LetStmt>()) {
+            lets.emplace_back(l->name, l->value);
+            second = l->body;
+        }
+        const For *loop2 = second.as<For>();
+        if (!is_fusable_loop(loop2) ||
+            !dependencies_permit_fusion(loop1, loop2, vector<pair<string, Expr>>(lets.begin() + first_lets, lets.end()))) {
+            return Stmt();
+        }
+
+        debug(3) << "Fusing parallel loops " << loop1->name << " and " << loop2->name << "\n";
+
+        // The fused loop covers both ranges, with each body guarded
+        // by its own range unless they're provably the same.
+        Expr min1 = loop1->min, extent1 = loop1->extent;
+        Expr min2 = loop2->min, extent2 = loop2->extent;
+        Expr end1 = min1 + extent1, end2 = min2 + extent2;
+        Expr same_range = (min1 == min2 && extent1 == extent2);
+        for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+            same_range = substitute(it->first, it->second, same_range);
+        }
+        for (auto it = enclosing_lets.rbegin(); it != enclosing_lets.rend(); it++) {
+            same_range = substitute(it->first, it->second, same_range);
+        }
+        bool same = can_prove(same_range);
+
+        Expr var = Variable::make(Int(32), loop2->name);
+        Stmt body1 = substitute(loop1->name, var, loop1->body);
+        Stmt body2 = loop2->body;
+        if (!same) {
+            body1 = IfThenElse::make(min1 <= var && var < end1, body1);
+            body2 = IfThenElse::make(min2 <= var && var < end2, body2);
+        }
+        if (!producer.empty()) {
+            body1 = ProducerConsumer::make_produce(producer, body1);
+        }
+        body2 = ProducerConsumer::make_produce(producer2, body2);
+        for (auto it = consumers.rbegin(); it != consumers.rend(); it++) {
+            body2 = ProducerConsumer::make_consume(*it, body2);
+        }
+
+        Expr new_min = same ? min2 : min(min1, min2);
+        Expr new_extent = same ? extent2 : max(end1, end2) - new_min;
+        Stmt result = For::make(loop2->name, new_min, new_extent, ForType::Parallel,
+                                loop2->device_api, Block::make(body1, body2));
+
+        // Whatever came after the second loop runs after the fused
+        // loop, still inside the consume nodes.
+        if (remainder.defined()) {
+            for (auto it = consumers.rbegin(); it != consumers.rend(); it++) {
+                remainder = ProducerConsumer::make_consume(*it, remainder);
+            }
+            result = Block::make(result, remainder);
+        }
+
+        for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+            result = LetStmt::make(it->first, it->second, result);
+        }
+
+        for (auto it = realizes.rbegin(); it != realizes.rend(); it++) {
+            const Realize *r = *it;
+            result = Realize::make(r->name, r->types, r->memory_type, r->bounds, r->condition, result);
+        }
+
+        return result;
+    }
+
+    Stmt visit(const Block *op) override {
+        Stmt fused = fuse(op);
+        if (fused.defined()) {
+            // The fused loop may fuse with the stage after that.
+            return mutate(fused);
+        }
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        enclosing_lets.emplace_back(op->name, op->value);
+        Stmt body = mutate(op->body);
+        enclosing_lets.pop_back();
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return LetStmt::make(op->name, op->value, body);
+    }
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    FuseParallelLoops(const map<string, Function> &env)
+        : env(env) {
+    }
+};
+
+}  // namespace
+
+Stmt fuse_parallel_loops(const Stmt &s, const map<string, Function> &env) {
+    return FuseParallelLoops(env).mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
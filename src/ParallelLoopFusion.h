@@ -0,0 +1,30 @@
+#ifndef HALIDE_PARALLEL_LOOP_FUSION_H
+#define HALIDE_PARALLEL_LOOP_FUSION_H
+
+/** \file
+ *
+ * Defines the lowering pass that fuses adjacent parallel loops over
+ * the same dimension of consecutive stages.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Merge the parallel loop producing one stage with the parallel loop
+ * of the stage that consumes it, when each iteration of the consumer
+ * only reads what the same iteration of the producer wrote (e.g. two
+ * compute_root Funcs parallelized over the same pure dimension, with
+ * the consumer reading the same row of the producer). This turns one
+ * fork/join per stage into one for the whole chain, and keeps each
+ * task's slice of the producer warm in cache for its consumer. Must
+ * be done after bounds inference and before storage flattening. */
+Stmt fuse_parallel_loops(const Stmt &s, const std::map<std::string, Function> &env);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
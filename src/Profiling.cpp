@@ -293,6 +293,10 @@ private:
 };
 
 Stmt inject_profiling(Stmt s, string pipeline_name) {
+    // Runs the profiler isn't sampling run the pipeline as it was,
+    // without any calls into the profiler.
+    Stmt unprofiled = s;
+
     InjectProfiling profiling(pipeline_name);
     s = profiling.mutate(s);
 
@@ -303,14 +307,16 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
     Expr start_profiler = Call::make(Int(32), "halide_profiler_pipeline_start",
                                      {pipeline_name, num_funcs, func_names_buf}, Call::Extern);
 
-    Expr get_state = Call::make(Handle(), "halide_profiler_get_state", {}, Call::Extern);
-
     Expr get_pipeline_state = Call::make(Handle(), "halide_profiler_get_pipeline_state", {pipeline_name}, Call::Extern);
 
     Expr profiler_token = Variable::make(Int(32), "profiler_token");
 
+    Expr get_state = Call::make(Handle(), "halide_profiler_get_state", {}, Call::Extern);
+
+    Expr profiler_state = Variable::make(Handle(), "profiler_state");
+
     Expr stop_profiler = Call::make(Handle(), Call::register_destructor,
-                                    {Expr("halide_profiler_pipeline_end"), get_state}, Call::Intrinsic);
+                                    {Expr("halide_profiler_pipeline_end"), profiler_state}, Call::Intrinsic);
 
     bool no_stack_alloc = profiling.func_stack_peak.empty();
     if (!no_stack_alloc) {
@@ -322,7 +328,6 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
         s = Block::make(update_stack, s);
     }
 
-    Expr profiler_state = Variable::make(Handle(), "profiler_state");
     Stmt incr_active_threads =
         Evaluate::make(Call::make(Int(32), "halide_profiler_incr_active_threads",
                                   {profiler_state}, Call::Extern));
@@ -332,7 +337,9 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
     s = Block::make({incr_active_threads, s, decr_active_threads});
 
     s = LetStmt::make("profiler_pipeline_state", get_pipeline_state, s);
+    s = Block::make(Evaluate::make(stop_profiler), s);
     s = LetStmt::make("profiler_state", get_state, s);
+    s = IfThenElse::make(profiler_token == halide_profiler_unsampled_run, unprofiled, s);
     // If there was a problem starting the profiler, it will call an
     // appropriate halide error function and then return the
     // (negative) error code as the token.
@@ -358,10 +365,51 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
     s = Block::make(s, Free::make("profiling_func_names"));
     s = Allocate::make("profiling_func_names", Handle(),
                        MemoryType::Auto, {num_funcs}, const_true(), s);
-    s = Block::make(Evaluate::make(stop_profiler), s);
 
     return s;
 }
 
+Stmt inject_param_profiling(const Stmt &s, const string &pipeline_name,
+                            const vector<Argument> &args) {
+    Expr output_buf;
+    vector<Stmt> records;
+    for (const Argument &arg : args) {
+        vector<Expr> values;
+        if (arg.is_buffer()) {
+            Expr buf = Variable::make(type_of<struct halide_buffer_t *>(), arg.name + ".buffer");
+            if (arg.is_output() && !output_buf.defined()) {
+                output_buf = buf;
+            }
+            if (arg.dimensions == 0) {
+                continue;
+            }
+            values.push_back(Call::make(Int(32), Call::buffer_get_extent, {buf, 0}, Call::Extern));
+            if (arg.dimensions > 1) {
+                values.push_back(Call::make(Int(32), Call::buffer_get_extent, {buf, 1}, Call::Extern));
+                values.push_back(Call::make(Int(32), Call::buffer_get_stride, {buf, 1}, Call::Extern));
+            }
+        } else if (arg.type.is_int() || arg.type.is_uint() || arg.type.is_bool()) {
+            values.push_back(Variable::make(arg.type, arg.name));
+        } else {
+            // Specializing on the exact value of a float or a pointer
+            // is rarely useful, so don't record them.
+            continue;
+        }
+        string name = arg.is_buffer() ? arg.name + ".shape" : arg.name;
+        vector<Expr> call_args = {pipeline_name, name, (int)values.size()};
+        for (int i = 0; i < 3; i++) {
+            call_args.push_back(i < (int)values.size() ? cast<int64_t>(values[i]) : make_zero(Int(64)));
+        }
+        Expr call = Call::make(Int(32), "halide_param_profile_record", call_args, Call::Extern);
+        records.push_back(Evaluate::make(call));
+    }
+
+    if (records.empty() || !output_buf.defined()) {
+        return s;
+    }
+    Expr is_bounds_query = Call::make(Bool(), Call::buffer_is_bounds_query, {output_buf}, Call::Extern);
+    return Block::make(IfThenElse::make(!is_bounds_query, Block::make(records)), s);
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -24,6 +24,7 @@
  *   argmin:      0.027715ms (46%)   stack: 20
  */
 
+#include "Argument.h"
 #include "IR.h"
 
 namespace Halide {
@@ -38,6 +39,15 @@ namespace Internal {
  */
 Stmt inject_profiling(Stmt, std::string);
 
+/** Insert calls to halide_param_profile_record at the start of a
+ * pipeline, reporting the value of each integer scalar argument and
+ * the shape of each buffer argument, so that the values taken on in
+ * practice can be used to choose specializations for a later
+ * compile. Bounds queries are not recorded. Should be done once the
+ * argument list is known, after all other lowering. */
+Stmt inject_param_profiling(const Stmt &s, const std::string &pipeline_name,
+                            const std::vector<Argument> &args);
+
 }  // namespace Internal
 }  // namespace Halide
 
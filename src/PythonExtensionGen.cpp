@@ -338,7 +338,11 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
             // Python already converted this.
         }
     }
-    dest << "    int result = " << f.name << "(";
+    // Release the GIL while the pipeline runs, so that other Python threads
+    // can make progress (or run other pipelines) concurrently.
+    dest << "    int result;\n";
+    dest << "    Py_BEGIN_ALLOW_THREADS\n";
+    dest << "    result = " << f.name << "(";
     for (size_t i = 0; i < args.size(); i++) {
         if (i > 0) {
             dest << ", ";
@@ -349,7 +353,8 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
             dest << "py_" << arg_names[i];
         }
     }
-    dest << ");";
+    dest << ");\n";
+    dest << "    Py_END_ALLOW_THREADS";
     dest << R"INLINE_CODE(
     if (result != 0) {
         /* In the optimal case, we'd be generating an exception declared
@@ -209,7 +209,9 @@ class ExprCost : public IRVisitor {
                 // There is no visibility into an extern stage so there is no
                 // way to know the cost of the call statically. Modeling the
                 // cost of an extern stage requires profiling or user annotation.
-                user_warning << "Unknown extern call " << call->name << '\n';
+                if (warn_on_unknown_calls) {
+                    user_warning << "Unknown extern call " << call->name << '\n';
+                }
             }
         } else if (call->is_intrinsic()) {
             // TODO: Improve the cost model. In some architectures (e.g. ARM or
@@ -232,7 +234,9 @@ class ExprCost : public IRVisitor {
             } else {
                 // For other intrinsics, use 1 for the arithmetic cost.
                 arith += 1;
-                user_warning << "Unhandled intrinsic call " << call->name << '\n';
+                if (warn_on_unknown_calls) {
+                    user_warning << "Unhandled intrinsic call " << call->name << '\n';
+                }
             }
         }
 
@@ -250,17 +254,28 @@ class ExprCost : public IRVisitor {
         let->body.accept(this);
     }
 
-    // None of the following IR nodes should be encountered when traversing the
-    // IR at the level at which the auto scheduler operates.
-    void visit(const Load *) override {
-        internal_assert(false);
+    // Loads, ramps and broadcasts only show up when costing lowered
+    // code. A (possibly vector) load costs the same as the call it
+    // came from. Ramps and broadcasts are folded into the instructions
+    // that use them.
+    void visit(const Load *op) override {
+        op->predicate.accept(this);
+        op->index.accept(this);
+        arith += 1;
+        int64_t bytes = (int64_t)op->type.bytes() * op->type.lanes();
+        memory += bytes;
+        detailed_byte_loads[op->name] += bytes;
     }
-    void visit(const Ramp *) override {
-        internal_assert(false);
+    void visit(const Ramp *op) override {
+        op->base.accept(this);
+        op->stride.accept(this);
     }
-    void visit(const Broadcast *) override {
-        internal_assert(false);
+    void visit(const Broadcast *op) override {
+        op->value.accept(this);
     }
+
+    // None of the following IR nodes should be encountered when traversing the
+    // IR at the level at which the auto scheduler operates.
     void visit(const LetStmt *) override {
         internal_assert(false);
     }
@@ -304,9 +319,11 @@ public:
     // Detailed breakdown of bytes loaded by the allocation or function
     // they are loaded from.
     map<string, int64_t> detailed_byte_loads;
+    // Whether to warn about calls we don't know the cost of.
+    bool warn_on_unknown_calls;
 
-    ExprCost()
-        : arith(0), memory(0) {
+    ExprCost(bool warn_on_unknown_calls = true)
+        : arith(0), memory(0), warn_on_unknown_calls(warn_on_unknown_calls) {
     }
 };
 
@@ -367,15 +384,6 @@ Expr get_func_value_size(const Function &f) {
     }
 };*/
 
-Cost compute_expr_cost(Expr expr) {
-    // TODO: Handle likely
-    //expr = LikelyExpression().mutate(expr);
-    expr = simplify(expr);
-    ExprCost cost_visitor;
-    expr.accept(&cost_visitor);
-    return Cost(cost_visitor.arith, cost_visitor.memory);
-}
-
 map<string, Expr> compute_expr_detailed_byte_loads(Expr expr) {
     // TODO: Handle likely
     //expr = LikelyExpression().mutate(expr);
@@ -392,6 +400,15 @@ map<string, Expr> compute_expr_detailed_byte_loads(Expr expr) {
 
 }  // anonymous namespace
 
+Cost compute_expr_cost(Expr expr, bool warn_on_unknown_calls) {
+    // TODO: Handle likely
+    //expr = LikelyExpression().mutate(expr);
+    expr = simplify(expr);
+    ExprCost cost_visitor(warn_on_unknown_calls);
+    expr.accept(&cost_visitor);
+    return Cost(cost_visitor.arith, cost_visitor.memory);
+}
+
 RegionCosts::RegionCosts(const map<string, Function> &_env,
                          const vector<string> &_order)
     : env(_env), order(_order) {
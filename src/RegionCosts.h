@@ -145,6 +145,13 @@ struct RegionCosts {
                 const std::vector<std::string> &order);
 };
 
+/** Return the cost of evaluating expr once. expr may be an expression
+ * of a lowered Stmt, in which case the cost of each vector operation is
+ * the same as that of the scalar one. Lowered code is full of
+ * intrinsics the cost model doesn't know, so callers costing it
+ * should turn off the warnings about unknown calls. */
+Cost compute_expr_cost(Expr expr, bool warn_on_unknown_calls = true);
+
 /** Return true if the cost of inlining a function is equivalent to the
  * cost of calling the function directly. */
 bool is_func_trivial_to_inline(const Function &func);
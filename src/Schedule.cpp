@@ -218,12 +218,15 @@ struct FuncScheduleContents {
     std::vector<Bound> bounds;
     std::vector<Bound> estimates;
     std::map<std::string, Internal::FunctionPtr> wrappers;
+    std::vector<std::vector<Target::Feature>> multiversions;
     MemoryType memory_type;
-    bool memoized, async;
+    bool memoized, async, store_per_parallel_task;
+    int async_depth;
 
     FuncScheduleContents()
         : store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()),
-          memory_type(MemoryType::Auto), memoized(false), async(false){};
+          memory_type(MemoryType::Auto), memoized(false), async(false),
+          store_per_parallel_task(false), async_depth(1){};
 
     // Pass an IRMutator through to all Exprs referenced in the FuncScheduleContents
     void mutate(IRMutator *mutator) {
@@ -340,6 +343,9 @@ FuncSchedule FuncSchedule::deep_copy(
     copy.contents->memory_type = contents->memory_type;
     copy.contents->memoized = contents->memoized;
     copy.contents->async = contents->async;
+    copy.contents->async_depth = contents->async_depth;
+    copy.contents->store_per_parallel_task = contents->store_per_parallel_task;
+    copy.contents->multiversions = contents->multiversions;
 
     // Deep-copy wrapper functions.
     for (const auto &iter : contents->wrappers) {
@@ -375,6 +381,30 @@ bool FuncSchedule::async() const {
     return contents->async;
 }
 
+int &FuncSchedule::async_depth() {
+    return contents->async_depth;
+}
+
+int FuncSchedule::async_depth() const {
+    return contents->async_depth;
+}
+
+bool &FuncSchedule::store_per_parallel_task() {
+    return contents->store_per_parallel_task;
+}
+
+bool FuncSchedule::store_per_parallel_task() const {
+    return contents->store_per_parallel_task;
+}
+
+const std::vector<std::vector<Target::Feature>> &FuncSchedule::multiversions() const {
+    return contents->multiversions;
+}
+
+std::vector<std::vector<Target::Feature>> &FuncSchedule::multiversions() {
+    return contents->multiversions;
+}
+
 std::vector<StorageDim> &FuncSchedule::storage_dims() {
     return contents->storage_dims;
 }
@@ -8,6 +8,7 @@
 #include "Expr.h"
 #include "FunctionPtr.h"
 #include "Parameter.h"
+#include "Target.h"
 
 #include <map>
 
@@ -426,6 +427,31 @@ public:
     bool &async();
     bool async() const;
 
+    /** How many iterations of the consuming loop an async producer
+     * may run ahead of its consumer when its storage is folded
+     * automatically. The fold factor chosen by storage folding is
+     * scaled up so that the ring buffer holds this many
+     * footprints. Defaults to one. */
+    // @{
+    int &async_depth();
+    int async_depth() const;
+    // @}
+
+    /** Should sliding window give each iteration of a parallel loop
+     * inside this Function's store level its own storage. */
+    // @{
+    bool &store_per_parallel_task();
+    bool store_per_parallel_task() const;
+    // @}
+
+    /** Additional sets of CPU features to compile the production of
+     * this Function for, in the order they should be tried. See
+     * \ref Func::multiversion */
+    // @{
+    const std::vector<std::vector<Target::Feature>> &multiversions() const;
+    std::vector<std::vector<Target::Feature>> &multiversions();
+    // @}
+
     /** The list and order of dimensions used to store this
      * function. The first dimension in the vector corresponds to the
      * innermost dimension for storage (i.e. which dimension is
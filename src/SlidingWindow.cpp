@@ -13,6 +13,7 @@ namespace Halide {
 namespace Internal {
 
 using std::map;
+using std::set;
 using std::string;
 
 namespace {
@@ -337,6 +338,7 @@ public:
 // Perform sliding window optimization for a particular function
 class SlidingWindowOnFunction : public IRMutator {
     Function func;
+    std::vector<string> enclosing_parallel_loops;
 
     using IRMutator::visit;
 
@@ -345,11 +347,21 @@ class SlidingWindowOnFunction : public IRMutator {
 
         Stmt new_body = op->body;
 
-        new_body = mutate(new_body);
+        if (op->for_type == ForType::Parallel) {
+            enclosing_parallel_loops.push_back(op->name);
+            new_body = mutate(new_body);
+            enclosing_parallel_loops.pop_back();
+        } else {
+            new_body = mutate(new_body);
+        }
 
         if (op->for_type == ForType::Serial ||
             op->for_type == ForType::Unrolled) {
-            new_body = SlidingWindowOnFunctionAndLoop(func, op->name, op->min).mutate(new_body);
+            Stmt slid = SlidingWindowOnFunctionAndLoop(func, op->name, op->min).mutate(new_body);
+            if (!slid.same_as(new_body) && !enclosing_parallel_loops.empty()) {
+                parallel_loops_slid_within.insert(enclosing_parallel_loops.back());
+            }
+            new_body = slid;
         }
 
         if (new_body.same_as(op->body)) {
@@ -363,6 +375,76 @@ public:
     SlidingWindowOnFunction(Function f)
         : func(f) {
     }
+
+    // The parallel loops which directly enclose a serial loop we slid
+    // over. Each iteration of one of these loops warms up its own
+    // window, so it never reads values computed by another iteration.
+    set<string> parallel_loops_slid_within;
+};
+
+// Check if a Stmt refers to a function outside of any realization of it.
+class UsesFuncOutsideRealize : public IRVisitor {
+    const string &func;
+
+    using IRVisitor::visit;
+
+    void visit(const Realize *op) override {
+        if (op->name != func) {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const ProducerConsumer *op) override {
+        result |= (op->name == func);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Provide *op) override {
+        result |= (op->name == func);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        result |= (op->name == func);
+        IRVisitor::visit(op);
+    }
+
+public:
+    UsesFuncOutsideRealize(const string &f)
+        : func(f) {
+    }
+    bool result = false;
+};
+
+// Move a realization inside the body of the outermost enclosed loop,
+// if that loop is parallel and we slid over a serial loop inside it.
+// Each parallel task then gets its own sliding window, which
+// allocation bounds inference sizes to the task's footprint and
+// storage folding can then fold.
+class SinkRealizeIntoParallelLoop : public IRMutator {
+    const Realize *realize;
+    const set<string> &loops;
+
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (op->for_type != ForType::Parallel || !loops.count(op->name)) {
+            // Don't descend into other loops. Some iteration of a
+            // loop between here and a parallel loop could read values
+            // computed by a previous one.
+            return op;
+        }
+        sunk = true;
+        Stmt body = Realize::make(realize->name, realize->types, realize->memory_type,
+                                  realize->bounds, realize->condition, op->body);
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+public:
+    SinkRealizeIntoParallelLoop(const Realize *r, const set<string> &l)
+        : realize(r), loops(l) {
+    }
+    bool sunk = false;
 };
 
 // Perform sliding window optimization for all functions
@@ -392,10 +474,27 @@ class SlidingWindow : public IRMutator {
 
         debug(3) << "Doing sliding window analysis on realization of " << op->name << "\n";
 
-        new_body = SlidingWindowOnFunction(iter->second).mutate(new_body);
+        SlidingWindowOnFunction slider(iter->second);
+        new_body = slider.mutate(new_body);
 
         new_body = mutate(new_body);
 
+        if (sched.store_per_parallel_task() &&
+            !slider.parallel_loops_slid_within.empty() &&
+            !sched.async()) {
+            // We slid inside parallel strips, but the storage is
+            // shared between them, and the schedule asked for each
+            // strip to get its own.
+            SinkRealizeIntoParallelLoop sinker(op, slider.parallel_loops_slid_within);
+            Stmt sunk = sinker.mutate(new_body);
+            UsesFuncOutsideRealize uses(op->name);
+            sunk.accept(&uses);
+            if (sinker.sunk && !uses.result) {
+                debug(3) << "Moving realization of " << op->name << " inside parallel loop\n";
+                return sunk;
+            }
+        }
+
         if (new_body.same_as(op->body)) {
             return op;
         } else {
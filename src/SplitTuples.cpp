@@ -54,6 +54,42 @@ inline bool uses_extern_image(Stmt s) {
     return uses.result;
 }
 
+// Visitor and helper function to test if a value of a tuple provide
+// reads an element of the same Func other than the one it is stored to.
+class ReadsOtherTupleElement : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *c) override {
+        if (c->call_type == Call::Halide &&
+            c->name == func &&
+            c->value_index != value_index) {
+            result = true;
+        } else {
+            IRVisitor::visit(c);
+        }
+    }
+
+    const string &func;
+    int value_index;
+
+public:
+    ReadsOtherTupleElement(const string &func, int value_index)
+        : func(func), value_index(value_index) {
+    }
+    bool result = false;
+};
+
+inline bool reads_other_tuple_element(const Provide *op) {
+    for (size_t i = 0; i < op->values.size(); i++) {
+        ReadsOtherTupleElement reads(op->name, (int)i);
+        op->values[i].accept(&reads);
+        if (reads.result) {
+            return true;
+        }
+    }
+    return false;
+}
+
 class SplitTuples : public IRMutator {
     using IRMutator::visit;
 
@@ -146,10 +182,15 @@ class SplitTuples : public IRMutator {
             atomic = true;
         } else {
             // If the boxes provided and required might overlap,
-            // the provide must be done atomically.
+            // the provide must be done atomically. If each value
+            // only reads its own tuple element (e.g. a histogram of
+            // several independent sums), storing one element can't
+            // change the others, so they can still be done one at a
+            // time. This also lets atomic() updates of such tuples
+            // be done with per-element atomics instead of a mutex.
             Box provided = box_provided(op, op->name);
             Box required = box_required(op, op->name);
-            atomic = boxes_overlap(provided, required);
+            atomic = boxes_overlap(provided, required) && reads_other_tuple_element(op);
         }
 
         // Mutate the args
@@ -62,6 +62,12 @@ class FoldStorageOfFunction : public IRMutator {
 
     using IRMutator::visit;
 
+    Expr fold(const Expr &e) const {
+        // A factor only known at runtime is loop invariant, so the
+        // mod becomes a multiply and shifts.
+        return is_one(factor) ? 0 : (e % factor);
+    }
+
     Expr visit(const Call *op) override {
         Expr expr = IRMutator::visit(op);
         op = expr.as<Call>();
@@ -69,7 +75,7 @@ class FoldStorageOfFunction : public IRMutator {
         if (op->name == func && op->call_type == Call::Halide) {
             vector<Expr> args = op->args;
             internal_assert(dim < (int)args.size());
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             expr = Call::make(op->type, op->name, args, op->call_type,
                               op->func, op->value_index, op->image, op->param);
         } else if (op->name == Call::buffer_crop) {
@@ -99,7 +105,7 @@ class FoldStorageOfFunction : public IRMutator {
                 Expr old_extent = extents[dim];
 
                 // Rewrite the crop args
-                mins[dim] = old_min % factor;
+                mins[dim] = fold(old_min);
                 Expr new_mins = Call::make(type_of<int *>(), Call::make_struct, mins, Call::Intrinsic);
                 vector<Expr> new_args = op->args;
                 new_args[3] = new_mins;
@@ -143,7 +149,7 @@ class FoldStorageOfFunction : public IRMutator {
         internal_assert(op);
         if (op->name == func) {
             vector<Expr> args = op->args;
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             stmt = Provide::make(op->name, op->values, args);
         }
         return stmt;
@@ -407,8 +413,17 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
     Function func;
     bool explicit_only;
 
+    // Names defined inside the realization. A fold factor computed
+    // at runtime must be computable outside of it.
+    Scope<> defined_inside;
+
     using IRMutator::visit;
 
+    Stmt visit(const LetStmt *op) override {
+        ScopedBinding<> bind(defined_inside, op->name);
+        return IRMutator::visit(op);
+    }
+
     Stmt visit(const ProducerConsumer *op) override {
         if (op->name == func.name()) {
             // Can't proceed into the pipeline for this func
@@ -429,6 +444,8 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             return op;
         }
 
+        ScopedBinding<> bind(defined_inside, op->name);
+
         Stmt stmt;
         Stmt body = op->body;
 
@@ -602,6 +619,8 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             internal_assert(can_fold_forwards || can_fold_backwards);
 
             Expr factor;
+            string dynamic_factor_name;
+            Expr dynamic_factor_value, dynamic_factor_ok;
             if (explicit_factor.defined()) {
                 if (dynamic_footprint.empty() && !func.schedule().async()) {
                     // We were able to prove monotonicity
@@ -614,6 +633,15 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                                             Call::Extern);
                     body = Block::make(AssertStmt::make(extent <= explicit_factor, error), body);
                 }
+                if (func.schedule().async() && func.schedule().async_depth() > 1) {
+                    user_warning << "Func " << func.name() << " is scheduled async with depth "
+                                 << func.schedule().async_depth() << ", but its storage is folded "
+                                 << "by an explicit factor of " << explicit_factor
+                                 << " in dimension " << storage_dim.var << ". "
+                                 << "The explicit fold factor is used as-is, so the depth "
+                                 << "has no effect; increase the fold factor to let the "
+                                 << "producer run further ahead.\n";
+                }
                 factor = explicit_factor;
             } else {
                 // The max of the extent over all values of the loop variable must be a constant
@@ -624,8 +652,10 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
 
                 const int max_fold = 1024;
                 const int64_t *const_max_extent = as_const_int(max_extent);
+                int fold = 0;
+                Expr dynamic_max_extent;
                 if (const_max_extent && *const_max_extent <= max_fold) {
-                    factor = static_cast<int>(next_power_of_two(*const_max_extent));
+                    fold = static_cast<int>(next_power_of_two(*const_max_extent));
                 } else {
                     // Try a little harder to find a bounding power of two
                     int e = max_fold * 2;
@@ -635,15 +665,56 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                         e /= 2;
                     }
                     if (success) {
-                        factor = e;
+                        fold = e;
                     } else {
-                        debug(3) << "Not folding because extent not bounded by a constant not greater than " << max_fold << "\n"
-                                 << "extent = " << extent << "\n"
-                                 << "max extent = " << max_extent << "\n";
-                        // Try the next dimension
-                        continue;
+                        // There's no constant bound, but the extent
+                        // may still be bounded by something that
+                        // doesn't vary over the realization (e.g. a
+                        // blur with a runtime radius). If so, we can
+                        // compute the fold factor at allocation time.
+                        scope.push(op->name, Interval::everything());
+                        Interval extent_bounds = bounds_of_expr_in_scope(extent, scope);
+                        scope.pop(op->name);
+                        if (extent_bounds.has_upper_bound() &&
+                            !expr_uses_vars(extent_bounds.max, defined_inside)) {
+                            dynamic_max_extent = simplify(extent_bounds.max);
+                        } else {
+                            debug(3) << "Not folding because extent not bounded by a constant not greater than " << max_fold << "\n"
+                                     << "or by an expression invariant over the realization\n"
+                                     << "extent = " << extent << "\n"
+                                     << "max extent = " << max_extent << "\n";
+                            // Try the next dimension
+                            continue;
+                        }
                     }
                 }
+
+                // An async producer with a depth greater than one
+                // gets a ring buffer holding that many footprints,
+                // so it can run that many iterations ahead before
+                // the semaphore blocks it. Keep it a power of two so
+                // that the fold is still a mask.
+                const int depth = func.schedule().async() ? func.schedule().async_depth() : 1;
+                if (dynamic_max_extent.defined()) {
+                    // Round up to the next power of two at runtime. If
+                    // the bound times the depth is 2^30 or more, that
+                    // would overflow, and folding by the whole extent
+                    // would save nothing, so the realization runs
+                    // unfolded instead (see StorageFolding below).
+                    const int max_bound = (1 << 30) / depth;
+                    Expr bound = Halide::min(dynamic_max_extent, max_bound) * depth;
+                    Expr n = Halide::max(bound, 1) - 1;
+                    string name = unique_name(func.name() + ".fold_factor");
+                    factor = Variable::make(Int(32), name);
+                    dynamic_factor_name = name;
+                    dynamic_factor_value = make_one(Int(32)) << (32 - count_leading_zeros(n));
+                    dynamic_factor_ok = dynamic_max_extent < max_bound;
+                } else {
+                    if (depth > 1) {
+                        fold = static_cast<int>(next_power_of_two((int64_t)fold * depth));
+                    }
+                    factor = fold;
+                }
             }
 
             internal_assert(factor.defined());
@@ -651,6 +722,11 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             debug(3) << "Proceeding with factor " << factor << "\n";
 
             Fold fold = {(int)i - 1, factor};
+            if (!dynamic_factor_name.empty()) {
+                fold.dynamic_factor_name = dynamic_factor_name;
+                fold.dynamic_factor_value = dynamic_factor_value;
+                fold.dynamic_factor_ok = dynamic_factor_ok;
+            }
             dims_folded.push_back(fold);
             {
                 string head;
@@ -813,6 +889,11 @@ public:
         Semaphore semaphore;
         string head, tail;
         bool fold_forward;
+        // If the factor is computed at runtime, it's a Variable
+        // which must be defined outside the realization. The fold is
+        // only worth doing if dynamic_factor_ok holds.
+        string dynamic_factor_name;
+        Expr dynamic_factor_value, dynamic_factor_ok;
     };
     vector<Fold> dims_folded;
 
@@ -840,6 +921,7 @@ class StorageFolding : public IRMutator {
         bool explicit_only = count_producers(body, op->name) != 1;
         AttemptStorageFoldingOfFunction folder(func, explicit_only);
         debug(3) << "Attempting to fold " << op->name << "\n";
+        Stmt unfolded_body = body;
         body = folder.mutate(body);
 
         if (body.same_as(op->body)) {
@@ -889,6 +971,25 @@ class StorageFolding : public IRMutator {
                 }
             }
 
+            // Define the fold factors computed at runtime. Folding by
+            // more than the extent of the realization would only waste
+            // memory, so cap them at that. If a factor is too large to
+            // compute, folding wouldn't save anything, so run the
+            // realization unfolded.
+            Expr fold_ok = const_true();
+            for (const auto &fold : folder.dims_folded) {
+                if (!fold.dynamic_factor_name.empty()) {
+                    Expr value = min(fold.dynamic_factor_value, op->bounds[fold.dim].extent);
+                    stmt = LetStmt::make(fold.dynamic_factor_name, value, stmt);
+                    fold_ok = fold_ok && fold.dynamic_factor_ok;
+                }
+            }
+            if (!is_one(fold_ok)) {
+                Stmt unfolded = Realize::make(op->name, op->types, op->memory_type, op->bounds,
+                                              op->condition, unfolded_body);
+                stmt = IfThenElse::make(fold_ok, stmt, unfolded);
+            }
+
             return stmt;
         }
     }
@@ -123,6 +123,8 @@ struct Target {
         WasmSignExt = halide_target_feature_wasm_signext,
         SVE = halide_target_feature_sve,
         SVE2 = halide_target_feature_sve2,
+        ArenaAllocation = halide_target_feature_arena_allocation,
+        ParamProfile = halide_target_feature_param_profile,
         FeatureEnd = halide_target_feature_end
     };
     Target()
@@ -11,6 +11,9 @@
 #include "Target.h"
 
 #include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <vector>
@@ -21,8 +24,19 @@
 #include "v8.h"
 #include "libplatform/libplatform.h"
 #endif
+#ifdef WITH_WABT
+#include "src/binary-reader.h"
+#include "src/error-formatter.h"
+#include "src/feature.h"
+#include "src/interp/binary-reader-interp.h"
+#include "src/interp/interp.h"
+#endif
 // clang-format on
 
+#if defined(WITH_V8) && defined(WITH_WABT)
+#error "WITH_V8 and WITH_WABT are mutually exclusive."
+#endif
+
 // ---------------------
 
 // Debugging the WebAssembly JIT support is usually disconnected from the rest of HL_DEBUG_CODEGEN
@@ -247,51 +261,19 @@ using JITExternMap = std::map<std::string, Halide::JITExtern>;
 
 }  // namespace
 
-#ifdef WITH_V8
-
-#define V8_API_VERSION ((V8_MAJOR_VERSION * 10) + V8_MINOR_VERSION)
+#if defined(WITH_V8) || defined(WITH_WABT)
 
-static_assert(V8_API_VERSION >= 75,
-              "Halide requires V8 v7.5 or later when compiling WITH_V8.");
+// ---------------------
+// Engine-independent support shared by the V8 and wabt backends.
 
 namespace Halide {
 namespace Internal {
 namespace {
 
-v8::Local<v8::String> NewLocalString(v8::Isolate *isolate, const char *s) {
-#if V8_API_VERSION >= 76
-    return v8::String::NewFromUtf8(isolate, s).ToLocalChecked();
-#else
-    return v8::String::NewFromUtf8(isolate, s);
-#endif
-}
-
-using namespace v8;
-
 using wasm32_ptr_t = int32_t;
 
 const wasm32_ptr_t kMagicJitUserContextValue = -1;
 
-#if WASM_DEBUG_LEVEL
-void print_object_properties(Isolate *isolate, const Local<Value> &v) {
-    Local<Context> context = isolate->GetCurrentContext();
-    String::Utf8Value objascii(isolate, v);
-    wdebug(0) << *objascii << "\n";
-
-    if (v->IsObject()) {
-        Local<Object> obj = v.As<Object>();
-        Local<Array> properties = obj->GetPropertyNames(context).ToLocalChecked();
-        int len = properties->Length();
-        wdebug(0) << "Number of properties = " << len << ":\n";
-        for (int i = 0; i < len; ++i) {
-            const v8::Local<v8::Value> key = properties->Get(i);
-            String::Utf8Value str(isolate, key);
-            wdebug(0) << "\t" << i + 1 << ". " << *str << "\n";
-        }
-    }
-}
-#endif
-
 inline constexpr int halide_type_code(halide_type_code_t code, int bits) {
     return ((int)code) | (bits << 8);
 }
@@ -342,246 +324,166 @@ auto dynamic_type_dispatch(const halide_type_t &type, Args &&... args) -> declty
 
 // ------------------------------
 
-template<typename T>
-struct ExtractAndStoreScalar {
-    void operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-        *(T *)slot = (T)val->NumberValue(context).ToChecked();
-    }
+struct wasm_halide_buffer_t {
+    uint64_t device;
+    wasm32_ptr_t device_interface;  // halide_device_interface_t*
+    wasm32_ptr_t host;              // uint8_t*
+    uint64_t flags;
+    halide_type_t type;
+    int32_t dimensions;
+    wasm32_ptr_t dim;      // halide_dimension_t*
+    wasm32_ptr_t padding;  // always zero
 };
 
-template<>
-inline void ExtractAndStoreScalar<float16_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-    float16_t f((double)val->NumberValue(context).ToChecked());
-    *(uint16_t *)slot = f.to_bits();
-}
+static_assert(sizeof(halide_type_t) == 4, "halide_type_t");
+static_assert(sizeof(halide_dimension_t) == 16, "halide_dimension_t");
+static_assert(sizeof(wasm_halide_buffer_t) == 40, "wasm_halide_buffer_t");
 
-template<>
-inline void ExtractAndStoreScalar<bfloat16_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-    bfloat16_t b((double)val->NumberValue(context).ToChecked());
-    *(uint16_t *)slot = b.to_bits();
+JITUserContext *check_jit_user_context(JITUserContext *jit_user_context) {
+    user_assert(!jit_user_context->handlers.custom_malloc &&
+                !jit_user_context->handlers.custom_free)
+        << "The WebAssembly JIT cannot support set_custom_allocator()";
+    user_assert(!jit_user_context->handlers.custom_do_task)
+        << "The WebAssembly JIT cannot support set_custom_do_task()";
+    user_assert(!jit_user_context->handlers.custom_do_par_for)
+        << "The WebAssembly JIT cannot support set_custom_do_par_for()";
+    user_assert(!jit_user_context->handlers.custom_get_symbol &&
+                !jit_user_context->handlers.custom_load_library &&
+                !jit_user_context->handlers.custom_get_library_symbol)
+        << "The WebAssembly JIT cannot support custom_get_symbol, custom_load_library, or custom_get_library_symbol.";
+    return jit_user_context;
 }
 
-template<>
-inline void ExtractAndStoreScalar<void *>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-}
+// TODO: vector codegen can underead allocated buffers; we need to deliberately
+// allocate extra and return a pointer partway in to avoid out-of-bounds access
+// failures. https://github.com/halide/Halide/issues/3738
+constexpr size_t kExtraMallocSlop = 32;
 
-template<>
-inline void ExtractAndStoreScalar<uint64_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-}
+// Use a POD here so we can stuff it all into an ArrayBuffer to avoid having
+// to worry about lifetime management
+struct ExternArgType {
+    halide_type_t type;
+    bool is_void;
+    bool is_buffer;
+};
 
-template<>
-inline void ExtractAndStoreScalar<int64_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
+bool should_skip_extern_symbol(const std::string &name) {
+    static std::set<std::string> symbols = {
+        "halide_print",
+        "halide_error"};
+    return symbols.count(name) > 0;
 }
 
-// ------------------------------
-
-template<typename T>
-struct LoadAndReturnScalar {
-    void operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-        val.Set(*(const T *)slot);
-    }
-};
+std::vector<char> compile_to_wasm(const Module &module, const std::string &fn_name) {
+    static std::mutex link_lock;
+    std::lock_guard<std::mutex> lock(link_lock);
 
-template<>
-inline void LoadAndReturnScalar<float16_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-    float16_t f = float16_t::make_from_bits(*(const uint16_t *)slot);
-    val.Set((double)f);
-}
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> fn_module(compile_module_to_llvm_module(module, context));
 
-template<>
-inline void LoadAndReturnScalar<bfloat16_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-    bfloat16_t b = bfloat16_t::make_from_bits(*(const uint16_t *)slot);
-    val.Set((double)b);
-}
+    std::unique_ptr<llvm::Module> llvm_module =
+        link_with_wasm_jit_runtime(&context, module.target(), std::move(fn_module));
 
-template<>
-inline void LoadAndReturnScalar<void *>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-}
+    llvm::SmallVector<char, 4096> object;
+    llvm::raw_svector_ostream object_stream(object);
+    compile_llvm_module_to_object(*llvm_module, object_stream);
 
-template<>
-inline void LoadAndReturnScalar<uint64_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-}
+    // TODO: surely there's a better way that doesn't require spooling things
+    // out to temp files
+    TemporaryFile obj_file("", ".o");
+    write_entire_file(obj_file.pathname(), object.data(), object.size());
+#if WASM_DEBUG_LEVEL
+    obj_file.detach();
+    wdebug(0) << "Dumping obj_file to " << obj_file.pathname() << "\n";
+#endif
 
-template<>
-inline void LoadAndReturnScalar<int64_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-}
+    TemporaryFile wasm_output("", ".wasm");
 
-// ------------------------------
+    std::string lld_arg_strs[] = {
+        "HalideJITLinker",
+        // For debugging purposes:
+        // "--verbose",
+        // "-error-limit=0",
+        // "--print-gc-sections",
+        "--export=__data_end",
+        "--export=__heap_base",
+        "--allow-undefined",
+        obj_file.pathname(),
+        "--entry=" + fn_name,
+        "-o",
+        wasm_output.pathname()};
 
-template<typename T>
-struct WrapScalar {
-    Local<Value> operator()(const Local<Context> &context, const void *val_ptr) {
-        double val = *(const T *)(val_ptr);
-        Isolate *isolate = context->GetIsolate();
-        return Number::New(isolate, val);
-    }
-};
+    constexpr int c = sizeof(lld_arg_strs) / sizeof(lld_arg_strs[0]);
+    const char *lld_args[c];
+    for (int i = 0; i < c; ++i)
+        lld_args[i] = lld_arg_strs[i].c_str();
 
-template<>
-inline Local<Value> WrapScalar<float16_t>::operator()(const Local<Context> &context, const void *val_ptr) {
-    double val = (double)*(const uint16_t *)val_ptr;
-    Isolate *isolate = context->GetIsolate();
-    return Number::New(isolate, val);
-}
+#if LLVM_VERSION >= 100
+    std::string lld_errs_string;
+    llvm::raw_string_ostream lld_errs(lld_errs_string);
 
-template<>
-inline Local<Value> WrapScalar<bfloat16_t>::operator()(const Local<Context> &context, const void *val_ptr) {
-    double val = (double)*(const uint16_t *)val_ptr;
-    Isolate *isolate = context->GetIsolate();
-    return Number::New(isolate, val);
-}
+    if (!lld::wasm::link(lld_args, /*CanExitEarly*/ false, llvm::outs(), lld_errs)) {
+        internal_error << "lld::wasm::link failed: (" << lld_errs.str() << ")\n";
+    }
+#else
+    std::string lld_errs_string;
+    llvm::raw_string_ostream lld_errs(lld_errs_string);
 
-template<>
-inline Local<Value> WrapScalar<void *>::operator()(const Local<Context> &context, const void *val_ptr) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-    return Local<Value>();
-}
+    if (!lld::wasm::link(lld_args, /*CanExitEarly*/ false, lld_errs)) {
+        internal_error << "lld::wasm::link failed: (" << lld_errs.str() << ")\n";
+    }
+#endif
 
-template<>
-inline Local<Value> WrapScalar<uint64_t>::operator()(const Local<Context> &context, const void *val_ptr) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-    return Local<Value>();
-}
+#if WASM_DEBUG_LEVEL
+    wasm_output.detach();
+    wdebug(0) << "Dumping linked wasm to " << wasm_output.pathname() << "\n";
+#endif
 
-template<>
-inline Local<Value> WrapScalar<int64_t>::operator()(const Local<Context> &context, const void *val_ptr) {
-    internal_error << "TODO: 64-bit slots aren't yet supported";
-    return Local<Value>();
+    return read_entire_file(wasm_output.pathname());
 }
 
 // ------------------------------
+// Host-side implementations shared by both engines. The engine-specific
+// callbacks only unpack their arguments, call these, and wrap the result.
+
+// How to reach a module's linear memory: allocate a region of it (which
+// can grow it, and so move it), and find where it currently starts.
+struct WasmMemory {
+    std::function<wasm32_ptr_t(size_t)> malloc;
+    std::function<uint8_t *()> base;
+};
 
-Local<Value> wrap_scalar(const Local<Context> &context, const Type &t, const void *val_ptr) {
-    return dynamic_type_dispatch<WrapScalar>(t, context, val_ptr);
-}
+void dump_hostbuf(const halide_buffer_t *buf, const std::string &label) {
+#if WASM_DEBUG_LEVEL >= 2
+    const halide_dimension_t *dim = buf->dim;
+    const uint8_t *host = buf->host;
 
-template<typename T>
-Local<Value> wrap_scalar(const Local<Context> &context, const T &val) {
-    return WrapScalar<T>()(context, &val);
+    wdebug(0) << label << " = " << (void *)buf << " = {\n";
+    wdebug(0) << "  device = " << buf->device << "\n";
+    wdebug(0) << "  device_interface = " << buf->device_interface << "\n";
+    wdebug(0) << "  host = " << (void *)host << " = {\n";
+    if (host) {
+        wdebug(0) << "    " << (int)host[0] << ", " << (int)host[1] << ", " << (int)host[2] << ", " << (int)host[3] << "...\n";
+    }
+    wdebug(0) << "  }\n";
+    wdebug(0) << "  flags = " << buf->flags << "\n";
+    wdebug(0) << "  type = " << (int)buf->type.code << "," << (int)buf->type.bits << "," << buf->type.lanes << "\n";
+    wdebug(0) << "  dimensions = " << buf->dimensions << "\n";
+    wdebug(0) << "  dim = " << (void *)buf->dim << " = {\n";
+    for (int i = 0; i < buf->dimensions; i++) {
+        const auto &d = dim[i];
+        wdebug(0) << "    {" << d.min << "," << d.extent << "," << d.stride << "," << d.flags << "},\n";
+    }
+    wdebug(0) << "  }\n";
+    wdebug(0) << "  padding = " << buf->padding << "\n";
+    wdebug(0) << "}\n";
+#endif
 }
 
-// ---------------------------------
-
-enum EmbedderDataSlots {
-    // don't use slot 0
-    kWasmMemoryObject = 1,
-    kBDMallocPtr,
-    kHeapBase,
-    kJitUserContext,
-    kString_buffer,
-    kString_grow,
-};
-
-wasm32_ptr_t v8_WasmMemoryObject_malloc(const Local<Context> &context, size_t size) {
-    Isolate *isolate = context->GetIsolate();
-
-    BDMalloc *bdmalloc = (BDMalloc *)context->GetAlignedPointerFromEmbedderData(kBDMallocPtr);
-    if (!bdmalloc->inited()) {
-        int32_t heap_base = context->GetEmbedderData(kHeapBase)->Int32Value(context).ToChecked();
-
-        Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
-        Local<Object> buffer_string = context->GetEmbedderData(kString_buffer).As<Object>();
-        Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, buffer_string).ToLocalChecked());
-
-        wdebug(0) << "heap_base is: " << heap_base << "\n";
-        wdebug(0) << "initial memory size is: " << wasm_memory->ByteLength() << "\n";
-        bdmalloc->init(wasm_memory->ByteLength(), heap_base);
-    }
-
-    wasm32_ptr_t p = bdmalloc->alloc_region(size);
-    if (!p) {
-        Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
-
-        constexpr int kWasmPageSize = 65536;
-        const int32_t pages_needed = (size + kWasmPageSize - 1) / 65536;
-        wdebug(0) << "attempting to grow by pages: " << pages_needed << "\n";
-
-        Local<Value> args[1] = {Integer::New(isolate, pages_needed)};
-        int32_t result = memory_value
-                             ->Get(context, context->GetEmbedderData(kString_grow))
-                             .ToLocalChecked()
-                             .As<Object>()
-                             ->CallAsFunction(context, memory_value, 1, args)
-                             .ToLocalChecked()
-                             ->Int32Value(context)
-                             .ToChecked();
-        wdebug(0) << "grow result: " << result << "\n";
-        internal_assert(result == (int)(bdmalloc->get_total_size() / kWasmPageSize));
-
-        Local<Object> buffer_string = context->GetEmbedderData(kString_buffer).As<Object>();
-        Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, buffer_string).ToLocalChecked());
-        wdebug(0) << "New ArrayBuffer size is: " << wasm_memory->ByteLength() << "\n";
-
-        bdmalloc->grow_total_size(wasm_memory->ByteLength());
-        p = bdmalloc->alloc_region(size);
-    }
-
-    wdebug(2) << "allocation of " << size << " at: " << p << "\n";
-    return p;
-}
-
-void v8_WasmMemoryObject_free(const Local<Context> &context, wasm32_ptr_t ptr) {
-    wdebug(2) << "freeing ptr at: " << ptr << "\n";
-    BDMalloc *bdmalloc = (BDMalloc *)context->GetAlignedPointerFromEmbedderData(kBDMallocPtr);
-    bdmalloc->free_region(ptr);
-}
-
-uint8_t *get_wasm_memory_base(const Local<Context> &context) {
-    Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
-    Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, context->GetEmbedderData(kString_buffer)).ToLocalChecked());
-    uint8_t *p = (uint8_t *)wasm_memory->GetContents().Data();
-    return p;
-}
-
-struct wasm_halide_buffer_t {
-    uint64_t device;
-    wasm32_ptr_t device_interface;  // halide_device_interface_t*
-    wasm32_ptr_t host;              // uint8_t*
-    uint64_t flags;
-    halide_type_t type;
-    int32_t dimensions;
-    wasm32_ptr_t dim;      // halide_dimension_t*
-    wasm32_ptr_t padding;  // always zero
-};
-
-void dump_hostbuf(const Local<Context> &context, const halide_buffer_t *buf, const std::string &label) {
-#if WASM_DEBUG_LEVEL >= 2
-    const halide_dimension_t *dim = buf->dim;
-    const uint8_t *host = buf->host;
-
-    wdebug(0) << label << " = " << (void *)buf << " = {\n";
-    wdebug(0) << "  device = " << buf->device << "\n";
-    wdebug(0) << "  device_interface = " << buf->device_interface << "\n";
-    wdebug(0) << "  host = " << (void *)host << " = {\n";
-    if (host) {
-        wdebug(0) << "    " << (int)host[0] << ", " << (int)host[1] << ", " << (int)host[2] << ", " << (int)host[3] << "...\n";
-    }
-    wdebug(0) << "  }\n";
-    wdebug(0) << "  flags = " << buf->flags << "\n";
-    wdebug(0) << "  type = " << (int)buf->type.code << "," << (int)buf->type.bits << "," << buf->type.lanes << "\n";
-    wdebug(0) << "  dimensions = " << buf->dimensions << "\n";
-    wdebug(0) << "  dim = " << (void *)buf->dim << " = {\n";
-    for (int i = 0; i < buf->dimensions; i++) {
-        const auto &d = dim[i];
-        wdebug(0) << "    {" << d.min << "," << d.extent << "," << d.stride << "," << d.flags << "},\n";
-    }
-    wdebug(0) << "  }\n";
-    wdebug(0) << "  padding = " << buf->padding << "\n";
-    wdebug(0) << "}\n";
-#endif
-}
-
-void dump_wasmbuf(const Local<Context> &context, wasm32_ptr_t buf_ptr, const std::string &label) {
+void dump_wasmbuf(uint8_t *base, wasm32_ptr_t buf_ptr, const std::string &label) {
 #if WASM_DEBUG_LEVEL >= 2
     internal_assert(buf_ptr);
 
-    uint8_t *base = get_wasm_memory_base(context);
     wasm_halide_buffer_t *buf = (wasm_halide_buffer_t *)(base + buf_ptr);
     halide_dimension_t *dim = buf->dim ? (halide_dimension_t *)(base + buf->dim) : nullptr;
     uint8_t *host = buf->host ? (base + buf->host) : nullptr;
@@ -608,20 +510,12 @@ void dump_wasmbuf(const Local<Context> &context, wasm32_ptr_t buf_ptr, const std
 #endif
 }
 
-static_assert(sizeof(halide_type_t) == 4, "halide_type_t");
-static_assert(sizeof(halide_dimension_t) == 16, "halide_dimension_t");
-static_assert(sizeof(wasm_halide_buffer_t) == 40, "wasm_halide_buffer_t");
-
 // Given a halide_buffer_t on the host, allocate a wasm_halide_buffer_t in wasm
 // memory space and copy all relevant data. The resulting buf is laid out in
-// contiguous memory, and can be free with a single free().
-wasm32_ptr_t hostbuf_to_wasmbuf(const Local<Context> &context, const halide_buffer_t *src) {
-    static_assert(sizeof(halide_type_t) == 4, "halide_type_t");
-    static_assert(sizeof(halide_dimension_t) == 16, "halide_dimension_t");
-    static_assert(sizeof(wasm_halide_buffer_t) == 40, "wasm_halide_buffer_t");
-
+// contiguous memory, and can be freed with a single free().
+wasm32_ptr_t hostbuf_to_wasmbuf(const WasmMemory &memory, const halide_buffer_t *src) {
     wdebug(0) << "\nhostbuf_to_wasmbuf:\n";
-    dump_hostbuf(context, src, "src");
+    dump_hostbuf(src, "src");
 
     internal_assert(src->device == 0);
     internal_assert(src->device_interface == nullptr);
@@ -635,10 +529,11 @@ wasm32_ptr_t hostbuf_to_wasmbuf(const Local<Context> &context, const halide_buff
     const size_t host_size_in_bytes = src->size_in_bytes();
     const size_t mem_needed = host_offset + host_size_in_bytes;
 
-    const wasm32_ptr_t dst_ptr = v8_WasmMemoryObject_malloc(context, mem_needed);
+    const wasm32_ptr_t dst_ptr = memory.malloc(mem_needed);
     internal_assert(dst_ptr);
 
-    uint8_t *base = get_wasm_memory_base(context);
+    // The allocation may have moved the memory.
+    uint8_t *base = memory.base();
 
     wasm_halide_buffer_t *dst = (wasm_halide_buffer_t *)(base + dst_ptr);
     dst->device = 0;
@@ -657,21 +552,19 @@ wasm32_ptr_t hostbuf_to_wasmbuf(const Local<Context> &context, const halide_buff
         memcpy(base + dst->host, src->host, host_size_in_bytes);
     }
 
-    dump_wasmbuf(context, dst_ptr, "dst");
+    dump_wasmbuf(base, dst_ptr, "dst");
 
     return dst_ptr;
 }
 
 // Given a pointer to a wasm_halide_buffer_t in wasm memory space,
 // allocate a Buffer<> on the host and copy all relevant data.
-void wasmbuf_to_hostbuf(const Local<Context> &context, wasm32_ptr_t src_ptr, Halide::Runtime::Buffer<> &dst) {
+void wasmbuf_to_hostbuf(uint8_t *base, wasm32_ptr_t src_ptr, Halide::Runtime::Buffer<> &dst) {
     wdebug(0) << "\nwasmbuf_to_hostbuf:\n";
-    dump_wasmbuf(context, src_ptr, "src");
+    dump_wasmbuf(base, src_ptr, "src");
 
     internal_assert(src_ptr);
 
-    uint8_t *base = get_wasm_memory_base(context);
-
     wasm_halide_buffer_t *src = (wasm_halide_buffer_t *)(base + src_ptr);
 
     internal_assert(src->device == 0);
@@ -687,7 +580,7 @@ void wasmbuf_to_hostbuf(const Local<Context> &context, wasm32_ptr_t src_ptr, Hal
     dst_tmp.dim = src->dim ? (halide_dimension_t *)(base + src->dim) : nullptr;
     dst_tmp.padding = 0;
 
-    dump_hostbuf(context, &dst_tmp, "dst_tmp");
+    dump_hostbuf(&dst_tmp, "dst_tmp");
 
     dst = Halide::Runtime::Buffer<>(dst_tmp);
     if (src->host) {
@@ -696,18 +589,16 @@ void wasmbuf_to_hostbuf(const Local<Context> &context, wasm32_ptr_t src_ptr, Hal
         const size_t host_size_in_bytes = dst.raw_buffer()->size_in_bytes();
         memcpy(dst.raw_buffer()->host, base + src->host, host_size_in_bytes);
     }
-    dump_hostbuf(context, dst.raw_buffer(), "dst");
+    dump_hostbuf(dst.raw_buffer(), "dst");
 }
 
 // Given a wasm_halide_buffer_t, copy possibly-changed data into a halide_buffer_t.
 // Both buffers are asserted to match in type and dimensions.
-void copy_wasmbuf_to_existing_hostbuf(const Local<Context> &context, wasm32_ptr_t src_ptr, halide_buffer_t *dst) {
+void copy_wasmbuf_to_existing_hostbuf(uint8_t *base, wasm32_ptr_t src_ptr, halide_buffer_t *dst) {
     internal_assert(src_ptr && dst);
 
     wdebug(0) << "\ncopy_wasmbuf_to_existing_hostbuf:\n";
-    dump_wasmbuf(context, src_ptr, "src");
-
-    uint8_t *base = get_wasm_memory_base(context);
+    dump_wasmbuf(base, src_ptr, "src");
 
     wasm_halide_buffer_t *src = (wasm_halide_buffer_t *)(base + src_ptr);
     internal_assert(src->device == 0);
@@ -715,7 +606,7 @@ void copy_wasmbuf_to_existing_hostbuf(const Local<Context> &context, wasm32_ptr_
     internal_assert(src->dimensions == dst->dimensions);
     internal_assert(src->type == dst->type);
 
-    dump_hostbuf(context, dst, "dst_pre");
+    dump_hostbuf(dst, "dst_pre");
 
     if (src->dimensions) {
         memcpy(dst->dim, base + src->dim, sizeof(halide_dimension_t) * src->dimensions);
@@ -729,18 +620,16 @@ void copy_wasmbuf_to_existing_hostbuf(const Local<Context> &context, wasm32_ptr_
     dst->device_interface = 0;
     dst->flags = src->flags;
 
-    dump_hostbuf(context, dst, "dst_post");
+    dump_hostbuf(dst, "dst_post");
 }
 
 // Given a halide_buffer_t, copy possibly-changed data into a wasm_halide_buffer_t.
 // Both buffers are asserted to match in type and dimensions.
-void copy_hostbuf_to_existing_wasmbuf(const Local<Context> &context, const halide_buffer_t *src, wasm32_ptr_t dst_ptr) {
+void copy_hostbuf_to_existing_wasmbuf(uint8_t *base, const halide_buffer_t *src, wasm32_ptr_t dst_ptr) {
     internal_assert(src && dst_ptr);
 
     wdebug(0) << "\ncopy_hostbuf_to_existing_wasmbuf:\n";
-    dump_hostbuf(context, src, "src");
-
-    uint8_t *base = get_wasm_memory_base(context);
+    dump_hostbuf(src, "src");
 
     wasm_halide_buffer_t *dst = (wasm_halide_buffer_t *)(base + dst_ptr);
     internal_assert(src->device == 0);
@@ -748,7 +637,7 @@ void copy_hostbuf_to_existing_wasmbuf(const Local<Context> &context, const halid
     internal_assert(src->dimensions == dst->dimensions);
     internal_assert(src->type == dst->type);
 
-    dump_wasmbuf(context, dst_ptr, "dst_pre");
+    dump_wasmbuf(base, dst_ptr, "dst_pre");
 
     if (src->dimensions) {
         memcpy(base + dst->dim, src->dim, sizeof(halide_dimension_t) * src->dimensions);
@@ -762,50 +651,10 @@ void copy_hostbuf_to_existing_wasmbuf(const Local<Context> &context, const halid
     dst->device_interface = 0;
     dst->flags = src->flags;
 
-    dump_wasmbuf(context, dst_ptr, "dst_post");
-}
-
-JITUserContext *check_jit_user_context(JITUserContext *jit_user_context) {
-    user_assert(!jit_user_context->handlers.custom_malloc &&
-                !jit_user_context->handlers.custom_free)
-        << "The WebAssembly JIT cannot support set_custom_allocator()";
-    user_assert(!jit_user_context->handlers.custom_do_task)
-        << "The WebAssembly JIT cannot support set_custom_do_task()";
-    user_assert(!jit_user_context->handlers.custom_do_par_for)
-        << "The WebAssembly JIT cannot support set_custom_do_par_for()";
-    user_assert(!jit_user_context->handlers.custom_get_symbol &&
-                !jit_user_context->handlers.custom_load_library &&
-                !jit_user_context->handlers.custom_get_library_symbol)
-        << "The WebAssembly JIT cannot support custom_get_symbol, custom_load_library, or custom_get_library_symbol.";
-    return jit_user_context;
-}
-
-// Some internal code can call halide_error(null, ...), so this needs to be resilient to that.
-// Callers must expect null and not crash.
-JITUserContext *get_jit_user_context(const Local<Context> &context, const Local<Value> &arg) {
-    int32_t ucon_magic = arg->Int32Value(context).ToChecked();
-    if (ucon_magic == 0) {
-        return nullptr;
-    }
-    internal_assert(ucon_magic == kMagicJitUserContextValue);
-    JITUserContext *jit_user_context = (JITUserContext *)context->GetAlignedPointerFromEmbedderData(kJitUserContext);
-    internal_assert(jit_user_context);
-    return jit_user_context;
+    dump_wasmbuf(base, dst_ptr, "dst_post");
 }
 
-void wasm_jit_halide_print_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    internal_assert(args.Length() == 2);
-
-    Isolate *isolate = args.GetIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
-    HandleScope scope(isolate);
-
-    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
-    const int32_t str_address = args[1]->Int32Value(context).ToChecked();
-
-    uint8_t *p = get_wasm_memory_base(context);
-    const char *str = (const char *)p + str_address;
-
+void jit_halide_print(JITUserContext *jit_user_context, const char *str) {
     if (jit_user_context && jit_user_context->handlers.custom_print != NULL) {
         (*jit_user_context->handlers.custom_print)(jit_user_context, str);
         debug(0) << str;
@@ -814,19 +663,7 @@ void wasm_jit_halide_print_callback(const v8::FunctionCallbackInfo<v8::Value> &a
     }
 }
 
-void wasm_jit_halide_error_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    internal_assert(args.Length() == 2);
-
-    Isolate *isolate = args.GetIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
-    HandleScope scope(isolate);
-
-    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
-    const int32_t str_address = args[1]->Int32Value(context).ToChecked();
-
-    uint8_t *p = get_wasm_memory_base(context);
-    const char *str = (const char *)p + str_address;
-
+void jit_halide_error(JITUserContext *jit_user_context, const char *str) {
     if (jit_user_context && jit_user_context->handlers.custom_error != NULL) {
         (*jit_user_context->handlers.custom_error)(jit_user_context, str);
     } else {
@@ -834,27 +671,19 @@ void wasm_jit_halide_error_callback(const v8::FunctionCallbackInfo<v8::Value> &a
     }
 }
 
-void wasm_jit_halide_trace_helper_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    internal_assert(args.Length() == 12);
-    Isolate *isolate = args.GetIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
-    HandleScope scope(isolate);
-
-    uint8_t *base = get_wasm_memory_base(context);
-
-    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
-
-    const wasm32_ptr_t func_name_ptr = args[1]->Int32Value(context).ToChecked();
-    const wasm32_ptr_t value_ptr = args[2]->Int32Value(context).ToChecked();
-    const wasm32_ptr_t coordinates_ptr = args[3]->Int32Value(context).ToChecked();
-    const int type_code = args[4]->Int32Value(context).ToChecked();
-    const int type_bits = args[5]->Int32Value(context).ToChecked();
-    const int type_lanes = args[6]->Int32Value(context).ToChecked();
-    const int trace_code = args[7]->Int32Value(context).ToChecked();
-    const int parent_id = args[8]->Int32Value(context).ToChecked();
-    const int value_index = args[9]->Int32Value(context).ToChecked();
-    const int dimensions = args[10]->Int32Value(context).ToChecked();
-    const wasm32_ptr_t trace_tag_ptr = args[11]->Int32Value(context).ToChecked();
+// args are the 11 arguments of halide_trace_helper after the user context.
+int32_t jit_halide_trace_helper(JITUserContext *jit_user_context, uint8_t *base, const int32_t *args) {
+    const wasm32_ptr_t func_name_ptr = args[0];
+    const wasm32_ptr_t value_ptr = args[1];
+    const wasm32_ptr_t coordinates_ptr = args[2];
+    const int type_code = args[3];
+    const int type_bits = args[4];
+    const int type_lanes = args[5];
+    const int trace_code = args[6];
+    const int parent_id = args[7];
+    const int value_index = args[8];
+    const int dimensions = args[9];
+    const wasm32_ptr_t trace_tag_ptr = args[10];
 
     internal_assert(dimensions >= 0 && dimensions < 1024);  // not a hard limit, just a sanity check
 
@@ -871,80 +700,427 @@ void wasm_jit_halide_trace_helper_callback(const v8::FunctionCallbackInfo<v8::Va
     event.value_index = value_index;
     event.dimensions = dimensions;
 
-    int result = 0;
+    int32_t result = 0;
     if (jit_user_context && jit_user_context->handlers.custom_trace != NULL) {
         result = (*jit_user_context->handlers.custom_trace)(jit_user_context, &event);
     } else {
         debug(0) << "Dropping trace event due to lack of trace handler.\n";
     }
-
-    args.GetReturnValue().Set(wrap_scalar(context, result));
+    return result;
 }
 
-// TODO: vector codegen can underead allocated buffers; we need to deliberately
-// allocate extra and return a pointer partway in to avoid out-of-bounds access
-// failures. https://github.com/halide/Halide/issues/3738
-constexpr size_t kExtraMallocSlop = 32;
-
-void wasm_jit_malloc_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    Isolate *isolate = args.GetIsolate();
-    HandleScope scope(isolate);
-    Local<Context> context = isolate->GetCurrentContext();
-
-    size_t size = args[0]->Int32Value(context).ToChecked() + kExtraMallocSlop;
-    wasm32_ptr_t p = v8_WasmMemoryObject_malloc(context, size);
-    if (p) p += kExtraMallocSlop;
-    args.GetReturnValue().Set(wrap_scalar(context, p));
-}
+wasm32_ptr_t jit_getenv(const WasmMemory &memory, wasm32_ptr_t s) {
+    const char *e = getenv((char *)memory.base() + s);
 
-void wasm_jit_free_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    Isolate *isolate = args.GetIsolate();
-    HandleScope scope(isolate);
-    Local<Context> context = isolate->GetCurrentContext();
-    wasm32_ptr_t p = args[0]->Int32Value(context).ToChecked();
-    if (p) p -= kExtraMallocSlop;
-    v8_WasmMemoryObject_free(context, p);
+    // TODO: this string is leaked
+    wasm32_ptr_t r = 0;
+    if (e) {
+        r = memory.malloc(strlen(e) + 1);
+        strcpy((char *)memory.base() + r, e);
+    }
+    return r;
 }
 
-void wasm_jit_abort_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    abort();
-}
+using TrampolineFn = void (*)(void **);
 
-void wasm_jit_strlen_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    Isolate *isolate = args.GetIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
-    HandleScope scope(isolate);
+// Call the trampoline of an extern function. get_buffer_arg(i) returns
+// the wasm address of the i'th argument if it's a buffer, and
+// store_scalar_arg(i, slot) stores the i'th argument into a 64-bit slot
+// if it's a scalar. Buffers are copied out of wasm memory for the call,
+// and back again afterwards. Returns the return value (if any) in a
+// 64-bit slot.
+uint64_t call_extern_trampoline(TrampolineFn trampoline, uint8_t *base,
+                                const ExternArgType &ret_type,
+                                const ExternArgType *arg_types, size_t arg_types_len,
+                                const std::function<wasm32_ptr_t(size_t)> &get_buffer_arg,
+                                const std::function<void(size_t, void *)> &store_scalar_arg) {
+    // There's wasted space here, but that's ok.
+    std::vector<Halide::Runtime::Buffer<>> buffers(arg_types_len);
+    std::vector<uint64_t> scalars(arg_types_len);
+    std::vector<void *> trampoline_args(arg_types_len);
 
-    const int32_t s = args[0]->Int32Value(context).ToChecked();
+    for (size_t i = 0; i < arg_types_len; ++i) {
+        if (arg_types[i].is_buffer) {
+            wasmbuf_to_hostbuf(base, get_buffer_arg(i), buffers[i]);
+            trampoline_args[i] = buffers[i].raw_buffer();
+        } else {
+            store_scalar_arg(i, &scalars[i]);
+            trampoline_args[i] = &scalars[i];
+        }
+    }
 
-    uint8_t *base = get_wasm_memory_base(context);
-    int32_t r = strlen((char *)base + s);
+    // The return value (if any) is always scalar.
+    uint64_t ret_val = 0;
+    internal_assert(!ret_type.is_buffer);
+    if (!ret_type.is_void) {
+        trampoline_args.push_back(&ret_val);
+    }
+    (*trampoline)(trampoline_args.data());
 
-    args.GetReturnValue().Set(wrap_scalar(context, r));
+    // Progagate buffer data backwards. Note that for arbitrary extern functions,
+    // we have no idea which buffers might be "input only", so we copy all data for all of them.
+    for (size_t i = 0; i < arg_types_len; ++i) {
+        if (arg_types[i].is_buffer) {
+            copy_hostbuf_to_existing_wasmbuf(base, buffers[i], get_buffer_arg(i));
+        }
+    }
+    return ret_val;
 }
 
-void wasm_jit_write_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    internal_error << "WebAssembly JIT does not yet support the write() call.";
-}
+}  // namespace
+}  // namespace Internal
+}  // namespace Halide
 
-void wasm_jit_getenv_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
-    Isolate *isolate = args.GetIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
-    HandleScope scope(isolate);
+#endif  // defined(WITH_V8) || defined(WITH_WABT)
 
-    const int32_t s = args[0]->Int32Value(context).ToChecked();
+#ifdef WITH_V8
 
-    uint8_t *base = get_wasm_memory_base(context);
-    char *e = getenv((char *)base + s);
+#define V8_API_VERSION ((V8_MAJOR_VERSION * 10) + V8_MINOR_VERSION)
 
-    // TODO: this string is leaked
-    if (e) {
-        wasm32_ptr_t r = v8_WasmMemoryObject_malloc(context, strlen(e) + 1);
-        strcpy((char *)base + r, e);
-        args.GetReturnValue().Set(wrap_scalar(context, r));
-    } else {
-        args.GetReturnValue().Set(wrap_scalar<wasm32_ptr_t>(context, 0));
+static_assert(V8_API_VERSION >= 75,
+              "Halide requires V8 v7.5 or later when compiling WITH_V8.");
+
+namespace Halide {
+namespace Internal {
+namespace {
+
+v8::Local<v8::String> NewLocalString(v8::Isolate *isolate, const char *s) {
+#if V8_API_VERSION >= 76
+    return v8::String::NewFromUtf8(isolate, s).ToLocalChecked();
+#else
+    return v8::String::NewFromUtf8(isolate, s);
+#endif
+}
+
+using namespace v8;
+
+#if WASM_DEBUG_LEVEL
+void print_object_properties(Isolate *isolate, const Local<Value> &v) {
+    Local<Context> context = isolate->GetCurrentContext();
+    String::Utf8Value objascii(isolate, v);
+    wdebug(0) << *objascii << "\n";
+
+    if (v->IsObject()) {
+        Local<Object> obj = v.As<Object>();
+        Local<Array> properties = obj->GetPropertyNames(context).ToLocalChecked();
+        int len = properties->Length();
+        wdebug(0) << "Number of properties = " << len << ":\n";
+        for (int i = 0; i < len; ++i) {
+            const v8::Local<v8::Value> key = properties->Get(i);
+            String::Utf8Value str(isolate, key);
+            wdebug(0) << "\t" << i + 1 << ". " << *str << "\n";
+        }
+    }
+}
+#endif
+
+template<typename T>
+struct ExtractAndStoreScalar {
+    void operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+        *(T *)slot = (T)val->NumberValue(context).ToChecked();
+    }
+};
+
+template<>
+inline void ExtractAndStoreScalar<float16_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+    float16_t f((double)val->NumberValue(context).ToChecked());
+    *(uint16_t *)slot = f.to_bits();
+}
+
+template<>
+inline void ExtractAndStoreScalar<bfloat16_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+    bfloat16_t b((double)val->NumberValue(context).ToChecked());
+    *(uint16_t *)slot = b.to_bits();
+}
+
+template<>
+inline void ExtractAndStoreScalar<void *>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+template<>
+inline void ExtractAndStoreScalar<uint64_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+template<>
+inline void ExtractAndStoreScalar<int64_t>::operator()(const Local<Context> &context, const Local<Value> &val, void *slot) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+// ------------------------------
+
+template<typename T>
+struct LoadAndReturnScalar {
+    void operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+        val.Set(*(const T *)slot);
+    }
+};
+
+template<>
+inline void LoadAndReturnScalar<float16_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+    float16_t f = float16_t::make_from_bits(*(const uint16_t *)slot);
+    val.Set((double)f);
+}
+
+template<>
+inline void LoadAndReturnScalar<bfloat16_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+    bfloat16_t b = bfloat16_t::make_from_bits(*(const uint16_t *)slot);
+    val.Set((double)b);
+}
+
+template<>
+inline void LoadAndReturnScalar<void *>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+template<>
+inline void LoadAndReturnScalar<uint64_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+template<>
+inline void LoadAndReturnScalar<int64_t>::operator()(const Local<Context> &context, const void *slot, ReturnValue<Value> val) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+}
+
+// ------------------------------
+
+template<typename T>
+struct WrapScalar {
+    Local<Value> operator()(const Local<Context> &context, const void *val_ptr) {
+        double val = *(const T *)(val_ptr);
+        Isolate *isolate = context->GetIsolate();
+        return Number::New(isolate, val);
     }
+};
+
+template<>
+inline Local<Value> WrapScalar<float16_t>::operator()(const Local<Context> &context, const void *val_ptr) {
+    double val = (double)*(const uint16_t *)val_ptr;
+    Isolate *isolate = context->GetIsolate();
+    return Number::New(isolate, val);
+}
+
+template<>
+inline Local<Value> WrapScalar<bfloat16_t>::operator()(const Local<Context> &context, const void *val_ptr) {
+    double val = (double)*(const uint16_t *)val_ptr;
+    Isolate *isolate = context->GetIsolate();
+    return Number::New(isolate, val);
+}
+
+template<>
+inline Local<Value> WrapScalar<void *>::operator()(const Local<Context> &context, const void *val_ptr) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+    return Local<Value>();
+}
+
+template<>
+inline Local<Value> WrapScalar<uint64_t>::operator()(const Local<Context> &context, const void *val_ptr) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+    return Local<Value>();
+}
+
+template<>
+inline Local<Value> WrapScalar<int64_t>::operator()(const Local<Context> &context, const void *val_ptr) {
+    internal_error << "TODO: 64-bit slots aren't yet supported";
+    return Local<Value>();
+}
+
+// ------------------------------
+
+Local<Value> wrap_scalar(const Local<Context> &context, const Type &t, const void *val_ptr) {
+    return dynamic_type_dispatch<WrapScalar>(t, context, val_ptr);
+}
+
+template<typename T>
+Local<Value> wrap_scalar(const Local<Context> &context, const T &val) {
+    return WrapScalar<T>()(context, &val);
+}
+
+// ---------------------------------
+
+enum EmbedderDataSlots {
+    // don't use slot 0
+    kWasmMemoryObject = 1,
+    kBDMallocPtr,
+    kHeapBase,
+    kJitUserContext,
+    kString_buffer,
+    kString_grow,
+};
+
+wasm32_ptr_t v8_WasmMemoryObject_malloc(const Local<Context> &context, size_t size) {
+    Isolate *isolate = context->GetIsolate();
+
+    BDMalloc *bdmalloc = (BDMalloc *)context->GetAlignedPointerFromEmbedderData(kBDMallocPtr);
+    if (!bdmalloc->inited()) {
+        int32_t heap_base = context->GetEmbedderData(kHeapBase)->Int32Value(context).ToChecked();
+
+        Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
+        Local<Object> buffer_string = context->GetEmbedderData(kString_buffer).As<Object>();
+        Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, buffer_string).ToLocalChecked());
+
+        wdebug(0) << "heap_base is: " << heap_base << "\n";
+        wdebug(0) << "initial memory size is: " << wasm_memory->ByteLength() << "\n";
+        bdmalloc->init(wasm_memory->ByteLength(), heap_base);
+    }
+
+    wasm32_ptr_t p = bdmalloc->alloc_region(size);
+    if (!p) {
+        Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
+
+        constexpr int kWasmPageSize = 65536;
+        const int32_t pages_needed = (size + kWasmPageSize - 1) / 65536;
+        wdebug(0) << "attempting to grow by pages: " << pages_needed << "\n";
+
+        Local<Value> args[1] = {Integer::New(isolate, pages_needed)};
+        int32_t result = memory_value
+                             ->Get(context, context->GetEmbedderData(kString_grow))
+                             .ToLocalChecked()
+                             .As<Object>()
+                             ->CallAsFunction(context, memory_value, 1, args)
+                             .ToLocalChecked()
+                             ->Int32Value(context)
+                             .ToChecked();
+        wdebug(0) << "grow result: " << result << "\n";
+        internal_assert(result == (int)(bdmalloc->get_total_size() / kWasmPageSize));
+
+        Local<Object> buffer_string = context->GetEmbedderData(kString_buffer).As<Object>();
+        Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, buffer_string).ToLocalChecked());
+        wdebug(0) << "New ArrayBuffer size is: " << wasm_memory->ByteLength() << "\n";
+
+        bdmalloc->grow_total_size(wasm_memory->ByteLength());
+        p = bdmalloc->alloc_region(size);
+    }
+
+    wdebug(2) << "allocation of " << size << " at: " << p << "\n";
+    return p;
+}
+
+void v8_WasmMemoryObject_free(const Local<Context> &context, wasm32_ptr_t ptr) {
+    wdebug(2) << "freeing ptr at: " << ptr << "\n";
+    BDMalloc *bdmalloc = (BDMalloc *)context->GetAlignedPointerFromEmbedderData(kBDMallocPtr);
+    bdmalloc->free_region(ptr);
+}
+
+uint8_t *get_wasm_memory_base(const Local<Context> &context) {
+    Local<Object> memory_value = context->GetEmbedderData(kWasmMemoryObject).As<Object>();  // really a WasmMemoryObject
+    Local<ArrayBuffer> wasm_memory = Local<ArrayBuffer>::Cast(memory_value->Get(context, context->GetEmbedderData(kString_buffer)).ToLocalChecked());
+    uint8_t *p = (uint8_t *)wasm_memory->GetContents().Data();
+    return p;
+}
+
+WasmMemory v8_wasm_memory(const Local<Context> &context) {
+    return WasmMemory{
+        [context](size_t size) { return v8_WasmMemoryObject_malloc(context, size); },
+        [context]() { return get_wasm_memory_base(context); }};
+}
+
+// Some internal code can call halide_error(null, ...), so this needs to be resilient to that.
+// Callers must expect null and not crash.
+JITUserContext *get_jit_user_context(const Local<Context> &context, const Local<Value> &arg) {
+    int32_t ucon_magic = arg->Int32Value(context).ToChecked();
+    if (ucon_magic == 0) {
+        return nullptr;
+    }
+    internal_assert(ucon_magic == kMagicJitUserContextValue);
+    JITUserContext *jit_user_context = (JITUserContext *)context->GetAlignedPointerFromEmbedderData(kJitUserContext);
+    internal_assert(jit_user_context);
+    return jit_user_context;
+}
+
+void wasm_jit_halide_print_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    internal_assert(args.Length() == 2);
+
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
+    const int32_t str_address = args[1]->Int32Value(context).ToChecked();
+
+    jit_halide_print(jit_user_context, (const char *)get_wasm_memory_base(context) + str_address);
+}
+
+void wasm_jit_halide_error_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    internal_assert(args.Length() == 2);
+
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
+    const int32_t str_address = args[1]->Int32Value(context).ToChecked();
+
+    jit_halide_error(jit_user_context, (const char *)get_wasm_memory_base(context) + str_address);
+}
+
+void wasm_jit_halide_trace_helper_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    internal_assert(args.Length() == 12);
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    JITUserContext *jit_user_context = get_jit_user_context(context, args[0]);
+    int32_t trace_args[11];
+    for (int i = 0; i < 11; i++) {
+        trace_args[i] = args[i + 1]->Int32Value(context).ToChecked();
+    }
+
+    const int32_t result = jit_halide_trace_helper(jit_user_context, get_wasm_memory_base(context), trace_args);
+    args.GetReturnValue().Set(wrap_scalar(context, result));
+}
+
+void wasm_jit_malloc_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    Local<Context> context = isolate->GetCurrentContext();
+
+    size_t size = args[0]->Int32Value(context).ToChecked() + kExtraMallocSlop;
+    wasm32_ptr_t p = v8_WasmMemoryObject_malloc(context, size);
+    if (p) p += kExtraMallocSlop;
+    args.GetReturnValue().Set(wrap_scalar(context, p));
+}
+
+void wasm_jit_free_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    Local<Context> context = isolate->GetCurrentContext();
+    wasm32_ptr_t p = args[0]->Int32Value(context).ToChecked();
+    if (p) p -= kExtraMallocSlop;
+    v8_WasmMemoryObject_free(context, p);
+}
+
+void wasm_jit_abort_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    abort();
+}
+
+void wasm_jit_strlen_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    const int32_t s = args[0]->Int32Value(context).ToChecked();
+
+    uint8_t *base = get_wasm_memory_base(context);
+    int32_t r = strlen((char *)base + s);
+
+    args.GetReturnValue().Set(wrap_scalar(context, r));
+}
+
+void wasm_jit_write_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    internal_error << "WebAssembly JIT does not yet support the write() call.";
+}
+
+void wasm_jit_getenv_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    const int32_t s = args[0]->Int32Value(context).ToChecked();
+
+    args.GetReturnValue().Set(wrap_scalar(context, jit_getenv(v8_wasm_memory(context), s)));
 }
 
 void wasm_jit_memcpy_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
@@ -1066,14 +1242,6 @@ enum ExternWrapperFieldSlots {
     kArgTypesWrap
 };
 
-// Use a POD here so we can stuff it all into an ArrayBuffer to avoid having
-// to worry about lifetime management
-struct ExternArgType {
-    halide_type_t type;
-    bool is_void;
-    bool is_buffer;
-};
-
 void v8_extern_wrapper(const v8::FunctionCallbackInfo<v8::Value> &args) {
     Isolate *isolate = args.GetIsolate();
     HandleScope scope(isolate);
@@ -1083,66 +1251,477 @@ void v8_extern_wrapper(const v8::FunctionCallbackInfo<v8::Value> &args) {
     Local<External> trampoline_wrap = Local<External>::Cast(wrapper_data->GetInternalField(kTrampolineWrap));
     Local<ArrayBuffer> arg_types_wrap = Local<ArrayBuffer>::Cast(wrapper_data->GetInternalField(kArgTypesWrap));
 
-    using TrampolineFn = void (*)(void **);
     TrampolineFn trampoline = (TrampolineFn)trampoline_wrap->Value();
 
     size_t arg_types_len = (arg_types_wrap->ByteLength() / sizeof(ExternArgType)) - 1;
     const ExternArgType *arg_types = (const ExternArgType *)arg_types_wrap->GetContents().Data();
     const ExternArgType ret_type = *arg_types++;
 
-    // There's wasted space here, but that's ok.
-    std::vector<Halide::Runtime::Buffer<>> buffers(arg_types_len);
-    std::vector<uint64_t> scalars(arg_types_len);
-    std::vector<void *> trampoline_args(arg_types_len);
+    uint64_t ret_val = call_extern_trampoline(
+        trampoline, get_wasm_memory_base(context), ret_type, arg_types, arg_types_len,
+        [&](size_t i) -> wasm32_ptr_t { return args[i]->Int32Value(context).ToChecked(); },
+        [&](size_t i, void *slot) {
+            dynamic_type_dispatch<ExtractAndStoreScalar>(arg_types[i].type, context, args[i], slot);
+        });
 
-    for (size_t i = 0; i < arg_types_len; ++i) {
-        if (arg_types[i].is_buffer) {
-            const wasm32_ptr_t buf_ptr = args[i]->Int32Value(context).ToChecked();
-            wasmbuf_to_hostbuf(context, buf_ptr, buffers[i]);
-            trampoline_args[i] = buffers[i].raw_buffer();
+    if (!ret_type.is_void) {
+        dynamic_type_dispatch<LoadAndReturnScalar>(ret_type.type, context, (void *)&ret_val, args.GetReturnValue());
+    }
+}
+
+void add_extern_callbacks(const Local<Context> &context,
+                          const JITExternMap &jit_externs,
+                          const JITModule &trampolines,
+                          Local<Object> &imports_dict) {
+    Isolate *isolate = context->GetIsolate();
+    Local<ObjectTemplate> extern_callback_template = ObjectTemplate::New(isolate);
+    extern_callback_template->SetInternalFieldCount(4);
+    for (const auto &it : jit_externs) {
+        const auto &name = it.first;
+        if (should_skip_extern_symbol(name)) {
+            continue;
+        }
+
+        const auto &jit_extern = it.second;
+
+        const auto &trampoline_symbol = trampolines.exports().find(name + kTrampolineSuffix);
+        internal_assert(trampoline_symbol != trampolines.exports().end());
+
+        const auto &sig = jit_extern.extern_c_function().signature();
+        size_t arg_count = sig.arg_types().size();
+        Local<ArrayBuffer> arg_types_wrap = ArrayBuffer::New(isolate, sizeof(ExternArgType) * (arg_count + 1));
+        ExternArgType *arg_types = (ExternArgType *)arg_types_wrap->GetContents().Data();
+        if (sig.is_void_return()) {
+            // Type specified here will be ignored
+            *arg_types++ = ExternArgType{{halide_type_int, 0, 0}, true, false};
         } else {
-            dynamic_type_dispatch<ExtractAndStoreScalar>(arg_types[i].type, context, args[i], &scalars[i]);
-            trampoline_args[i] = &scalars[i];
+            const Type &t = sig.ret_type();
+            const bool is_buffer = (t == type_of<halide_buffer_t *>());
+            user_assert(t.lanes() == 1) << "Halide Extern functions cannot return vector values.";
+            user_assert(!is_buffer) << "Halide Extern functions cannot return halide_buffer_t.";
+            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
+            user_assert(!(t.is_handle() && !is_buffer)) << "Halide Extern functions cannot return arbitrary pointers as arguments.";
+            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
+            user_assert(!(t.is_int_or_uint() && t.bits() == 64)) << "Halide Extern functions cannot accept 64-bit values as arguments.";
+            *arg_types++ = ExternArgType{t, false, false};
+        }
+        for (size_t i = 0; i < arg_count; ++i) {
+            const Type &t = sig.arg_types()[i];
+            const bool is_buffer = (t == type_of<halide_buffer_t *>());
+            user_assert(t.lanes() == 1) << "Halide Extern functions cannot accept vector values as arguments.";
+            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
+            user_assert(!(t.is_handle() && !is_buffer)) << "Halide Extern functions cannot accept arbitrary pointers as arguments.";
+            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
+            user_assert(!(t.is_int_or_uint() && t.bits() == 64)) << "Halide Extern functions cannot accept 64-bit values as arguments.";
+            *arg_types++ = ExternArgType{t, false, is_buffer};
         }
+
+        Local<Object> wrapper_data = extern_callback_template->NewInstance(context).ToLocalChecked();
+        Local<External> trampoline_wrap(External::New(isolate, const_cast<void *>(trampoline_symbol->second.address)));
+        wrapper_data->SetInternalField(kTrampolineWrap, trampoline_wrap);
+        wrapper_data->SetInternalField(kArgTypesWrap, arg_types_wrap);
+
+        Local<v8::String> key = NewLocalString(isolate, name.c_str());
+        Local<v8::Function> value = FunctionTemplate::New(isolate, v8_extern_wrapper, wrapper_data)
+                                        ->GetFunction(context)
+                                        .ToLocalChecked();
+
+        (void)imports_dict->Set(context, key, value).ToChecked();
     }
+}
 
-    // The return value (if any) is always scalar.
-    uint64_t ret_val = 0;
-    const bool has_retval = !ret_type.is_void;
-    internal_assert(!ret_type.is_buffer);
-    if (has_retval) {
-        trampoline_args.push_back(&ret_val);
+}  // namespace
+}  // namespace Internal
+}  // namespace Halide
+
+#endif  // WITH_V8
+
+#ifdef WITH_WABT
+
+namespace Halide {
+namespace Internal {
+namespace {
+
+// The wabt backend runs the linked wasm in wabt's interpreter rather than
+// in a JIT engine. It is much slower than V8, but it needs nothing beyond
+// libwabt and it implements the SIMD proposal, so it's adequate for
+// correctness testing (and for tracking relative performance) on hosts
+// where V8 isn't available.
+
+// Per-module state needed by the host callbacks.
+struct WabtContext {
+    BDMalloc &bdmalloc;
+    wabt::interp::Memory::Ptr memory;
+    JITUserContext *jit_user_context = nullptr;
+
+    explicit WabtContext(BDMalloc &bdmalloc)
+        : bdmalloc(bdmalloc) {
     }
-    (*trampoline)(trampoline_args.data());
+};
+
+using WabtCallback = std::function<wabt::Result(WabtContext &wabt_context,
+                                                const wabt::interp::Values &args,
+                                                wabt::interp::Values &results)>;
+using WabtCallbackMap = std::map<std::string, WabtCallback>;
+
+// Note that the base can move whenever the memory grows, so it must be
+// re-fetched after any call to wabt_malloc().
+uint8_t *get_wasm_memory_base(WabtContext &wabt_context) {
+    return wabt_context.memory->UnsafeData();
+}
+
+wasm32_ptr_t wabt_malloc(WabtContext &wabt_context, size_t size) {
+    BDMalloc &bdmalloc = wabt_context.bdmalloc;
+
+    wasm32_ptr_t p = bdmalloc.alloc_region(size);
+    if (!p) {
+        constexpr int kWasmPageSize = 65536;
+        const int32_t pages_needed = (size + kWasmPageSize - 1) / kWasmPageSize;
+        wdebug(0) << "attempting to grow by pages: " << pages_needed << "\n";
+
+        wabt::Result r = wabt_context.memory->Grow(pages_needed);
+        internal_assert(Succeeded(r)) << "Unable to grow wasm memory by " << pages_needed << " pages\n";
+
+        wdebug(0) << "New memory size is: " << wabt_context.memory->ByteSize() << "\n";
+        bdmalloc.grow_total_size((uint32_t)wabt_context.memory->ByteSize());
+        p = bdmalloc.alloc_region(size);
+    }
+
+    wdebug(2) << "allocation of " << size << " at: " << p << "\n";
+    return p;
+}
+
+void wabt_free(WabtContext &wabt_context, wasm32_ptr_t ptr) {
+    wdebug(2) << "freeing ptr at: " << ptr << "\n";
+    wabt_context.bdmalloc.free_region(ptr);
+}
+
+WasmMemory wabt_wasm_memory(WabtContext &wabt_context) {
+    return WasmMemory{
+        [&wabt_context](size_t size) { return wabt_malloc(wabt_context, size); },
+        [&wabt_context]() { return get_wasm_memory_base(wabt_context); }};
+}
+
+// Some internal code can call halide_error(null, ...), so this needs to be resilient to that.
+// Callers must expect null and not crash.
+JITUserContext *get_jit_user_context(WabtContext &wabt_context, const wabt::interp::Value &arg) {
+    const int32_t ucon_magic = arg.Get<int32_t>();
+    if (ucon_magic == 0) {
+        return nullptr;
+    }
+    internal_assert(ucon_magic == kMagicJitUserContextValue);
+    JITUserContext *jit_user_context = wabt_context.jit_user_context;
+    internal_assert(jit_user_context);
+    return jit_user_context;
+}
+
+// ------------------------------
+
+// Wasm has only i32, i64, f32 and f64 scalars: everything narrower than
+// 32 bits travels as an i32, and (b)float16 values travel as f32.
+template<typename T>
+struct WabtLoadScalar {
+    wabt::interp::Value operator()(const void *src) {
+        return wabt::interp::Value::Make((int32_t) * (const T *)src);
+    }
+};
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<float>::operator()(const void *src) {
+    return wabt::interp::Value::Make(*(const float *)src);
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<double>::operator()(const void *src) {
+    return wabt::interp::Value::Make(*(const double *)src);
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<int64_t>::operator()(const void *src) {
+    return wabt::interp::Value::Make(*(const int64_t *)src);
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<uint64_t>::operator()(const void *src) {
+    return wabt::interp::Value::Make(*(const uint64_t *)src);
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<float16_t>::operator()(const void *src) {
+    return wabt::interp::Value::Make((float)float16_t::make_from_bits(*(const uint16_t *)src));
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<bfloat16_t>::operator()(const void *src) {
+    return wabt::interp::Value::Make((float)bfloat16_t::make_from_bits(*(const uint16_t *)src));
+}
+
+template<>
+inline wabt::interp::Value WabtLoadScalar<void *>::operator()(const void *src) {
+    internal_error << "Host pointers cannot be passed to the WebAssembly JIT.";
+    return wabt::interp::Value();
+}
+
+// ------------------------------
+
+template<typename T>
+struct WabtStoreScalar {
+    void operator()(const wabt::interp::Value &val, void *dst) {
+        *(T *)dst = (T)val.Get<int32_t>();
+    }
+};
+
+template<>
+inline void WabtStoreScalar<float>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(float *)dst = val.Get<float>();
+}
+
+template<>
+inline void WabtStoreScalar<double>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(double *)dst = val.Get<double>();
+}
+
+template<>
+inline void WabtStoreScalar<int64_t>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(int64_t *)dst = val.Get<int64_t>();
+}
+
+template<>
+inline void WabtStoreScalar<uint64_t>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(uint64_t *)dst = val.Get<uint64_t>();
+}
+
+template<>
+inline void WabtStoreScalar<float16_t>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(uint16_t *)dst = float16_t((double)val.Get<float>()).to_bits();
+}
+
+template<>
+inline void WabtStoreScalar<bfloat16_t>::operator()(const wabt::interp::Value &val, void *dst) {
+    *(uint16_t *)dst = bfloat16_t((double)val.Get<float>()).to_bits();
+}
+
+template<>
+inline void WabtStoreScalar<void *>::operator()(const wabt::interp::Value &val, void *dst) {
+    internal_error << "Host pointers cannot be passed from the WebAssembly JIT.";
+}
+
+// ------------------------------
+
+#define WABT_HOST_CALLBACK(x)                                         \
+    wabt::Result wabt_jit_##x##_callback(WabtContext &wabt_context,   \
+                                         const wabt::interp::Values &args, \
+                                         wabt::interp::Values &results)
+
+WABT_HOST_CALLBACK(halide_print) {
+    internal_assert(args.size() == 2);
+
+    JITUserContext *jit_user_context = get_jit_user_context(wabt_context, args[0]);
+    const int32_t str_address = args[1].Get<int32_t>();
+
+    jit_halide_print(jit_user_context, (const char *)get_wasm_memory_base(wabt_context) + str_address);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(halide_error) {
+    internal_assert(args.size() == 2);
+
+    JITUserContext *jit_user_context = get_jit_user_context(wabt_context, args[0]);
+    const int32_t str_address = args[1].Get<int32_t>();
+
+    jit_halide_error(jit_user_context, (const char *)get_wasm_memory_base(wabt_context) + str_address);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(halide_trace_helper) {
+    internal_assert(args.size() == 12);
+
+    JITUserContext *jit_user_context = get_jit_user_context(wabt_context, args[0]);
+    int32_t trace_args[11];
+    for (int i = 0; i < 11; i++) {
+        trace_args[i] = args[i + 1].Get<int32_t>();
+    }
+
+    const int32_t result = jit_halide_trace_helper(jit_user_context, get_wasm_memory_base(wabt_context), trace_args);
+    results[0] = wabt::interp::Value::Make(result);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(malloc) {
+    size_t size = args[0].Get<int32_t>() + kExtraMallocSlop;
+    wasm32_ptr_t p = wabt_malloc(wabt_context, size);
+    if (p) p += kExtraMallocSlop;
+    results[0] = wabt::interp::Value::Make(p);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(free) {
+    wasm32_ptr_t p = args[0].Get<int32_t>();
+    if (p) p -= kExtraMallocSlop;
+    wabt_free(wabt_context, p);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(abort) {
+    abort();
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(strlen) {
+    const int32_t s = args[0].Get<int32_t>();
+
+    uint8_t *base = get_wasm_memory_base(wabt_context);
+    int32_t r = strlen((char *)base + s);
+
+    results[0] = wabt::interp::Value::Make(r);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(write) {
+    internal_error << "WebAssembly JIT does not yet support the write() call.";
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(getenv) {
+    const int32_t s = args[0].Get<int32_t>();
+
+    results[0] = wabt::interp::Value::Make(jit_getenv(wabt_wasm_memory(wabt_context), s));
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(memcpy) {
+    const int32_t dst = args[0].Get<int32_t>();
+    const int32_t src = args[1].Get<int32_t>();
+    const int32_t n = args[2].Get<int32_t>();
+
+    uint8_t *base = get_wasm_memory_base(wabt_context);
+
+    memcpy(base + dst, base + src, n);
+
+    results[0] = wabt::interp::Value::Make(dst);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(fopen) {
+    internal_error << "WebAssembly JIT does not yet support the fopen() call.";
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(fileno) {
+    internal_error << "WebAssembly JIT does not yet support the fileno() call.";
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(fclose) {
+    internal_error << "WebAssembly JIT does not yet support the fclose() call.";
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(fwrite) {
+    internal_error << "WebAssembly JIT does not yet support the fwrite() call.";
+    return wabt::Result::Error;
+}
+
+WABT_HOST_CALLBACK(memset) {
+    const int32_t s = args[0].Get<int32_t>();
+    const int32_t c = args[1].Get<int32_t>();
+    const int32_t n = args[2].Get<int32_t>();
+
+    uint8_t *base = get_wasm_memory_base(wabt_context);
+    memset(base + s, c, n);
+
+    results[0] = wabt::interp::Value::Make(s);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(memcmp) {
+    const int32_t s1 = args[0].Get<int32_t>();
+    const int32_t s2 = args[1].Get<int32_t>();
+    const int32_t n = args[2].Get<int32_t>();
+
+    uint8_t *base = get_wasm_memory_base(wabt_context);
+
+    const int32_t r = memcmp(base + s1, base + s2, n);
+
+    results[0] = wabt::interp::Value::Make(r);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(__cxa_atexit) {
+    // nothing
+    results[0] = wabt::interp::Value::Make((int32_t)0);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(__extendhfsf2) {
+    const uint16_t in = (uint16_t)args[0].Get<int32_t>();
+    const float out = (float)float16_t::make_from_bits(in);
+
+    results[0] = wabt::interp::Value::Make(out);
+    return wabt::Result::Ok;
+}
+
+WABT_HOST_CALLBACK(__truncsfhf2) {
+    const float in = args[0].Get<float>();
+    const uint16_t out = float16_t(in).to_bits();
+
+    results[0] = wabt::interp::Value::Make((int32_t)out);
+    return wabt::Result::Ok;
+}
 
-    if (has_retval) {
-        dynamic_type_dispatch<LoadAndReturnScalar>(ret_type.type, context, (void *)&ret_val, args.GetReturnValue());
-    }
+#undef WABT_HOST_CALLBACK
 
-    // Progagate buffer data backwards. Note that for arbitrary extern functions,
-    // we have no idea which buffers might be "input only", so we copy all data for all of them.
-    for (size_t i = 0; i < arg_types_len; ++i) {
-        if (arg_types[i].is_buffer) {
-            const wasm32_ptr_t buf_ptr = args[i]->Int32Value(context).ToChecked();
-            copy_hostbuf_to_existing_wasmbuf(context, buffers[i], buf_ptr);
-        }
-    }
+template<typename T, T some_func(T)>
+wabt::Result wabt_jit_posix_math_callback(WabtContext &wabt_context,
+                                          const wabt::interp::Values &args,
+                                          wabt::interp::Values &results) {
+    const T in = args[0].Get<T>();
+    const T out = some_func(in);
+
+    results[0] = wabt::interp::Value::Make(out);
+    return wabt::Result::Ok;
 }
 
-bool should_skip_extern_symbol(const std::string &name) {
-    static std::set<std::string> symbols = {
-        "halide_print",
-        "halide_error"};
-    return symbols.count(name) > 0;
+template<typename T, T some_func(T, T)>
+wabt::Result wabt_jit_posix_math2_callback(WabtContext &wabt_context,
+                                           const wabt::interp::Values &args,
+                                           wabt::interp::Values &results) {
+    const T in1 = args[0].Get<T>();
+    const T in2 = args[1].Get<T>();
+    const T out = some_func(in1, in2);
+
+    results[0] = wabt::interp::Value::Make(out);
+    return wabt::Result::Ok;
 }
 
-void add_extern_callbacks(const Local<Context> &context,
-                          const JITExternMap &jit_externs,
+// ------------------------------
+
+// arg_types[0] describes the return value; the rest describe the arguments.
+wabt::Result wabt_extern_wrapper(WabtContext &wabt_context,
+                                 TrampolineFn trampoline,
+                                 const std::vector<ExternArgType> &arg_types,
+                                 const wabt::interp::Values &args,
+                                 wabt::interp::Values &results) {
+    const ExternArgType &ret_type = arg_types[0];
+    const size_t arg_types_len = arg_types.size() - 1;
+    internal_assert(args.size() == arg_types_len);
+
+    uint64_t ret_val = call_extern_trampoline(
+        trampoline, get_wasm_memory_base(wabt_context), ret_type, &arg_types[1], arg_types_len,
+        [&](size_t i) -> wasm32_ptr_t { return args[i].Get<int32_t>(); },
+        [&](size_t i, void *slot) {
+            dynamic_type_dispatch<WabtStoreScalar>(arg_types[i + 1].type, args[i], slot);
+        });
+
+    if (!ret_type.is_void) {
+        results[0] = dynamic_type_dispatch<WabtLoadScalar>(ret_type.type, (const void *)&ret_val);
+    }
+    return wabt::Result::Ok;
+}
+
+void add_extern_callbacks(const JITExternMap &jit_externs,
                           const JITModule &trampolines,
-                          Local<Object> &imports_dict) {
-    Isolate *isolate = context->GetIsolate();
-    Local<ObjectTemplate> extern_callback_template = ObjectTemplate::New(isolate);
-    extern_callback_template->SetInternalFieldCount(4);
+                          WabtCallbackMap &callbacks) {
     for (const auto &it : jit_externs) {
         const auto &name = it.first;
         if (should_skip_extern_symbol(name)) {
@@ -1153,123 +1732,43 @@ void add_extern_callbacks(const Local<Context> &context,
 
         const auto &trampoline_symbol = trampolines.exports().find(name + kTrampolineSuffix);
         internal_assert(trampoline_symbol != trampolines.exports().end());
+        TrampolineFn trampoline = (TrampolineFn)const_cast<void *>(trampoline_symbol->second.address);
 
+        // Unlike V8, the interpreter hands us i64 values directly, so 64-bit
+        // scalars need no special treatment here.
         const auto &sig = jit_extern.extern_c_function().signature();
-        size_t arg_count = sig.arg_types().size();
-        Local<ArrayBuffer> arg_types_wrap = ArrayBuffer::New(isolate, sizeof(ExternArgType) * (arg_count + 1));
-        ExternArgType *arg_types = (ExternArgType *)arg_types_wrap->GetContents().Data();
+        std::vector<ExternArgType> arg_types;
         if (sig.is_void_return()) {
             // Type specified here will be ignored
-            *arg_types++ = ExternArgType{{halide_type_int, 0, 0}, true, false};
+            arg_types.push_back(ExternArgType{{halide_type_int, 0, 0}, true, false});
         } else {
             const Type &t = sig.ret_type();
             const bool is_buffer = (t == type_of<halide_buffer_t *>());
             user_assert(t.lanes() == 1) << "Halide Extern functions cannot return vector values.";
             user_assert(!is_buffer) << "Halide Extern functions cannot return halide_buffer_t.";
-            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
-            user_assert(!(t.is_handle() && !is_buffer)) << "Halide Extern functions cannot return arbitrary pointers as arguments.";
-            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
-            user_assert(!(t.is_int_or_uint() && t.bits() == 64)) << "Halide Extern functions cannot accept 64-bit values as arguments.";
-            *arg_types++ = ExternArgType{t, false, false};
+            user_assert(!t.is_handle()) << "Halide Extern functions cannot return arbitrary pointers as arguments.";
+            arg_types.push_back(ExternArgType{t, false, false});
         }
-        for (size_t i = 0; i < arg_count; ++i) {
-            const Type &t = sig.arg_types()[i];
+        for (const Type &t : sig.arg_types()) {
             const bool is_buffer = (t == type_of<halide_buffer_t *>());
             user_assert(t.lanes() == 1) << "Halide Extern functions cannot accept vector values as arguments.";
-            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
             user_assert(!(t.is_handle() && !is_buffer)) << "Halide Extern functions cannot accept arbitrary pointers as arguments.";
-            // TODO: the assertion below can be removed once we are able to marshal int64 values across the barrier
-            user_assert(!(t.is_int_or_uint() && t.bits() == 64)) << "Halide Extern functions cannot accept 64-bit values as arguments.";
-            *arg_types++ = ExternArgType{t, false, is_buffer};
+            arg_types.push_back(ExternArgType{t, false, is_buffer});
         }
 
-        Local<Object> wrapper_data = extern_callback_template->NewInstance(context).ToLocalChecked();
-        Local<External> trampoline_wrap(External::New(isolate, const_cast<void *>(trampoline_symbol->second.address)));
-        wrapper_data->SetInternalField(kTrampolineWrap, trampoline_wrap);
-        wrapper_data->SetInternalField(kArgTypesWrap, arg_types_wrap);
-
-        Local<v8::String> key = NewLocalString(isolate, name.c_str());
-        Local<v8::Function> value = FunctionTemplate::New(isolate, v8_extern_wrapper, wrapper_data)
-                                        ->GetFunction(context)
-                                        .ToLocalChecked();
-
-        (void)imports_dict->Set(context, key, value).ToChecked();
-    }
-}
-
-std::vector<char> compile_to_wasm(const Module &module, const std::string &fn_name) {
-    static std::mutex link_lock;
-    std::lock_guard<std::mutex> lock(link_lock);
-
-    llvm::LLVMContext context;
-    std::unique_ptr<llvm::Module> fn_module(compile_module_to_llvm_module(module, context));
-
-    std::unique_ptr<llvm::Module> llvm_module =
-        link_with_wasm_jit_runtime(&context, module.target(), std::move(fn_module));
-
-    llvm::SmallVector<char, 4096> object;
-    llvm::raw_svector_ostream object_stream(object);
-    compile_llvm_module_to_object(*llvm_module, object_stream);
-
-    // TODO: surely there's a better way that doesn't require spooling things
-    // out to temp files
-    TemporaryFile obj_file("", ".o");
-    write_entire_file(obj_file.pathname(), object.data(), object.size());
-#if WASM_DEBUG_LEVEL
-    obj_file.detach();
-    wdebug(0) << "Dumping obj_file to " << obj_file.pathname() << "\n";
-#endif
-
-    TemporaryFile wasm_output("", ".wasm");
-
-    std::string lld_arg_strs[] = {
-        "HalideJITLinker",
-        // For debugging purposes:
-        // "--verbose",
-        // "-error-limit=0",
-        // "--print-gc-sections",
-        "--export=__data_end",
-        "--export=__heap_base",
-        "--allow-undefined",
-        obj_file.pathname(),
-        "--entry=" + fn_name,
-        "-o",
-        wasm_output.pathname()};
-
-    constexpr int c = sizeof(lld_arg_strs) / sizeof(lld_arg_strs[0]);
-    const char *lld_args[c];
-    for (int i = 0; i < c; ++i)
-        lld_args[i] = lld_arg_strs[i].c_str();
-
-#if LLVM_VERSION >= 100
-    std::string lld_errs_string;
-    llvm::raw_string_ostream lld_errs(lld_errs_string);
-
-    if (!lld::wasm::link(lld_args, /*CanExitEarly*/ false, llvm::outs(), lld_errs)) {
-        internal_error << "lld::wasm::link failed: (" << lld_errs.str() << ")\n";
-    }
-#else
-    std::string lld_errs_string;
-    llvm::raw_string_ostream lld_errs(lld_errs_string);
-
-    if (!lld::wasm::link(lld_args, /*CanExitEarly*/ false, lld_errs)) {
-        internal_error << "lld::wasm::link failed: (" << lld_errs.str() << ")\n";
+        callbacks[name] = [trampoline, arg_types](WabtContext &wabt_context,
+                                                  const wabt::interp::Values &args,
+                                                  wabt::interp::Values &results) {
+            return wabt_extern_wrapper(wabt_context, trampoline, arg_types, args, results);
+        };
     }
-#endif
-
-#if WASM_DEBUG_LEVEL
-    wasm_output.detach();
-    wdebug(0) << "Dumping linked wasm to " << wasm_output.pathname() << "\n";
-#endif
-
-    return read_entire_file(wasm_output.pathname());
 }
 
 }  // namespace
 }  // namespace Internal
 }  // namespace Halide
 
-#endif  // WITH_V8
+#endif  // WITH_WABT
 
 namespace Halide {
 namespace Internal {
@@ -1291,6 +1790,16 @@ struct WasmModuleContents {
     v8::Persistent<v8::Function> v8_function;
 #endif
 
+#ifdef WITH_WABT
+    // The Store must outlive every Ptr below, so it is declared first.
+    std::unique_ptr<wabt::interp::Store> wabt_store;
+    std::unique_ptr<WabtContext> wabt_context;
+    wabt::interp::Instance::Ptr wabt_instance;
+    wabt::interp::Func::Ptr wabt_function;
+    // The interpreter isn't thread-safe, so calls into a module are serialized.
+    std::mutex wabt_run_mutex;
+#endif
+
     WasmModuleContents(
         const Module &module,
         const std::vector<Argument> &arguments,
@@ -1511,6 +2020,167 @@ WasmModuleContents::WasmModuleContents(
 
     internal_assert(!try_catch.HasCaught());
 #endif
+
+#ifdef WITH_WABT
+    wabt::Features features;
+    // TODO: these need to match the flags we set in CodeGen_WebAssembly::mattrs().
+    // As with V8, we enable all features that *might* be used.
+    features.enable_sat_float_to_int();  // +nontrapping-fptoint
+    features.enable_sign_extension();    // +sign-ext
+    features.enable_simd();              // +simd128
+
+    std::vector<char> final_wasm = compile_to_wasm(module, fn_name);
+
+    wabt::Errors errors;
+    wabt::interp::ModuleDesc module_desc;
+    const bool kReadDebugNames = false;
+    const bool kStopOnFirstError = true;
+    const bool kFailOnCustomSectionError = true;
+    wabt::ReadBinaryOptions options(features, /* log_stream */ nullptr,
+                                    kReadDebugNames, kStopOnFirstError, kFailOnCustomSectionError);
+    wabt::Result r = wabt::interp::ReadBinaryInterp(final_wasm.data(), final_wasm.size(),
+                                                    options, &errors, &module_desc);
+    internal_assert(Succeeded(r))
+        << "Error reading wasm: " << wabt::FormatErrorsToString(errors, wabt::Location::Type::Binary) << "\n";
+
+    wabt_store.reset(new wabt::interp::Store(features));
+    wabt_context.reset(new WabtContext(bdmalloc));
+
+    WabtCallbackMap callbacks;
+
+    const auto add_callback = [&](const char *name, const WabtCallback &f) {
+        // Skip any leading :: nonsense that we needed to add
+        // to disambiguate (say) ::sin() from Halide::sin()
+        while (*name == ':')
+            name++;
+        callbacks[name] = f;
+    };
+
+#define ADD_CALLBACK(x) add_callback(#x, wabt_jit_##x##_callback);
+
+    // Halide Runtime glue
+    ADD_CALLBACK(halide_error);
+    ADD_CALLBACK(halide_print);
+    ADD_CALLBACK(halide_trace_helper);
+
+    // libc-ish glue
+    ADD_CALLBACK(__cxa_atexit)
+    ADD_CALLBACK(abort)
+    ADD_CALLBACK(fclose)
+    ADD_CALLBACK(fileno)
+    ADD_CALLBACK(fopen)
+    ADD_CALLBACK(free)
+    ADD_CALLBACK(fwrite)
+    ADD_CALLBACK(getenv)
+    ADD_CALLBACK(malloc)
+    ADD_CALLBACK(memcmp)
+    ADD_CALLBACK(memcpy)
+    ADD_CALLBACK(memset)
+    ADD_CALLBACK(strlen)
+    ADD_CALLBACK(write)
+    ADD_CALLBACK(__extendhfsf2)
+    ADD_CALLBACK(__truncsfhf2)
+
+#undef ADD_CALLBACK
+
+#define ADD_POSIX_MATH(t, f) add_callback(#f, wabt_jit_posix_math_callback<t, f>);
+#define ADD_POSIX_MATH2(t, f) add_callback(#f, wabt_jit_posix_math2_callback<t, f>);
+
+    // math glue
+    ADD_POSIX_MATH(double, ::acos)
+    ADD_POSIX_MATH(double, ::acosh)
+    ADD_POSIX_MATH(double, ::asin)
+    ADD_POSIX_MATH(double, ::asinh)
+    ADD_POSIX_MATH(double, ::atan)
+    ADD_POSIX_MATH(double, ::atanh)
+    ADD_POSIX_MATH(double, ::cos)
+    ADD_POSIX_MATH(double, ::cosh)
+    ADD_POSIX_MATH(double, ::exp)
+    ADD_POSIX_MATH(double, ::log)
+    ADD_POSIX_MATH(double, ::round)
+    ADD_POSIX_MATH(double, ::sin)
+    ADD_POSIX_MATH(double, ::sinh)
+    ADD_POSIX_MATH(double, ::tan)
+    ADD_POSIX_MATH(double, ::tanh)
+
+    ADD_POSIX_MATH(float, ::acosf)
+    ADD_POSIX_MATH(float, ::acoshf)
+    ADD_POSIX_MATH(float, ::asinf)
+    ADD_POSIX_MATH(float, ::asinhf)
+    ADD_POSIX_MATH(float, ::atanf)
+    ADD_POSIX_MATH(float, ::atanhf)
+    ADD_POSIX_MATH(float, ::cosf)
+    ADD_POSIX_MATH(float, ::coshf)
+    ADD_POSIX_MATH(float, ::expf)
+    ADD_POSIX_MATH(float, ::logf)
+    ADD_POSIX_MATH(float, ::roundf)
+    ADD_POSIX_MATH(float, ::sinf)
+    ADD_POSIX_MATH(float, ::sinhf)
+    ADD_POSIX_MATH(float, ::tanf)
+    ADD_POSIX_MATH(float, ::tanhf)
+
+    ADD_POSIX_MATH2(float, ::atan2f)
+    ADD_POSIX_MATH2(double, ::atan2)
+    ADD_POSIX_MATH2(float, ::powf)
+    ADD_POSIX_MATH2(double, ::pow)
+
+#undef ADD_POSIX_MATH
+#undef ADD_POSIX_MATH2
+
+    add_extern_callbacks(jit_externs, trampolines, callbacks);
+
+    wabt::interp::Module::Ptr wabt_module = wabt::interp::Module::New(*wabt_store, module_desc);
+
+    // Bind every import to its host callback; the WabtContext is owned by
+    // this object, so it outlives the HostFuncs that refer to it.
+    WabtContext *ctx = wabt_context.get();
+    wabt::interp::RefVec imports;
+    for (const auto &import : wabt_module->desc().imports) {
+        const std::string &name = import.type.name;
+        internal_assert(import.type.module == "env" &&
+                        import.type.type->kind == wabt::interp::ExternKind::Func)
+            << "Unexpected wasm import: " << import.type.module << "." << name << "\n";
+        const auto it = callbacks.find(name);
+        user_assert(it != callbacks.end())
+            << "The WebAssembly JIT has no implementation of " << name << "()\n";
+        const WabtCallback &callback = it->second;
+        const wabt::interp::FuncType &func_type = *wabt::cast<wabt::interp::FuncType>(import.type.type.get());
+        auto host_func = wabt::interp::HostFunc::New(
+            *wabt_store, func_type,
+            [ctx, callback](wabt::interp::Thread &thread,
+                            const wabt::interp::Values &args,
+                            wabt::interp::Values &results,
+                            wabt::interp::Trap::Ptr *trap) -> wabt::Result {
+                return callback(*ctx, args, results);
+            });
+        imports.push_back(host_func.ref());
+    }
+
+    wabt::interp::Trap::Ptr trap;
+    wabt_instance = wabt::interp::Instance::Instantiate(*wabt_store, wabt_module.ref(), imports, &trap);
+    internal_assert(wabt_instance) << "Error instantiating wasm: " << (trap ? trap->message() : "<unknown>") << "\n";
+
+    int32_t heap_base = -1;
+    const auto &exports = wabt_module->desc().exports;
+    for (size_t i = 0; i < exports.size(); i++) {
+        const std::string &name = exports[i].type.name;
+        const wabt::interp::Ref ref = wabt_instance->exports()[i];
+        if (name == fn_name) {
+            wabt_function = wabt_store->UnsafeGet<wabt::interp::Func>(ref);
+        } else if (name == "memory") {
+            wabt_context->memory = wabt_store->UnsafeGet<wabt::interp::Memory>(ref);
+        } else if (name == "__heap_base") {
+            heap_base = wabt_store->UnsafeGet<wabt::interp::Global>(ref)->Get().Get<int32_t>();
+        }
+    }
+    internal_assert(wabt_function) << "Wasm module does not export " << fn_name << "\n";
+    internal_assert(wabt_context->memory) << "Wasm module does not export its memory\n";
+    internal_assert(heap_base >= 0) << "Wasm module does not export __heap_base\n";
+
+    wdebug(0) << "heap_base is: " << heap_base << "\n";
+    wdebug(0) << "initial memory size is: " << wabt_context->memory->ByteSize() << "\n";
+    bdmalloc.init((uint32_t)wabt_context->memory->ByteSize(), heap_base);
+#endif
 }
 
 int WasmModuleContents::run(const void **args) {
@@ -1538,7 +2208,7 @@ int WasmModuleContents::run(const void **args) {
         if (arg.is_buffer()) {
             halide_buffer_t *buf = (halide_buffer_t *)const_cast<void *>(arg_ptr);
             internal_assert(buf);
-            wasm32_ptr_t wbuf = hostbuf_to_wasmbuf(context, buf);
+            wasm32_ptr_t wbuf = hostbuf_to_wasmbuf(v8_wasm_memory(context), buf);
             wbufs[i] = wbuf;
             js_args.push_back(wrap_scalar(context, wbuf));
         } else {
@@ -1570,7 +2240,7 @@ int WasmModuleContents::run(const void **args) {
             const void *arg_ptr = args[i];
             if (arg.is_buffer()) {
                 halide_buffer_t *buf = (halide_buffer_t *)const_cast<void *>(arg_ptr);
-                copy_wasmbuf_to_existing_hostbuf(context, wbufs[i], buf);
+                copy_wasmbuf_to_existing_hostbuf(get_wasm_memory_base(context), wbufs[i], buf);
             }
         }
     }
@@ -1586,6 +2256,62 @@ int WasmModuleContents::run(const void **args) {
     return r;
 #endif
 
+#ifdef WITH_WABT
+    std::lock_guard<std::mutex> lock(wabt_run_mutex);
+
+    WabtContext &ctx = *wabt_context;
+    ctx.jit_user_context = nullptr;
+
+    std::vector<wasm32_ptr_t> wbufs(arguments.size(), 0);
+
+    wabt::interp::Values wabt_args;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const Argument &arg = arguments[i];
+        const void *arg_ptr = args[i];
+        if (arg.is_buffer()) {
+            halide_buffer_t *buf = (halide_buffer_t *)const_cast<void *>(arg_ptr);
+            internal_assert(buf);
+            wasm32_ptr_t wbuf = hostbuf_to_wasmbuf(wabt_wasm_memory(ctx), buf);
+            wbufs[i] = wbuf;
+            wabt_args.push_back(wabt::interp::Value::Make(wbuf));
+        } else if (arg.name == "__user_context") {
+            wabt_args.push_back(wabt::interp::Value::Make(kMagicJitUserContextValue));
+            ctx.jit_user_context = check_jit_user_context(*(JITUserContext **)const_cast<void *>(arg_ptr));
+        } else {
+            wabt_args.push_back(dynamic_type_dispatch<WabtLoadScalar>(arg.type, arg_ptr));
+        }
+    }
+
+    wabt::interp::Values wabt_results;
+    wabt::interp::Trap::Ptr trap;
+    wabt::Result call_result = wabt_function->Call(*wabt_store, wabt_args, wabt_results, &trap);
+    if (Failed(call_result)) {
+        internal_error << "Error running wasm: " << (trap ? trap->message() : "<unknown>") << "\n";
+    }
+    internal_assert(wabt_results.size() == 1);
+
+    int r = wabt_results[0].Get<int32_t>();
+    if (r == 0) {
+        // Update any output buffers
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const Argument &arg = arguments[i];
+            const void *arg_ptr = args[i];
+            if (arg.is_buffer()) {
+                halide_buffer_t *buf = (halide_buffer_t *)const_cast<void *>(arg_ptr);
+                copy_wasmbuf_to_existing_hostbuf(get_wasm_memory_base(ctx), wbufs[i], buf);
+            }
+        }
+    }
+
+    for (wasm32_ptr_t p : wbufs) {
+        wabt_free(ctx, p);
+    }
+
+    ctx.jit_user_context = nullptr;
+
+    return r;
+#endif
+
     internal_error;
     return -1;
 }
@@ -1620,7 +2346,7 @@ void destroy<WasmModuleContents>(const WasmModuleContents *p) {
 
 /*static*/
 bool WasmModule::can_jit_target(const Target &target) {
-#if defined(WITH_V8) || defined(WITH_SPIDERMONKEY)
+#if defined(WITH_V8) || defined(WITH_SPIDERMONKEY) || defined(WITH_WABT)
     if (target.arch == Target::WebAssembly) {
         return true;
     }
@@ -1628,6 +2354,15 @@ bool WasmModule::can_jit_target(const Target &target) {
     return false;
 }
 
+/*static*/
+bool WasmModule::can_pass_64_bit_extern_scalars() {
+#if defined(WITH_WABT)
+    return true;
+#else
+    return false;
+#endif
+}
+
 /*static*/
 WasmModule WasmModule::compile(
     const Module &module,
@@ -1635,8 +2370,8 @@ WasmModule WasmModule::compile(
     const std::string &fn_name,
     const JITExternMap &jit_externs,
     const std::vector<JITModule> &extern_deps) {
-#if !defined(WITH_V8) && !defined(WITH_SPIDERMONKEY)
-    user_error << "Cannot run JITted JavaScript without configuring a JavaScript engine.";
+#if !defined(WITH_V8) && !defined(WITH_SPIDERMONKEY) && !defined(WITH_WABT)
+    user_error << "Cannot run JITted WebAssembly without configuring a WebAssembly engine (WITH_V8 or WITH_WABT).";
     return WasmModule();
 #endif
 
@@ -7,7 +7,8 @@
  * Bindings for parameters, extern calls, etc. are established and the
  * Wasm code is executed. Allows calls to realize to work
  * exactly as if native code had been run, but via a JavaScript/Wasm VM.
- * Currently, V8 is supported, with SpiderMonkey intended to be included soon as well.
+ * Currently, V8 (WITH_V8) and the wabt interpreter (WITH_WABT) are supported,
+ * with SpiderMonkey intended to be included soon as well.
  */
 
 #include "Argument.h"
@@ -28,6 +29,10 @@ struct WasmModule {
     /** If the given target can be executed via the wasm executor, return true. */
     static bool can_jit_target(const Target &target);
 
+    /** If extern calls made from wasm code can pass and return 64-bit
+     * integer scalars, return true. (This is the case for wabt, but not V8.) */
+    static bool can_pass_64_bit_extern_scalars();
+
     /** Compile generated wasm code with a set of externs. */
     static WasmModule compile(
         const Module &module,
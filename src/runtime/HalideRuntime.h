@@ -1322,7 +1322,7 @@ typedef enum halide_target_feature_t {
     halide_target_feature_hvx_v65,                 ///< Enable Hexagon v65 architecture.
     halide_target_feature_hvx_v66,                 ///< Enable Hexagon v66 architecture.
     halide_target_feature_cl_half,                 ///< Enable half support on OpenCL targets
-    halide_target_feature_strict_float,            ///< Turn off all non-IEEE floating-point optimization. Currently applies only to LLVM targets.
+    halide_target_feature_strict_float,            ///< Turn off all non-IEEE floating-point optimization, and call libm rather than Halide's less accurate vectorizable transcendentals. Currently applies only to LLVM targets.
     halide_target_feature_legacy_buffer_wrappers,  ///< Emit legacy wrapper code for buffer_t (vs halide_buffer_t) when AOT-compiled.
     halide_target_feature_tsan,                    ///< Enable hooks for TSAN support.
     halide_target_feature_asan,                    ///< Enable hooks for ASAN support.
@@ -1337,6 +1337,8 @@ typedef enum halide_target_feature_t {
     halide_target_feature_sve,                     ///< Enable ARM Scalable Vector Extensions
     halide_target_feature_sve2,                    ///< Enable ARM Scalable Vector Extensions v2
     halide_target_feature_egl,                     ///< Force use of EGL support.
+    halide_target_feature_arena_allocation,        ///< Pack heap allocations into one arena per pipeline or parallel task.
+    halide_target_feature_param_profile,           ///< Record histograms of scalar arguments and buffer shapes per pipeline call.
 
     halide_target_feature_end  ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
@@ -1799,6 +1801,10 @@ struct halide_profiler_pipeline_stats {
 
     /** The total number of memory allocation of funcs in this pipeline. */
     int num_allocs;
+
+    /** The number of runs that were sampled. Time is only billed
+     * during sampled runs. See halide_profiler_set_sampling_period. */
+    int sampled_runs;
 };
 
 /** The global state of the profiler. */
@@ -1842,7 +1848,11 @@ enum {
     /// Set current_func to this value to tell the profiling thread to
     /// halt. It will start up again next time you run a pipeline with
     /// profiling enabled.
-    halide_profiler_please_stop = -2
+    halide_profiler_please_stop = -2,
+    /// halide_profiler_pipeline_start returns this for a run that
+    /// isn't sampled. It's larger than any func id. See
+    /// halide_profiler_set_sampling_period.
+    halide_profiler_unsampled_run = 1 << 30
 };
 
 /** Get a pointer to the global profiler state for programmatic
@@ -1872,6 +1882,99 @@ void halide_profiler_shutdown();
  * reset. Also happens at process exit. */
 extern void halide_profiler_report(void *user_context);
 
+/** Only profile one in every period runs of each pipeline (the first
+ * one, and every period-th one after that). The other runs count
+ * towards the pipeline's runs but are not billed any time. The time
+ * billed to a Func over all runs can be estimated as its time scaled
+ * by runs / sampled_runs. Defaults to 1, which profiles every run.
+ *
+ * The profile feature compiles a second copy of each pipeline with no
+ * profiling calls in it, and halide_profiler_pipeline_start tells a
+ * run that isn't sampled to use that copy. Once a pipeline has been
+ * seen, that decision is made without taking the profiler's lock, so
+ * an unsampled run costs one call and one atomic increment. */
+extern void halide_profiler_set_sampling_period(int period);
+
+/** One entry of a profiler snapshot: the cumulative time billed to one
+ * Func of one pipeline since the last reset. */
+struct halide_profiler_func_snapshot {
+    /** The name of the pipeline. A global constant string. */
+    const char *pipeline_name;
+
+    /** The name of the Func. A global constant string. */
+    const char *func_name;
+
+    /** Total time billed to this Func over the sampled runs of the
+     * pipeline (in nanoseconds). */
+    uint64_t time;
+
+    /** The number of times the pipeline has been run, and how many of
+     * those runs were sampled. */
+    int runs, sampled_runs;
+};
+
+/** Copy the cumulative per-Func statistics of every pipeline run since
+ * the last reset into entries, for a service to poll and export. At
+ * most max_entries are written. Returns the number of entries
+ * available, which may be larger than max_entries, in which case the
+ * caller should retry with a bigger array. Grabs the global profiler
+ * state's lock, so it is safe to call while pipelines run. */
+extern int halide_profiler_snapshot(struct halide_profiler_func_snapshot *entries, int max_entries);
+
+/** Print the same statistics as halide_profiler_snapshot using
+ * halide_print, one line per Func of the form
+ * "halide_profiler_snapshot <pipeline> <func> <time in ns> <runs>
+ * <sampled runs>". Two such reports can be compared with
+ * tools/profiler_snapshot_diff. */
+extern void halide_profiler_snapshot_report(void *user_context);
+
+/** The maximum number of code paths counted per pipeline by
+ * halide_shape_dispatch. */
+#define halide_shape_dispatch_max_paths 64
+
+/** Called at the start of a pipeline built with the Generator's
+ * shape_specializations or specialization_profile params, with the
+ * index of the specialization that will be taken, or the number of
+ * specializations if the generic path will be taken. Shape
+ * specializations come first, followed by those for hot scalar
+ * values. The default
+ * implementation counts calls per pipeline and path. Bounds queries
+ * are not counted. */
+extern int halide_shape_dispatch(void *user_context, const char *pipeline_name, int path);
+
+/** Get the counts recorded by the default halide_shape_dispatch for
+ * the named pipeline. Fills in counts[i] with the number of calls
+ * that took path i, for i < max_paths, and returns one more than the
+ * highest path taken (zero if the pipeline hasn't been called). */
+extern int halide_shape_dispatch_counts(void *user_context, const char *pipeline_name,
+                                        uint64_t *counts, int max_paths);
+
+/** Reset the counts recorded by the default halide_shape_dispatch. */
+extern void halide_shape_dispatch_reset(void *user_context);
+
+/** Called at the start of each (non-bounds-query) call to a pipeline
+ * compiled with the param_profile target feature, once for each
+ * integer scalar argument and once for the shape of each buffer
+ * argument. num_values is the number of the values v0, v1, v2 that
+ * are meaningful: one for a scalar, and the extent of dimension
+ * zero, extent of dimension one, and stride of dimension one for a
+ * buffer (just the extent for a one-dimensional buffer). The default
+ * implementation keeps a histogram of the values seen for each
+ * pipeline and argument. */
+extern int halide_param_profile_record(void *user_context, const char *pipeline_name, const char *name,
+                                       int num_values, int64_t v0, int64_t v1, int64_t v2);
+
+/** Print the histograms recorded by the default
+ * halide_param_profile_record using halide_print, one line per value
+ * of the form "halide_param_profile <pipeline> <argument> <count>
+ * <values...>". This is the format read by the Generator's
+ * specialization_profile param. Also happens at process exit. */
+extern void halide_param_profile_report(void *user_context);
+
+/** Reset the histograms recorded by the default
+ * halide_param_profile_record. */
+extern void halide_param_profile_reset();
+
 /// \name "Float16" functions
 /// These functions operate of bits (``uint16_t``) representing a half
 /// precision floating point number (IEEE-754 2008 binary16).
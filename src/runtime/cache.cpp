@@ -176,12 +176,26 @@ WEAK void CacheEntry::destroy() {
     halide_free(NULL, metadata_storage);
 }
 
-WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size) {
-    uint32_t h = 5381;
-    for (size_t i = 0; i < key_size; i++) {
-        h = (h << 5) + h + key[i];
-    }
-    return h;
+// Hash the key a word at a time. Keys made by the generated code
+// start with a 64-bit id of the function, followed by the parameter
+// values in decreasing order of size, so they're mostly whole words.
+WEAK uint32_t key_hash(const uint8_t *key, size_t key_size) {
+    const uint64_t m = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = key_size * m;
+    size_t i = 0;
+    for (; i + 8 <= key_size; i += 8) {
+        uint64_t word;
+        memcpy(&word, key + i, sizeof(word));
+        h = (h ^ word) * m;
+        h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    for (; i < key_size; i++) {
+        tail = (tail << 8) | key[i];
+    }
+    h = (h ^ tail) * m;
+    h ^= h >> 32;
+    return (uint32_t)h;
 }
 
 WEAK halide_mutex memoization_lock = {{0}};
@@ -325,7 +339,7 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
 
 WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
                                          halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
-    uint32_t h = djb_hash(cache_key, size);
+    uint32_t h = key_hash(cache_key, size);
     uint32_t index = h % kHashTableSize;
 
     ScopedMutexLock lock(&memoization_lock);
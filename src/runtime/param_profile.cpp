@@ -0,0 +1,131 @@
+#include "HalideRuntime.h"
+#include "printer.h"
+#include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// One bucket of a histogram of the values a pipeline argument (or a
+// tuple of them, e.g. an output shape) took on.
+struct param_profile_bucket {
+    param_profile_bucket *next;
+    const char *pipeline_name;
+    const char *name;
+    int num_values;
+    int64_t values[3];
+    uint64_t count;
+};
+
+WEAK param_profile_bucket *param_profile_list = NULL;
+WEAK int param_profile_num_buckets = 0;
+WEAK halide_mutex param_profile_lock = {{0}};
+
+// Bound the memory used by arguments that take on many values. The
+// values of interest for specialization are the frequent ones, which
+// will have shown up before this fills.
+const int param_profile_max_buckets = 4096;
+
+WEAK void param_profile_report_unlocked(void *user_context) {
+    char line_buf[256];
+    Printer<StringStreamPrinter, sizeof(line_buf)> sstr(user_context, line_buf);
+    for (param_profile_bucket *b = param_profile_list; b; b = b->next) {
+        sstr.clear();
+        sstr << "halide_param_profile " << b->pipeline_name << " " << b->name << " " << b->count;
+        for (int i = 0; i < b->num_values; i++) {
+            sstr << " " << b->values[i];
+        }
+        sstr << "\n";
+        halide_print(user_context, sstr.str());
+    }
+}
+
+WEAK void param_profile_reset_unlocked() {
+    while (param_profile_list) {
+        param_profile_bucket *b = param_profile_list;
+        param_profile_list = b->next;
+        free(b);
+    }
+    param_profile_num_buckets = 0;
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_param_profile_record(void *user_context, const char *pipeline_name, const char *name,
+                                     int num_values, int64_t v0, int64_t v1, int64_t v2) {
+    int64_t values[3] = {v0, v1, v2};
+    if (num_values < 1 || num_values > 3) {
+        return 0;
+    }
+
+    ScopedMutexLock lock(&param_profile_lock);
+
+    param_profile_bucket *b = param_profile_list;
+    for (; b; b = b->next) {
+        // The same pipeline will deliver the same global constant
+        // strings, so they can be compared by pointer.
+        if (b->pipeline_name != pipeline_name || b->name != name) {
+            continue;
+        }
+        bool match = true;
+        for (int i = 0; i < num_values; i++) {
+            match &= (b->values[i] == values[i]);
+        }
+        if (match) {
+            break;
+        }
+    }
+    if (!b) {
+        if (param_profile_num_buckets >= param_profile_max_buckets) {
+            return 0;
+        }
+        b = (param_profile_bucket *)malloc(sizeof(param_profile_bucket));
+        if (!b) {
+            // Profiling is best-effort. Don't fail the pipeline over it.
+            return 0;
+        }
+        b->pipeline_name = pipeline_name;
+        b->name = name;
+        b->num_values = num_values;
+        for (int i = 0; i < 3; i++) {
+            b->values[i] = values[i];
+        }
+        b->count = 0;
+        b->next = param_profile_list;
+        param_profile_list = b;
+        param_profile_num_buckets++;
+    }
+    b->count++;
+    return 0;
+}
+
+WEAK void halide_param_profile_report(void *user_context) {
+    ScopedMutexLock lock(&param_profile_lock);
+    param_profile_report_unlocked(user_context);
+}
+
+WEAK void halide_param_profile_reset() {
+    ScopedMutexLock lock(&param_profile_lock);
+    param_profile_reset_unlocked();
+}
+
+#ifndef WINDOWS
+__attribute__((destructor))
+#endif
+WEAK void
+halide_param_profile_shutdown() {
+    if (!param_profile_list) {
+        return;
+    }
+    // No need to lock anything; we're shutting down.
+    param_profile_report_unlocked(NULL);
+    param_profile_reset_unlocked();
+}
+}
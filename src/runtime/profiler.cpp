@@ -18,6 +18,9 @@ namespace Halide {
 namespace Runtime {
 namespace Internal {
 
+// Profile one in this many runs of each pipeline.
+WEAK int profiler_sampling_period = 1;
+
 WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipeline_name, int num_funcs, const uint64_t *func_names) {
     halide_profiler_state *s = halide_profiler_get_state();
 
@@ -39,6 +42,7 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     p->first_func_id = s->first_free_id;
     p->num_funcs = num_funcs;
     p->runs = 0;
+    p->sampled_runs = 0;
     p->time = 0;
     p->samples = 0;
     p->memory_current = 0;
@@ -64,10 +68,31 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
         p->funcs[i].active_threads_denominator = 0;
     }
     s->first_free_id += num_funcs;
-    s->pipelines = p;
+    // Publish the fully initialized entry, for find_pipeline_unlocked.
+    __atomic_store_n(&s->pipelines, p, __ATOMIC_RELEASE);
     return p;
 }
 
+// Look for a pipeline that has already been seen, without taking the
+// lock. The list is only ever added to or reordered while the lock is
+// held, and entries are only freed by halide_profiler_reset, which
+// mustn't run at the same time as a pipeline. A reorder going on at
+// the same time can make us miss the entry or revisit some, so give up
+// after a while; the caller then takes the lock and looks again.
+WEAK halide_profiler_pipeline_stats *find_pipeline_unlocked(halide_profiler_state *s,
+                                                            const char *pipeline_name,
+                                                            int num_funcs) {
+    halide_profiler_pipeline_stats *p = __atomic_load_n(&s->pipelines, __ATOMIC_ACQUIRE);
+    for (int i = 0; p && i < 64; i++) {
+        if (p->name == pipeline_name &&
+            p->num_funcs == num_funcs) {
+            return p;
+        }
+        p = (halide_profiler_pipeline_stats *)__atomic_load_n(&p->next, __ATOMIC_ACQUIRE);
+    }
+    return NULL;
+}
+
 WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads) {
     halide_profiler_pipeline_stats *p_prev = NULL;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
@@ -77,7 +102,7 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int ac
                 // Bubble the pipeline to the top to speed up future queries.
                 p_prev->next = (halide_profiler_pipeline_stats *)(p->next);
                 p->next = s->pipelines;
-                s->pipelines = p;
+                __atomic_store_n(&s->pipelines, p, __ATOMIC_RELEASE);
             }
             halide_profiler_func_stats *f = p->funcs + func_id - p->first_func_id;
             f->time += time;
@@ -180,6 +205,17 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const uint64_t *func_names) {
     halide_profiler_state *s = halide_profiler_get_state();
 
+    // Most runs aren't sampled when the sampling period is more than
+    // one. Count them, and tell the pipeline to run its unprofiled
+    // copy, without taking the lock.
+    halide_profiler_pipeline_stats *p = NULL;
+    if (profiler_sampling_period > 1) {
+        p = find_pipeline_unlocked(s, pipeline_name, num_funcs);
+        if (p && __sync_fetch_and_add(&p->runs, 1) % profiler_sampling_period != 0) {
+            return halide_profiler_unsampled_run;
+        }
+    }
+
     ScopedMutexLock lock(&s->lock);
 
     if (!s->sampling_thread) {
@@ -187,17 +223,27 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
         s->sampling_thread = halide_spawn_thread(sampling_profiler_thread, NULL);
     }
 
-    halide_profiler_pipeline_stats *p =
-        find_or_create_pipeline(pipeline_name, num_funcs, func_names);
     if (!p) {
-        // Allocating space to track the statistics failed.
-        return halide_error_out_of_memory(user_context);
+        p = find_or_create_pipeline(pipeline_name, num_funcs, func_names);
+        if (!p) {
+            // Allocating space to track the statistics failed.
+            return halide_error_out_of_memory(user_context);
+        }
+        if (__sync_fetch_and_add(&p->runs, 1) % profiler_sampling_period != 0) {
+            return halide_profiler_unsampled_run;
+        }
     }
-    p->runs++;
+    p->sampled_runs++;
 
     return p->first_func_id;
 }
 
+WEAK void halide_profiler_set_sampling_period(int period) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+    profiler_sampling_period = period < 1 ? 1 : period;
+}
+
 WEAK void halide_profiler_stack_peak_update(void *user_context,
                                             void *pipeline_state,
                                             uint64_t *f_values) {
@@ -303,8 +349,11 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
         sstr << p->name << "\n"
              << " total time: " << t << " ms"
              << "  samples: " << p->samples
-             << "  runs: " << p->runs
-             << "  time/run: " << t / p->runs << " ms\n";
+             << "  runs: " << p->runs;
+        if (p->sampled_runs != p->runs) {
+            sstr << "  sampled runs: " << p->sampled_runs;
+        }
+        sstr << "  time/run: " << t / p->sampled_runs << " ms\n";
         if (!serial) {
             sstr << " average threads used: " << threads << "\n";
         }
@@ -339,7 +388,7 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                     sstr << " ";
                 }
 
-                float ft = fs->time / (p->runs * 1000000.0f);
+                float ft = fs->time / (p->sampled_runs * 1000000.0f);
                 sstr << ft;
                 // We don't need 6 sig. figs.
                 sstr.erase(3);
@@ -404,6 +453,45 @@ WEAK void halide_profiler_report(void *user_context) {
     halide_profiler_report_unlocked(user_context, s);
 }
 
+WEAK int halide_profiler_snapshot(halide_profiler_func_snapshot *entries, int max_entries) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+
+    int count = 0;
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        for (int i = 0; i < p->num_funcs; i++) {
+            if (count < max_entries) {
+                halide_profiler_func_snapshot *e = entries + count;
+                e->pipeline_name = p->name;
+                e->func_name = p->funcs[i].name;
+                e->time = p->funcs[i].time;
+                e->runs = p->runs;
+                e->sampled_runs = p->sampled_runs;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+WEAK void halide_profiler_snapshot_report(void *user_context) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+
+    char line_buf[1024];
+    Printer<StringStreamPrinter, sizeof(line_buf)> sstr(user_context, line_buf);
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        for (int i = 0; i < p->num_funcs; i++) {
+            sstr.clear();
+            sstr << "halide_profiler_snapshot " << p->name << " " << p->funcs[i].name << " "
+                 << p->funcs[i].time << " " << p->runs << " " << p->sampled_runs << "\n";
+            halide_print(user_context, sstr.str());
+        }
+    }
+}
+
 WEAK void halide_profiler_reset_unlocked(halide_profiler_state *s) {
     while (s->pipelines) {
         halide_profiler_pipeline_stats *p = s->pipelines;
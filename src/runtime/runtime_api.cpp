@@ -171,6 +171,15 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_profiler_pipeline_start,
     (void *)&halide_profiler_report,
     (void *)&halide_profiler_reset,
+    (void *)&halide_profiler_set_sampling_period,
+    (void *)&halide_profiler_snapshot,
+    (void *)&halide_profiler_snapshot_report,
+    (void *)&halide_shape_dispatch,
+    (void *)&halide_shape_dispatch_counts,
+    (void *)&halide_shape_dispatch_reset,
+    (void *)&halide_param_profile_record,
+    (void *)&halide_param_profile_report,
+    (void *)&halide_param_profile_reset,
     (void *)&halide_profiler_stack_peak_update,
     (void *)&halide_qurt_hvx_lock,
     (void *)&halide_qurt_hvx_unlock,
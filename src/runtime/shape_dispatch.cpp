@@ -0,0 +1,90 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// Per-pipeline counts of which shape specialization was taken.
+struct shape_dispatch_counters {
+    shape_dispatch_counters *next;
+    const char *pipeline_name;
+    uint64_t counts[halide_shape_dispatch_max_paths];
+};
+
+WEAK shape_dispatch_counters *shape_dispatch_list = NULL;
+WEAK halide_mutex shape_dispatch_lock = {{0}};
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_shape_dispatch(void *user_context, const char *pipeline_name, int path) {
+    if (path < 0 || path >= halide_shape_dispatch_max_paths) {
+        return 0;
+    }
+
+    ScopedMutexLock lock(&shape_dispatch_lock);
+
+    shape_dispatch_counters *c = shape_dispatch_list;
+    // The same pipeline will deliver the same global constant
+    // string, so they can be compared by pointer.
+    while (c && c->pipeline_name != pipeline_name) {
+        c = c->next;
+    }
+    if (!c) {
+        c = (shape_dispatch_counters *)malloc(sizeof(shape_dispatch_counters));
+        if (!c) {
+            // Counting is best-effort. Don't fail the pipeline over it.
+            return 0;
+        }
+        c->pipeline_name = pipeline_name;
+        memset(c->counts, 0, sizeof(c->counts));
+        c->next = shape_dispatch_list;
+        shape_dispatch_list = c;
+    }
+    c->counts[path]++;
+    return 0;
+}
+
+WEAK int halide_shape_dispatch_counts(void *user_context, const char *pipeline_name,
+                                      uint64_t *counts, int max_paths) {
+    for (int i = 0; i < max_paths; i++) {
+        counts[i] = 0;
+    }
+
+    ScopedMutexLock lock(&shape_dispatch_lock);
+
+    int paths = 0;
+    for (shape_dispatch_counters *c = shape_dispatch_list; c; c = c->next) {
+        if (strcmp(c->pipeline_name, pipeline_name) != 0) {
+            continue;
+        }
+        for (int i = 0; i < halide_shape_dispatch_max_paths; i++) {
+            if (c->counts[i] == 0) {
+                continue;
+            }
+            if (i < max_paths) {
+                counts[i] += c->counts[i];
+            }
+            paths = paths > i + 1 ? paths : i + 1;
+        }
+    }
+    return paths;
+}
+
+WEAK void halide_shape_dispatch_reset(void *user_context) {
+    ScopedMutexLock lock(&shape_dispatch_lock);
+
+    while (shape_dispatch_list) {
+        shape_dispatch_counters *c = shape_dispatch_list;
+        shape_dispatch_list = c->next;
+        free(c);
+    }
+}
+}
@@ -0,0 +1,252 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+// Count the calls to halide_malloc, and track the peak number of
+// bytes allocated at once.
+std::atomic<int> malloc_count;
+std::atomic<size_t> bytes_allocated, peak_bytes_allocated;
+
+void *my_malloc(void *user_context, size_t x) {
+    malloc_count++;
+    size_t current = (bytes_allocated += x);
+    size_t peak = peak_bytes_allocated;
+    while (current > peak && !peak_bytes_allocated.compare_exchange_weak(peak, current)) {
+    }
+    void *orig = malloc(x + 32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    ((size_t *)ptr)[-2] = x;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    bytes_allocated -= ((size_t *)ptr)[-2];
+    free(((void **)ptr)[-1]);
+}
+
+void reset_counters() {
+    malloc_count = 0;
+    bytes_allocated = 0;
+    peak_bytes_allocated = 0;
+}
+
+std::string error_message;
+void my_error(void *user_context, const char *msg) {
+    error_message += msg;
+}
+
+int check(const Buffer<int> &im) {
+    for (int y = 0; y < im.height(); y++) {
+        for (int x = 0; x < im.width(); x++) {
+            int correct = 8 * (x + y) + 2;
+            if (im(x, y) != correct) {
+                printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (t.arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+    Target arena_target = t.with_feature(Target::ArenaAllocation);
+
+    const int W = 1000, H = 32;
+    Var x, y;
+
+    {
+        // A chain of root stages. Without an arena each one is a
+        // separate malloc. With one, there's a single malloc, and
+        // f and h share storage as they're never live at the same
+        // time, so the arena holds two of them, not three.
+        Func f, g, h, out;
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) * 2 + 1;
+        h(x, y) = g(x, y) * 2;
+        out(x, y) = h(x, y) * 2 - 2;
+        f.compute_root();
+        g.compute_root();
+        h.compute_root();
+        out.set_custom_allocator(my_malloc, my_free);
+
+        reset_counters();
+        Buffer<int> im = out.realize(W, H, t);
+        if (check(im)) return -1;
+        if (malloc_count != 3) {
+            printf("Expected 3 mallocs without an arena, got %d\n", malloc_count.load());
+            return -1;
+        }
+        size_t peak_without_arena = peak_bytes_allocated;
+
+        reset_counters();
+        im = out.realize(W, H, arena_target);
+        if (check(im)) return -1;
+        if (malloc_count != 1) {
+            printf("Expected 1 malloc with an arena, got %d\n", malloc_count.load());
+            return -1;
+        }
+        const size_t stage_size = W * H * sizeof(int);
+        if (peak_bytes_allocated >= 3 * stage_size) {
+            printf("The arena is %d bytes, so f and h don't share storage\n",
+                   (int)peak_bytes_allocated.load());
+            return -1;
+        }
+        if (peak_bytes_allocated > peak_without_arena + 256) {
+            printf("Peak memory use went from %d bytes to %d bytes with an arena\n",
+                   (int)peak_without_arena, (int)peak_bytes_allocated.load());
+            return -1;
+        }
+    }
+
+    {
+        // A single stage computed per scanline of a serial loop.
+        // Without an arena it's a malloc per scanline. With one, the
+        // allocation is made once, outside the loop.
+        Func f, out;
+        f(x, y) = (x + y) * 4;
+        out(x, y) = f(x, y) * 2 + 2;
+        f.compute_at(out, y);
+        out.set_custom_allocator(my_malloc, my_free);
+
+        reset_counters();
+        Buffer<int> im = out.realize(W, H, t);
+        if (check(im)) return -1;
+        if (malloc_count != H) {
+            printf("Expected %d mallocs without an arena, got %d\n", H, malloc_count.load());
+            return -1;
+        }
+
+        reset_counters();
+        im = out.realize(W, H, arena_target);
+        if (check(im)) return -1;
+        if (malloc_count != 1) {
+            printf("Expected 1 malloc with an arena, got %d\n", malloc_count.load());
+            return -1;
+        }
+    }
+
+    {
+        // Scanlines computed per parallel task. Each task gets its
+        // own arena.
+        Func f, g, out;
+        f(x, y) = (x + y) * 2;
+        g(x, y) = f(x, y) * 2 + 1;
+        out(x, y) = g(x, y) * 2;
+        f.compute_at(out, y);
+        g.compute_at(out, y);
+        out.parallel(y);
+        out.set_custom_allocator(my_malloc, my_free);
+
+        reset_counters();
+        Buffer<int> im = out.realize(W, H, t);
+        if (check(im)) return -1;
+        if (malloc_count != 2 * H) {
+            printf("Expected %d mallocs without an arena, got %d\n", 2 * H, malloc_count.load());
+            return -1;
+        }
+
+        reset_counters();
+        im = out.realize(W, H, arena_target);
+        if (check(im)) return -1;
+        if (malloc_count != H) {
+            printf("Expected %d mallocs with an arena, got %d\n", H, malloc_count.load());
+            return -1;
+        }
+    }
+
+    {
+        // The arena comes after the early return for bounds queries,
+        // and after the checks on the input, so neither allocates it.
+        ImageParam input(Int(32), 2);
+        Func f, g, out;
+        f(x, y) = input(x, y) + x + y;
+        g(x, y) = f(x, y) * 2 + 1;
+        out(x, y) = g(x, y) * 4 - 2;
+        f.compute_root();
+        g.compute_root();
+        out.set_custom_allocator(my_malloc, my_free);
+        out.set_error_handler(my_error);
+        out.compile_jit(arena_target);
+
+        reset_counters();
+        out.infer_input_bounds(W, H);
+        if (malloc_count != 0) {
+            printf("A bounds query made %d mallocs\n", malloc_count.load());
+            return -1;
+        }
+        Buffer<int> in = input.get();
+        if (in.width() != W || in.height() != H) {
+            printf("The bounds query inferred an input of %d x %d\n", in.width(), in.height());
+            return -1;
+        }
+        in.fill(0);
+
+        reset_counters();
+        Buffer<int> im = out.realize(W, H, arena_target);
+        if (check(im)) return -1;
+        if (malloc_count != 1) {
+            printf("Expected 1 malloc with an arena, got %d\n", malloc_count.load());
+            return -1;
+        }
+
+        // An input that's too small is reported as such.
+        Buffer<int> too_small(W / 2, H);
+        input.set(too_small);
+        reset_counters();
+        error_message.clear();
+        out.realize(W, H, arena_target);
+        if (error_message.find("is accessed at") == std::string::npos) {
+            printf("Expected an out of bounds error for the input, got: %s\n", error_message.c_str());
+            return -1;
+        }
+        if (malloc_count != 0) {
+            printf("Made %d mallocs before checking the input\n", malloc_count.load());
+            return -1;
+        }
+    }
+
+    {
+        // The extent of f depends on the contents of lut. Its size
+        // must not be read from lut before lut has been checked.
+        ImageParam lut(Int(32), 1);
+        RDom r(0, clamp(lut(0), 1, 16));
+        Func f, g, h, out;
+        f(x, y) = x + y;
+        h(x, y) = x - y;
+        g(x, y) = h(x, y) * 2;
+        out(x, y) = sum(f(x + r, y)) + g(x, y);
+        f.compute_root();
+        g.compute_root();
+        h.compute_root();
+        out.set_custom_allocator(my_malloc, my_free);
+        out.compile_jit(arena_target);
+
+        for (int n : {5, 12}) {
+            Buffer<int> lut_buf(1);
+            lut_buf(0) = n;
+            lut.set(lut_buf);
+            Buffer<int> im = out.realize(W, H, arena_target);
+            for (int y = 0; y < H; y++) {
+                for (int x = 0; x < W; x++) {
+                    int correct = n * (x + y) + n * (n - 1) / 2 + 2 * (x - y);
+                    if (im(x, y) != correct) {
+                        printf("With lut(0) = %d, im(%d, %d) = %d instead of %d\n",
+                               n, x, y, im(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -18,6 +18,25 @@ extern "C" DLLEXPORT int expensive(int x) {
 }
 HalideExtern_1(int, expensive, int);
 
+// Records the size of the allocation for a Func, in elements.
+class FindAllocationSize : public Internal::IRMutator {
+    using IRMutator::visit;
+
+    Internal::Stmt visit(const Internal::Allocate *op) override {
+        if (op->name == name) {
+            *size = op->constant_allocation_size();
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    std::string name;
+    int32_t *size;
+    FindAllocationSize(const std::string &name, int32_t *size)
+        : name(name), size(size) {
+    }
+};
+
 int main(int argc, char **argv) {
     if (get_jit_target_from_environment().arch == Target::WebAssembly) {
         printf("Skipping test for WebAssembly as it does not support async() yet.\n");
@@ -446,6 +465,43 @@ int main(int argc, char **argv) {
         });
     }
 
+    // A deeper async producer with automatic folding, sliding over
+    // rows of a stencil. The producer may run several rows ahead of
+    // the consumer through a larger ring buffer.
+    for (int depth : {1, 4}) {
+        Func producer("ring_producer"), consumer;
+        Var x, y;
+
+        producer(x, y) = x + y;
+        consumer(x, y) = expensive(producer(x, y - 1) + producer(x, y) + producer(x, y + 1));
+
+        consumer.compute_root();
+        producer.store_root().compute_at(consumer, y).async(depth);
+
+        int32_t allocation_size = 0;
+        consumer.add_custom_lowering_pass(new FindAllocationSize(producer.name(), &allocation_size));
+
+        Buffer<int> out = consumer.realize(64, 64);
+
+        // The footprint is three rows, so the fold factor is four
+        // rows, times the depth.
+        int32_t correct_size = 64 * 4 * depth;
+        if (allocation_size != correct_size) {
+            printf("With depth %d, the producer's folded allocation has %d elements instead of %d\n",
+                   depth, allocation_size, correct_size);
+            return -1;
+        }
+
+        out.for_each_element([&](int x, int y) {
+            int correct = 3 * (x + y);
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n",
+                       x, y, out(x, y), correct);
+                exit(-1);
+            }
+        });
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -246,6 +246,90 @@ void test_parallel_cas_update(const Backend &backend) {
     }
 }
 
+template<typename T>
+void test_parallel_hist_max(const Backend &backend) {
+    int img_size = 1000;
+    int hist_size = 13;
+
+    Func im, hist;
+    Var x;
+    RDom r(0, img_size);
+
+    im(x) = (x * x) % hist_size;
+
+    hist(x) = cast<T>(0);
+    // An atomic rmw max for integers, a CAS loop for floats
+    hist(im(r)) = max(hist(im(r)), cast<T>(r % 100));
+
+    Type t = cast<T>(0).type();
+    bool is_float_16 = t.is_float() && t.bits() == 16;
+
+    hist.compute_root();
+    // Associativity prover doesn't support float16,
+    // Set override_associativity_test to true to remove the check.
+    switch (backend) {
+    case Backend::CPU: {
+        hist.update()
+            .atomic(is_float_16 /*override_associativity_test*/)
+            .parallel(r);
+    } break;
+    case Backend::CPUVectorize: {
+        RVar ro, ri;
+        hist.update()
+            .atomic(is_float_16 /*override_associativity_test*/)
+            .split(r, ro, ri, 8)
+            .parallel(ro)
+            .vectorize(ri);
+    } break;
+    case Backend::OpenCL: {
+        RVar ro, ri;
+        hist.update()
+            .atomic()
+            .split(r, ro, ri, 32)
+            .gpu_blocks(ro, DeviceAPI::OpenCL)
+            .gpu_threads(ri, DeviceAPI::OpenCL);
+    } break;
+    case Backend::CUDA: {
+        RVar ro, ri;
+        hist.update()
+            .atomic()
+            .split(r, ro, ri, 32)
+            .gpu_blocks(ro, DeviceAPI::CUDA)
+            .gpu_threads(ri, DeviceAPI::CUDA);
+    } break;
+    case Backend::CUDAVectorize: {
+        RVar ro, ri;
+        RVar rio, rii;
+        hist.update()
+            .atomic()
+            .split(r, ro, ri, 32)
+            .split(ri, rio, rii, 4)
+            .gpu_blocks(ro, DeviceAPI::CUDA)
+            .gpu_threads(rio, DeviceAPI::CUDA)
+            .vectorize(rii);
+    } break;
+    default: {
+        _halide_user_assert(false) << "Unsupported backend.\n";
+    } break;
+    }
+
+    Buffer<T> correct(hist_size);
+    correct.fill(T(0));
+    for (int i = 0; i < img_size; i++) {
+        int idx = (i * i) % hist_size;
+        T x = T(i % 100);
+        correct(idx) = correct(idx) < x ? x : correct(idx);
+    }
+
+    // Run 10 times to make sure race condition do happen
+    for (int iter = 0; iter < 10; iter++) {
+        Buffer<T> out = hist.realize(hist_size);
+        for (int i = 0; i < hist_size; i++) {
+            check(__LINE__, out(i), correct(i));
+        }
+    }
+}
+
 template<typename T>
 void test_parallel_hist_tuple(const Backend &backend) {
     int img_size = 10000;
@@ -264,15 +348,20 @@ void test_parallel_hist_tuple(const Backend &backend) {
     bool is_float_16 = t.is_float() && t.bits() == 16;
 
     hist.compute_root();
-    if (is_float_16) {
-        // Associativity prover doesn't support float16,
-        // Set override_associativity_test to true to remove the check.
+    // Associativity prover doesn't support float16,
+    // Set override_associativity_test to true to remove the check.
+    if (backend == Backend::CPUVectorize) {
+        // Each tuple element only depends on itself, so this doesn't
+        // need a mutex and can be vectorized.
+        RVar ro, ri;
         hist.update()
-            .atomic(true /*override_associativity_test*/)
-            .parallel(r);
+            .atomic(is_float_16 /*override_associativity_test*/)
+            .split(r, ro, ri, 8)
+            .parallel(ro)
+            .vectorize(ri);
     } else {
         hist.update()
-            .atomic()
+            .atomic(is_float_16 /*override_associativity_test*/)
             .parallel(r);
     }
 
@@ -973,6 +1062,7 @@ template<typename T>
 void test_all(const Backend &backend) {
     test_parallel_hist<T>(backend);
     test_parallel_cas_update<T>(backend);
+    test_parallel_hist_max<T>(backend);
     if (backend != Backend::CPUVectorize) {
         // Doesn't support vectorized predicated store yet.
         test_predicated_hist<T>(backend);
@@ -982,9 +1072,13 @@ void test_all(const Backend &backend) {
         test_hist_store_at<T>(backend);
     }
     test_hist_rfactor<T>(backend);
+    if (backend == Backend::CPU || backend == Backend::CPUVectorize) {
+        // The elements of this tuple are updated independently, so it
+        // doesn't need a mutex.
+        test_parallel_hist_tuple<T>(backend);
+    }
     if (backend == Backend::CPU) {
         // These require mutex locking which does not support vectorization and GPU
-        test_parallel_hist_tuple<T>(backend);
         test_parallel_hist_tuple2<T>(backend);
         test_tuple_reduction<T>(backend);
         test_nested_atomics<T>(backend);
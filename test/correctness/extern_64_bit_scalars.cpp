@@ -0,0 +1,49 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Check that 64-bit integer scalars make it to and from extern
+// functions intact. When the JIT target is wasm, this exercises the
+// marshalling of scalars across the wasm<->host boundary.
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+extern "C" DLLEXPORT int64_t mix_64_bit(int64_t a, uint64_t b) {
+    return a * 3 - (int64_t)(b >> 7);
+}
+HalideExtern_2(int64_t, mix_64_bit, int64_t, uint64_t);
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (t.arch == Target::WebAssembly && !Internal::WasmModule::can_pass_64_bit_extern_scalars()) {
+        printf("Skipping test for WebAssembly as this wasm JIT cannot pass 64-bit scalars to externs.\n");
+        return 0;
+    }
+
+    Var x;
+    Func f;
+    // Both arguments need more than 32 bits.
+    Expr a = cast<int64_t>(x) * Expr(int64_t(1) << 40) - Expr(int64_t(1) << 35);
+    Expr b = cast<uint64_t>(x) * Expr(uint64_t(1) << 50) + Expr(uint64_t(1) << 63);
+    f(x) = mix_64_bit(a, b);
+
+    Buffer<int64_t> result = f.realize(100);
+    for (int i = 0; i < result.width(); i++) {
+        int64_t a = (int64_t)i * ((int64_t)1 << 40) - ((int64_t)1 << 35);
+        uint64_t b = (uint64_t)i * ((uint64_t)1 << 50) + ((uint64_t)1 << 63);
+        int64_t correct = mix_64_bit(a, b);
+        if (result(i) != correct) {
+            printf("result(%d) = %lld instead of %lld\n",
+                   i, (long long)result(i), (long long)correct);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
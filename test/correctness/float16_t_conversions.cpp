@@ -0,0 +1,88 @@
+#include "Halide.h"
+#include <cmath>
+#include <random>
+#include <stdio.h>
+
+using namespace Halide;
+
+// Vectorized conversions between float16 and float32 use native
+// instructions where the target has them (e.g. F16C). Check they round
+// the same way as the emulated conversions, and that trees of float16
+// arithmetic are only rounded once.
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    Var x;
+
+    // Every float16 that isn't a nan, widened to float32.
+    {
+        Buffer<uint16_t> bits(1 << 16);
+        bits.for_each_element([&](int i) { bits(i) = (uint16_t)i; });
+        Func widen;
+        widen(x) = cast<float>(reinterpret<float16_t>(bits(x)));
+        widen.vectorize(x, 16);
+        Buffer<float> out = widen.realize(1 << 16, target);
+        for (int i = 0; i < (1 << 16); i++) {
+            float16_t h = float16_t::make_from_bits((uint16_t)i);
+            if (h.is_nan()) {
+                continue;
+            }
+            if (out(i) != (float)h) {
+                printf("float16 0x%04x widened to %.9g instead of %.9g\n", i, out(i), (float)h);
+                return -1;
+            }
+        }
+    }
+
+    // Random floats within the float16 range, including ones that
+    // become denormals, narrowed to float16.
+    {
+        const int size = 1 << 16;
+        Buffer<float> in(size);
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> exponent(-20.0f, 14.9f);
+        std::uniform_real_distribution<float> mantissa(-2.0f, 2.0f);
+        in.for_each_element([&](int i) { in(i) = mantissa(rng) * std::exp2(exponent(rng)); });
+        Func narrow;
+        narrow(x) = cast<float16_t>(in(x));
+        narrow.vectorize(x, 16);
+        Buffer<float16_t> out = narrow.realize(size, target);
+        for (int i = 0; i < size; i++) {
+            float16_t correct(in(i));
+            if (out(i).to_bits() != correct.to_bits()) {
+                printf("%.9g narrowed to float16 0x%04x instead of 0x%04x\n",
+                       in(i), out(i).to_bits(), correct.to_bits());
+                return -1;
+            }
+        }
+    }
+
+    // a * b + c is computed in float32 and rounded to float16 once. The
+    // product of two float16s is exact in float32.
+    {
+        const int size = 4096;
+        Buffer<float16_t> a(size), b(size), c(size);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+        for (int i = 0; i < size; i++) {
+            a(i) = float16_t(dist(rng));
+            b(i) = float16_t(dist(rng));
+            c(i) = float16_t(dist(rng));
+        }
+        Func f;
+        f(x) = a(x) * b(x) + c(x);
+        f.vectorize(x, 16);
+        Buffer<float16_t> out = f.realize(size, target);
+        for (int i = 0; i < size; i++) {
+            float16_t correct((float)a(i) * (float)b(i) + (float)c(i));
+            if (out(i).to_bits() != correct.to_bits()) {
+                printf("%f * %f + %f = %f instead of %f\n",
+                       (float)a(i), (float)b(i), (float)c(i), (float)out(i), (float)correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
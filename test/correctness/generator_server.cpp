@@ -0,0 +1,222 @@
+#include "Halide.h"
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+#ifndef _WIN32
+
+// Stands in for generate_filter_main on the server. Reports where and
+// how it was run.
+int echo_job(int argc, char **argv, std::ostream &cerr) {
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd))) {
+        cerr << "cwd=" << cwd << "\n";
+    }
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "-crash") {
+            abort();
+        }
+        cerr << "arg=" << argv[i] << "\n";
+    }
+    const char *env = getenv("GENERATOR_SERVER_TEST");
+    cerr << "env=" << (env ? env : "") << "\n";
+    printf("written to stdout\n");
+    return argc;
+}
+
+bool run_job(const std::vector<std::string> &args, int *result, std::string *output) {
+    std::vector<char *> argv;
+    for (const std::string &a : args) {
+        argv.push_back(const_cast<char *>(a.c_str()));
+    }
+    std::ostringstream cerr;
+    bool served = run_on_generator_server((int)argv.size(), argv.data(), cerr, result);
+    *output = cerr.str();
+    return served;
+}
+
+bool contains(const std::string &s, const std::string &pattern) {
+    return s.find(pattern) != std::string::npos;
+}
+
+// Wait for a server to start listening on path.
+bool wait_for_socket(const std::string &path, struct stat *st) {
+    for (int i = 0; i < 1000 && stat(path.c_str(), st) != 0; i++) {
+        usleep(10000);
+    }
+    if (stat(path.c_str(), st) != 0) {
+        printf("The server never created %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+pid_t start_server(const std::string &exe, const std::string &socket_path) {
+    pid_t server = fork();
+    if (server == 0) {
+        char *server_argv[] = {(char *)"gengen", (char *)"-server",
+                               (char *)socket_path.c_str(), (char *)"-j", (char *)"2", nullptr};
+        if (exe.empty()) {
+            _exit(generator_server_main(5, server_argv, std::cerr, echo_job));
+        }
+        execv(exe.c_str(), server_argv);
+        _exit(1);
+    }
+    return server;
+}
+
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] The generator server isn't supported on Windows.\n");
+    return 0;
+#else
+    // Run as a server from another executable by the test below.
+    if (argc > 1 && std::string(argv[1]) == "-server") {
+        return generator_server_main(argc, argv, std::cerr, echo_job);
+    }
+
+    char tmp_dir_template[] = "/tmp/generator_server_XXXXXX";
+    if (!mkdtemp(tmp_dir_template)) {
+        printf("Could not make a temporary directory\n");
+        return -1;
+    }
+    char tmp_dir[PATH_MAX];
+    if (!realpath(tmp_dir_template, tmp_dir)) {
+        printf("Could not resolve %s\n", tmp_dir_template);
+        return -1;
+    }
+    std::string socket_path = std::string(tmp_dir) + "/server.sock";
+
+    // The server won't replace a file that isn't a socket.
+    {
+        std::ofstream(socket_path) << "not a socket\n";
+        char *server_argv[] = {(char *)"gengen", (char *)"-server", (char *)socket_path.c_str(), nullptr};
+        std::ostringstream cerr;
+        struct stat st;
+        if (generator_server_main(3, server_argv, cerr, echo_job) == 0 ||
+            lstat(socket_path.c_str(), &st) != 0 ||
+            !S_ISREG(st.st_mode)) {
+            printf("The server replaced a regular file at %s\n", socket_path.c_str());
+            return -1;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    pid_t server = start_server("", socket_path);
+    struct stat st;
+    if (!wait_for_socket(socket_path, &st)) {
+        return -1;
+    }
+    if ((st.st_mode & 077) != 0) {
+        printf("The server's socket is accessible to other users: mode %o\n", st.st_mode & 0777);
+        return -1;
+    }
+
+    setenv("HL_GENGEN_SERVER", socket_path.c_str(), 1);
+    setenv("GENERATOR_SERVER_TEST", "from the client", 1);
+    char old_cwd[PATH_MAX];
+    if (!getcwd(old_cwd, sizeof(old_cwd)) || chdir(tmp_dir) != 0) {
+        printf("Could not change to %s\n", tmp_dir);
+        return -1;
+    }
+
+    int result = 0;
+    std::string output;
+
+    // The job runs in the client's working directory and environment,
+    // and its output comes back to the client.
+    if (!run_job({"gengen", "-o", "out", "-e", "static_library"}, &result, &output)) {
+        printf("The server didn't run the job\n");
+        return -1;
+    }
+    if (result != 5 ||
+        !contains(output, std::string("cwd=") + tmp_dir + "\n") ||
+        !contains(output, "arg=-o\narg=out\narg=-e\narg=static_library\n") ||
+        !contains(output, "env=from the client\n") ||
+        !contains(output, "written to stdout\n")) {
+        printf("Unexpected result %d from the server:\n%s", result, output.c_str());
+        return -1;
+    }
+
+    // A job that crashes only takes its own process down.
+    if (!run_job({"gengen", "-crash"}, &result, &output) ||
+        result == 0 ||
+        !contains(output, "killed by signal")) {
+        printf("Unexpected result %d from a crashing job:\n%s", result, output.c_str());
+        return -1;
+    }
+    if (!run_job({"gengen", "-o", "out"}, &result, &output) || result != 3) {
+        printf("The server didn't survive a crashing job\n");
+        return -1;
+    }
+
+    // No generators are registered in this binary, so the server turns
+    // away jobs that name one, and the client runs them itself.
+    if (run_job({"gengen", "-g", "not_linked_in", "-o", "out"}, &result, &output)) {
+        printf("The server ran a job for a generator it doesn't have\n");
+        return -1;
+    }
+
+#ifdef __linux__
+    // A server started from another executable, even one that
+    // registers the same generators, turns away our jobs.
+    {
+        std::string other_exe = std::string(tmp_dir) + "/other_gengen";
+        std::string other_socket = std::string(tmp_dir) + "/other.sock";
+        {
+            std::ifstream src("/proc/self/exe", std::ios::binary);
+            std::ofstream dst(other_exe, std::ios::binary);
+            dst << src.rdbuf();
+        }
+        chmod(other_exe.c_str(), 0700);
+        pid_t other_server = start_server(other_exe, other_socket);
+        if (!wait_for_socket(other_socket, &st)) {
+            return -1;
+        }
+        setenv("HL_GENGEN_SERVER", other_socket.c_str(), 1);
+        bool served = run_job({"gengen", "-o", "out"}, &result, &output);
+        setenv("HL_GENGEN_SERVER", socket_path.c_str(), 1);
+        kill(other_server, SIGTERM);
+        waitpid(other_server, nullptr, 0);
+        unlink(other_socket.c_str());
+        unlink(other_exe.c_str());
+        if (served) {
+            printf("A server from another executable ran the job\n");
+            return -1;
+        }
+    }
+#endif
+
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+
+    // With no server listening, the client runs the job itself.
+    if (run_job({"gengen", "-o", "out"}, &result, &output)) {
+        printf("A job was served with no server running\n");
+        return -1;
+    }
+
+    if (chdir(old_cwd) != 0) {
+        return -1;
+    }
+    unlink(socket_path.c_str());
+    rmdir(tmp_dir);
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,126 @@
+#include "Halide.h"
+#include <limits>
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Check that no division by a non-constant survives lowering inside a
+// loop.
+class CheckForDivision : public IRMutator {
+    using IRMutator::visit;
+
+    int loop_depth = 0;
+
+    Stmt visit(const For *op) override {
+        loop_depth++;
+        Stmt s = IRMutator::visit(op);
+        loop_depth--;
+        return s;
+    }
+
+    Expr visit(const Div *op) override {
+        if (loop_depth > 0 && !is_const(op->b)) {
+            found = true;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Mod *op) override {
+        if (loop_depth > 0 && !is_const(op->b)) {
+            found = true;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    bool found = false;
+};
+
+// Division and modulus the way Halide defines them.
+template<typename T>
+T reference_div(T a, T b) {
+    if (b == 0) return 0;
+    int64_t q = (int64_t)a / (int64_t)b;
+    int64_t r = (int64_t)a - q * (int64_t)b;
+    if (r < 0) q += (b > 0) ? -1 : 1;
+    return (T)q;
+}
+
+template<typename T>
+T reference_mod(T a, T b) {
+    if (b == 0) return 0;
+    return (T)((int64_t)a - (int64_t)reference_div(a, b) * (int64_t)b);
+}
+
+template<typename T>
+bool test(int vector_width) {
+    Type t = type_of<T>();
+    Param<T> divisor;
+    ImageParam input(t, 1);
+    Var x;
+    Func f;
+    f(x) = Tuple(input(x) / divisor, input(x) % divisor);
+    if (vector_width > 1) {
+        f.vectorize(x, vector_width);
+    }
+    CheckForDivision *checker = new CheckForDivision;
+    f.add_custom_lowering_pass(checker);
+    f.compile_jit();
+    if (checker->found) {
+        printf("Division by a loop invariant wasn't optimized for %s\n", type_to_c_type(t, false).c_str());
+        return false;
+    }
+
+    const int size = 1024;
+    Buffer<T> in(size);
+    in.for_each_value([&](T &v) { v = (T)rand(); });
+    in(0) = std::numeric_limits<T>::min();
+    in(1) = std::numeric_limits<T>::max();
+    in(2) = 0;
+    in(3) = (T)-1;
+    input.set(in);
+
+    std::vector<T> divisors = {0, 1, 2, 3, 7, 10, 64, 100, 127, (T)-1, (T)-3, (T)-128, in(0), in(1)};
+    for (int i = 0; i < 20; i++) {
+        divisors.push_back((T)rand());
+    }
+    for (T d : divisors) {
+        divisor.set(d);
+        Realization r = f.realize(size);
+        Buffer<T> q = r[0], m = r[1];
+        for (int i = 0; i < size; i++) {
+            T a = in(i);
+            if (t.is_int() && t.bits() == 32 && d == (T)-1 && a == in(0)) {
+                // The most negative int32 divided by -1 overflows in the
+                // reference.
+                continue;
+            }
+            T correct_q = reference_div(a, d), correct_m = reference_mod(a, d);
+            if (q(i) != correct_q || m(i) != correct_m) {
+                printf("%s: %lld / %lld = %lld, %lld %% %lld = %lld instead of %lld and %lld\n",
+                       type_to_c_type(t, false).c_str(),
+                       (long long)a, (long long)d, (long long)q(i),
+                       (long long)a, (long long)d, (long long)m(i),
+                       (long long)correct_q, (long long)correct_m);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int w : {1, 8, 16}) {
+        if (!test<uint8_t>(w) ||
+            !test<int8_t>(w) ||
+            !test<uint16_t>(w) ||
+            !test<int16_t>(w) ||
+            !test<uint32_t>(w) ||
+            !test<int32_t>(w)) {
+            return -1;
+        }
+    }
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Vectorized lookups in small tables are done with in-register
+// shuffles (e.g. pshufb or tbl), and in larger tables with gathers
+// where the target has them. Check they look up the right thing for a
+// range of table sizes, element types, and vector widths.
+template<typename T>
+bool test(int table_size, int min_index, int vector_width) {
+    const int size = 1024;
+    Buffer<T> table(min_index + table_size + 8);
+    table.for_each_element([&](int i) { table(i) = (T)(i * 37 + 11); });
+    Buffer<uint16_t> indices(size);
+    indices.for_each_element([&](int i) { indices(i) = (uint16_t)((i * 7919) % 997); });
+
+    Var x;
+    Func f;
+    f(x) = table(clamp(indices(x), min_index, min_index + table_size - 1));
+    f.vectorize(x, vector_width);
+    Buffer<T> out = f.realize(size);
+
+    for (int i = 0; i < size; i++) {
+        int idx = std::min(std::max((int)indices(i), min_index), min_index + table_size - 1);
+        if (out(i) != table(idx)) {
+            printf("Lookup of %d in a table of %d elements from %d with vector width %d "
+                   "gave %f instead of %f\n",
+                   indices(i), table_size, min_index, vector_width,
+                   (double)out(i), (double)table(idx));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int vector_width : {4, 8, 16, 32}) {
+        for (int table_size : {2, 16, 20, 32, 48, 64, 256}) {
+            for (int min_index : {0, 5}) {
+                if (!test<uint8_t>(table_size, min_index, vector_width) ||
+                    !test<int16_t>(table_size, min_index, vector_width) ||
+                    !test<int32_t>(table_size, min_index, vector_width) ||
+                    !test<float>(table_size, min_index, vector_width) ||
+                    !test<double>(table_size, min_index, vector_width)) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
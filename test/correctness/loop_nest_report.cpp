@@ -0,0 +1,101 @@
+#include "Halide.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+
+#include "test/common/halide_test_dirs.h"
+
+using namespace Halide;
+
+std::string read_file(const std::string &filename) {
+    Internal::assert_file_exists(filename);
+    std::ifstream file(filename);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+bool contains_all(const std::string &report, const std::vector<std::string> &expected) {
+    for (const std::string &e : expected) {
+        if (report.find(e) == std::string::npos) {
+            printf("Expected to find %s in the loop nest report:\n%s\n", e.c_str(), report.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 2, "input");
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+    f(x, y) = input(x, y) * 2;
+    g(x, y) = f(x, y) + f(x + 1, y);
+
+    f.compute_root();
+    g.vectorize(x, 8);
+
+    input.dim(0).set_estimate(0, 129).dim(1).set_estimate(0, 64);
+    g.output_buffer().dim(0).set_estimate(0, 128).dim(1).set_estimate(0, 64);
+
+    std::string result_file = Internal::get_test_tmp_dir() + "loop_nest_report.loop_nest.json";
+    Internal::ensure_no_file_exists(result_file);
+
+    g.compile_to({{Output::loop_nest_report, result_file}}, {input}, "loop_nest_report",
+                 get_host_target());
+
+    std::string report = read_file(result_file);
+    if (!contains_all(report, {
+                                  "\"kind\": \"produce\", \"name\": \"f\"",
+                                  "\"kind\": \"produce\", \"name\": \"g\"",
+                                  "\"kind\": \"allocate\", \"name\": \"f\"",
+                                  // g is 128 wide, vectorized by 8, so its inner loop runs 16 times a row.
+                                  "\"estimated_extent\": 16, \"estimated_trips\": 1024",
+                                  "\"vector_width\": 8",
+                              })) {
+        return -1;
+    }
+    if (report.find("measured_ms_per_run") != std::string::npos) {
+        printf("Found measured times with no profile:\n%s\n", report.c_str());
+        return -1;
+    }
+
+#ifndef _WIN32
+    // Measured times are merged in from a profiler snapshot. Times are
+    // in ns, per sampled run. Lines for other pipelines, and for Funcs
+    // that were never sampled, are ignored.
+    std::string profile_file = Internal::get_test_tmp_dir() + "loop_nest_report.profile.txt";
+    {
+        std::ofstream profile(profile_file);
+        profile << "halide_profiler_snapshot loop_nest_report f 3000000 4 2\n"
+                << "halide_profiler_snapshot loop_nest_report g 8000000 4 4\n"
+                << "halide_profiler_snapshot loop_nest_report input 5000000 4 0\n"
+                << "halide_profiler_snapshot another_pipeline f 7000000 1 1\n";
+    }
+    setenv("HL_LOOP_NEST_PROFILE", profile_file.c_str(), 1);
+
+    std::string profiled_file = Internal::get_test_tmp_dir() + "loop_nest_report_profiled.loop_nest.json";
+    Internal::ensure_no_file_exists(profiled_file);
+    g.compile_to({{Output::loop_nest_report, profiled_file}}, {input}, "loop_nest_report",
+                 get_host_target());
+    unsetenv("HL_LOOP_NEST_PROFILE");
+
+    std::string profiled = read_file(profiled_file);
+    if (!contains_all(profiled, {
+                                    "\"name\": \"f\"",
+                                    "\"measured_ms_per_run\": 1.5}",
+                                    "\"measured_ms_per_run\": 2}",
+                                })) {
+        return -1;
+    }
+    if (profiled.find("\"measured_ms_per_run\": 7}") != std::string::npos ||
+        profiled.find("\"measured_ms_per_run\": 5}") != std::string::npos) {
+        printf("Used a measured time from another pipeline or an unsampled Func:\n%s\n",
+               profiled.c_str());
+        return -1;
+    }
+#endif
+
+    printf("Success!\n");
+    return 0;
+}
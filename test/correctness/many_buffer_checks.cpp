@@ -0,0 +1,83 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string>
+
+// Pipelines with lots of inputs have hundreds of checks on their
+// buffers, which get checked together. Make sure the right error is
+// still reported.
+
+using namespace Halide;
+
+std::string error_msg;
+void my_error_handler(void *, const char *msg) {
+    error_msg = msg;
+}
+
+int main(int argc, char **argv) {
+    const int N = 48;
+    std::vector<ImageParam> inputs;
+    std::vector<Buffer<int>> buffers;
+    Var x, y;
+    Expr e = 0;
+    for (int i = 0; i < N; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "p%02d", i);
+        inputs.emplace_back(Int(32), 2, name);
+        e += inputs.back()(x, y);
+
+        buffers.emplace_back(16, 16);
+        buffers.back().fill(i);
+        inputs.back().set(buffers.back());
+    }
+    Func f;
+    f(x, y) = e;
+    f.set_error_handler(&my_error_handler);
+
+    Buffer<int> out = f.realize(16, 16);
+    if (!error_msg.empty()) {
+        printf("Unexpected error: %s\n", error_msg.c_str());
+        return -1;
+    }
+    const int correct = N * (N - 1) / 2;
+    for (int yi = 0; yi < 16; yi++) {
+        for (int xi = 0; xi < 16; xi++) {
+            if (out(xi, yi) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", xi, yi, out(xi, yi), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Make one of the last inputs too small.
+    Buffer<int> small(10, 16);
+    inputs[45].set(small);
+    f.realize(16, 16);
+    if (error_msg.find("Input buffer p45") == std::string::npos) {
+        printf("Expected an error about p45, got: %s\n", error_msg.c_str());
+        return -1;
+    }
+
+    // If more than one check fails, the first should be reported.
+    error_msg.clear();
+    inputs[3].set(small);
+    f.realize(16, 16);
+    if (error_msg.find("Input buffer p03") == std::string::npos) {
+        printf("Expected an error about p03, got: %s\n", error_msg.c_str());
+        return -1;
+    }
+
+    // And a different kind of failure in an early buffer should
+    // still be found.
+    error_msg.clear();
+    inputs[3].set(buffers[3]);
+    Buffer<int> wrong_dims(16, 16, 1);
+    inputs[1].set(wrong_dims);
+    f.realize(16, 16);
+    if (error_msg.find("Input buffer p01 requires a buffer of exactly 2 dimensions") == std::string::npos) {
+        printf("Expected an error about p01, got: %s\n", error_msg.c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// The memoization cache outlives JIT compilations. Redefining a
+// memoized Func under the same names, as is routine in an interactive
+// session, must not pick up the results cached for the old
+// definition.
+int main(int argc, char **argv) {
+    Var x, y;
+    for (int k = 1; k <= 3; k++) {
+        Func f("memoized"), g("memoize_redefined");
+        f(x, y) = x * k + y;
+        g(x, y) = f(x, y) + 1;
+        f.compute_root().memoize();
+
+        Buffer<int> result = g.realize(32, 32);
+        for (int y = 0; y < result.height(); y++) {
+            for (int x = 0; x < result.width(); x++) {
+                int correct = x * k + y + 1;
+                if (result(x, y) != correct) {
+                    printf("Definition %d: result(%d, %d) = %d instead of %d\n",
+                           k, x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Count the parallel loops launched.
+int par_for_count = 0;
+int counting_par_for(void *ctx, int (*f)(void *, int, uint8_t *), int min, int extent, uint8_t *closure) {
+    par_for_count++;
+    for (int i = min; i < min + extent; i++) {
+        f(ctx, i, closure);
+    }
+    return 0;
+}
+
+int check(const Buffer<int> &im, int (*correct)(int, int)) {
+    for (int y = 0; y < im.height(); y++) {
+        for (int x = 0; x < im.width(); x++) {
+            if (im(x, y) != correct(x, y)) {
+                printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct(x, y));
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_do_par_for().\n");
+        return 0;
+    }
+
+    Var x, y;
+
+    {
+        // A chain of root stages parallelized over rows, each of
+        // which reads the same row of the previous one. They should
+        // all run in one parallel loop.
+        Func f, g, h;
+        f(x, y) = x + y;
+        g(x, y) = f(x - 1, y) + f(x + 1, y);
+        h(x, y) = g(x, y) * 2 + f(x, y);
+        f.compute_root().parallel(y);
+        g.compute_root().parallel(y).vectorize(x, 4);
+        h.parallel(y);
+        h.set_custom_do_par_for(counting_par_for);
+
+        par_for_count = 0;
+        Buffer<int> im = h.realize(100, 50);
+        if (check(im, [](int x, int y) { return 4 * (x + y) + (x + y); })) {
+            return -1;
+        }
+        if (par_for_count != 1) {
+            printf("Expected 1 parallel loop, got %d\n", par_for_count);
+            return -1;
+        }
+    }
+
+    {
+        // Reading a different row of the producer prevents fusion.
+        Func f, g;
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) + f(x, y + 1);
+        f.compute_root().parallel(y);
+        g.parallel(y);
+        g.set_custom_do_par_for(counting_par_for);
+
+        par_for_count = 0;
+        Buffer<int> im = g.realize(100, 50);
+        if (check(im, [](int x, int y) { return 2 * (x + y) + 1; })) {
+            return -1;
+        }
+        if (par_for_count != 2) {
+            printf("Expected 2 parallel loops, got %d\n", par_for_count);
+            return -1;
+        }
+    }
+
+    {
+        // The producer covers more rows than the consumer needs,
+        // because another stage also uses it. The fused loop has to
+        // cover both.
+        Func f, g, h;
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + 1;
+        h(x, y) = g(x, y) + f(x, y + 10);
+        f.compute_root().parallel(y);
+        g.compute_root().parallel(y);
+        h.set_custom_do_par_for(counting_par_for);
+
+        par_for_count = 0;
+        Buffer<int> im = h.realize(100, 50);
+        if (check(im, [](int x, int y) { return x * y + 1 + x * (y + 10); })) {
+            return -1;
+        }
+        if (par_for_count != 1) {
+            printf("Expected 1 parallel loop, got %d\n", par_for_count);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "Halide.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // A histogram of a 2D image, reduced in parallel into private
+    // copies of the output.
+    {
+        const int W = 300, H = 203;
+        Buffer<uint8_t> in(W, H);
+        in.for_each_value([](uint8_t &v) { v = (uint8_t)(rand() & 0xff); });
+
+        Func hist("hist");
+        Var x("x"), u("u");
+        RDom r(0, W, 0, H);
+        hist(x) = 0;
+        hist(cast<int>(in(r.x, r.y))) += 1;
+
+        hist.compute_root();
+        hist.update().privatize(r.y, u, 7);
+
+        Buffer<int> out = hist.realize(256);
+
+        Buffer<int> correct(256);
+        correct.fill(0);
+        in.for_each_value([&](uint8_t v) { correct(v)++; });
+
+        for (int i = 0; i < 256; i++) {
+            if (out(i) != correct(i)) {
+                printf("hist(%d) = %d instead of %d\n", i, out(i), correct(i));
+                return -1;
+            }
+        }
+    }
+
+    // A Tuple-valued scatter reduction into a small output with a
+    // size that isn't a multiple of the vector width.
+    {
+        const int N = 10000, bins = 13;
+
+        Func f("f"), stats("stats");
+        Var x("x"), u("u");
+        RDom r(0, N);
+        f(x) = (x * x) % bins;
+        stats(x) = Tuple(0, 0);
+        stats(f(r)) = Tuple(stats(f(r))[0] + 1, max(stats(f(r))[1], r));
+
+        f.compute_root();
+        stats.compute_root();
+        stats.update().privatize(r, u, 4, 4);
+
+        Realization out = stats.realize(bins);
+        Buffer<int> count = out[0];
+        Buffer<int> last = out[1];
+
+        Buffer<int> correct_count(bins), correct_last(bins);
+        correct_count.fill(0);
+        correct_last.fill(0);
+        for (int i = 0; i < N; i++) {
+            int b = (i * i) % bins;
+            correct_count(b)++;
+            correct_last(b) = std::max(correct_last(b), i);
+        }
+
+        for (int i = 0; i < bins; i++) {
+            if (count(i) != correct_count(i) || last(i) != correct_last(i)) {
+                printf("stats(%d) = {%d, %d} instead of {%d, %d}\n",
+                       i, count(i), last(i), correct_count(i), correct_last(i));
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
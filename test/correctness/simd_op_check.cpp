@@ -236,6 +236,14 @@ public:
                 check("pabsw", 4 * w, abs(i16_1));
                 check("pabsd", 2 * w, abs(i32_1));
             }
+
+            // Lookups in small tables
+            for (int w = 2; w <= 4; w++) {
+                check("pshufb", 8 * w, in_u8(clamp(u16_1, 0, 15)));
+                check("pshufb", 8 * w, in_u8(clamp(u16_1, 0, 63)));
+                check("pshufb", 4 * w, in_u16(clamp(u16_1, 0, 31)));
+                check("pshufb", 2 * w, in_f32(clamp(u16_1, 0, 15)));
+            }
         }
 
         // SSE 4.1
@@ -377,6 +385,10 @@ public:
             check("vpcmp*d*ymm", 8, select(u32_1 == u32_2, u32(1), u32(2)));
             check("vpcmp*d*ymm", 8, select(u32_1 > u32_2, u32(1), u32(2)));
 
+            check("vpgatherdd", 8, in_i32(u8_1));
+            check("vpgatherdd", 16, in_u32(u8_1));
+            check("vgatherdps", 8, in_f32(u8_1));
+
             check("vpavgb*ymm", 32, u8((u16(u8_1) + u16(u8_2) + 1) / 2));
             check("vpavgw*ymm", 16, u16((u32(u16_1) + u32(u16_2) + 1) / 2));
             check("vpmaxsw*ymm", 16, max(i16_1, i16_2));
@@ -1215,6 +1227,12 @@ public:
         // VTBL X       -       Table Lookup
         // Arm's version of shufps. Allows for arbitrary permutations of a
         // 64-bit vector. We typically use vrev variants instead.
+        // We do use it for lookups in small tables.
+        for (int w = 1; w <= 4; w++) {
+            check(arm32 ? "vtbl.8" : "tbl", 8 * w, in_u8(clamp(u16_1, 0, 15)));
+            check(arm32 ? "vtbl.8" : "tbl", 8 * w, in_u8(clamp(u16_1, 0, 31)));
+            check(arm32 ? "vtbl.8" : "tbl", 4 * w, in_u16(clamp(u16_1, 0, 15)));
+        }
 
         // VTBX X       -       Table Extension
         // Like vtbl, but doesn't change any elements where the index was
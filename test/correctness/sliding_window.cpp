@@ -1,4 +1,5 @@
 #include "Halide.h"
+#include <atomic>
 #include <stdio.h>
 
 using namespace Halide;
@@ -16,6 +17,13 @@ extern "C" DLLEXPORT int call_counter(int x, int y) {
 }
 HalideExtern_2(int, call_counter, int, int);
 
+std::atomic<int> parallel_count;
+extern "C" DLLEXPORT int parallel_call_counter(int x, int y) {
+    parallel_count++;
+    return x + y;
+}
+HalideExtern_2(int, parallel_call_counter, int, int);
+
 extern "C" void *my_malloc(void *, size_t x) {
     printf("Malloc wasn't supposed to be called!\n");
     exit(-1);
@@ -24,6 +32,25 @@ extern "C" void *my_malloc(void *, size_t x) {
 extern "C" void my_free(void *, void *) {
 }
 
+// Counts the allocations made by parallel tasks, and the largest one.
+std::atomic<int> strip_allocations;
+std::atomic<size_t> largest_strip_allocation;
+
+void *strip_malloc(void *, size_t x) {
+    strip_allocations++;
+    size_t largest = largest_strip_allocation;
+    while (x > largest && !largest_strip_allocation.compare_exchange_weak(largest, x)) {
+    }
+    void *orig = malloc(x + 32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void strip_free(void *, void *ptr) {
+    free(((void **)ptr)[-1]);
+}
+
 int main(int argc, char **argv) {
     Var x, y;
 
@@ -221,6 +248,55 @@ int main(int argc, char **argv) {
         }
     }
 
+    {
+        // Sliding within parallel strips when the storage is outside
+        // the parallel loop. Each strip should warm up its own window
+        // once and then slide, in its own folded buffer.
+        Var yo, yi;
+        Func f, g;
+
+        f(x, y) = parallel_call_counter(x, y);
+        g(x, y) = f(x, y - 1) + f(x, y) + f(x, y + 1);
+
+        g.split(y, yo, yi, 16).parallel(yo);
+        f.store_root().compute_at(g, yi).store_per_parallel_task();
+
+        parallel_count = 0;
+        strip_allocations = 0;
+        largest_strip_allocation = 0;
+        g.set_custom_allocator(strip_malloc, strip_free);
+        Buffer<int> im = g.realize(10, 64);
+
+        // Four strips, each computing 16 rows plus two rows of overlap
+        int correct = 4 * 18 * 10;
+        if (parallel_count != correct) {
+            printf("f was called %d times instead of %d times\n", (int)parallel_count, correct);
+            return -1;
+        }
+
+        // One buffer per strip, folded down to the four rows the
+        // stencil needs rather than the 66 rows of a shared one.
+        if (strip_allocations != 4) {
+            printf("f was allocated %d times instead of once per strip\n", (int)strip_allocations);
+            return -1;
+        }
+        size_t folded_size = 10 * 4 * sizeof(int) + sizeof(int);
+        if (largest_strip_allocation > folded_size) {
+            printf("f's storage for a strip was %d bytes instead of at most %d\n",
+                   (int)largest_strip_allocation, (int)folded_size);
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                if (im(x, y) != 3 * (x + y)) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), 3 * (x + y));
+                    return -1;
+                }
+            }
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "Halide.h"
+#include <algorithm>
 #include <stdio.h>
 
 using namespace Halide;
@@ -19,6 +20,25 @@ void my_free(void *user_context, void *ptr) {
     free(((void **)ptr)[-1]);
 }
 
+// Count the allocations of a Func in the lowered code
+class CountAllocations : public Internal::IRMutator {
+    using Internal::IRMutator::visit;
+
+    Internal::Stmt visit(const Internal::Allocate *op) override {
+        if (op->name == name) {
+            count++;
+        }
+        return Internal::IRMutator::visit(op);
+    }
+
+public:
+    std::string name;
+    int count = 0;
+    CountAllocations(const std::string &name)
+        : name(name) {
+    }
+};
+
 #ifdef _WIN32
 #define DLLEXPORT __declspec(dllexport)
 #else
@@ -541,6 +561,96 @@ int main(int argc, char **argv) {
         Buffer<int> im = output.realize(64, 64);
     }
 
+    {
+        // A blur with a radius only known at runtime. The footprint
+        // isn't bounded by a constant, but it is bounded by an
+        // expression of the radius, so we should still fold with a
+        // fold factor computed at runtime.
+        Func f, g;
+        Param<int> radius;
+        RDom r(-radius, 2 * radius + 1);
+
+        f(x, y) = x + y;
+        g(x, y) = sum(f(x, y + r));
+        f.store_root().compute_at(g, y);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        for (int rad = 1; rad <= 5; rad++) {
+            radius.set(rad);
+            custom_malloc_size = 0;
+            Buffer<int> im = g.realize(100, 1000);
+
+            for (int y = 0; y < im.height(); y++) {
+                for (int x = 0; x < im.width(); x++) {
+                    int correct = (2 * rad + 1) * (x + y);
+                    if (im(x, y) != correct) {
+                        printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+
+            int fold = 1;
+            while (fold < 2 * rad + 1) {
+                fold *= 2;
+            }
+            size_t expected_size = 100 * fold * sizeof(int) + sizeof(int);
+            if (custom_malloc_size == 0 || custom_malloc_size != expected_size) {
+                printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)expected_size);
+                return -1;
+            }
+        }
+
+        // The fold factor is never more than the unfolded extent of
+        // f, which is 10 + 2 * radius rows here.
+        for (int rad = 8; rad <= 10; rad++) {
+            radius.set(rad);
+            custom_malloc_size = 0;
+            Buffer<int> im = g.realize(100, 10);
+            int fold = 1;
+            while (fold < 2 * rad + 1) {
+                fold *= 2;
+            }
+            fold = std::min(fold, 10 + 2 * rad);
+            size_t expected_size = 100 * fold * sizeof(int) + sizeof(int);
+            if (custom_malloc_size != expected_size) {
+                printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)expected_size);
+                return -1;
+            }
+            for (int y = 0; y < im.height(); y++) {
+                for (int x = 0; x < im.width(); x++) {
+                    int correct = (2 * rad + 1) * (x + y);
+                    if (im(x, y) != correct) {
+                        printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        // A fold factor computed at runtime can't be rounded up to a
+        // power of two once the bound on the footprint reaches 2^30,
+        // and folding by the whole extent saves nothing, so the
+        // realization also has an unfolded version to run instead.
+        Func f, g;
+        Param<int> radius;
+        RDom r(-radius, 2 * radius + 1);
+        f(x, y) = x + y;
+        g(x, y) = sum(f(x, y + r));
+        f.store_root().compute_at(g, y);
+
+        CountAllocations *counter = new CountAllocations(f.name());
+        g.add_custom_lowering_pass(counter);
+        g.compile_jit();
+        if (counter->count != 2) {
+            printf("Expected a folded and an unfolded allocation of f, got %d allocations\n", counter->count);
+            return -1;
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,94 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Counts the loads of a buffer, and the interleaves of them, in the
+// lowered code.
+class CountTransposeOps : public IRMutator {
+    using IRMutator::visit;
+
+    Expr visit(const Load *op) override {
+        if (op->name == buffer) {
+            const Ramp *r = op->index.as<Ramp>();
+            if (r && is_one(r->stride)) {
+                dense_loads++;
+            } else {
+                other_loads++;
+            }
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Shuffle *op) override {
+        if (op->is_interleave() && (int)op->vectors.size() == block) {
+            interleaves++;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    std::string buffer;
+    int block;
+    int dense_loads = 0, other_loads = 0, interleaves = 0;
+    CountTransposeOps(const std::string &buffer, int block)
+        : buffer(buffer), block(block) {
+    }
+};
+
+// A transpose vectorized in one dimension and unrolled in the other
+// is done with dense loads and a transpose in registers. Check it for
+// a range of types and block sizes.
+template<typename T>
+bool test(int block) {
+    Buffer<T> in(131, 100);
+    in.for_each_element([&](int x, int y) { in(x, y) = (T)(x * 3 + y * 17); });
+
+    Func out;
+    Var x, y, xi, yi;
+    out(x, y) = in(y, x);
+    out.tile(x, y, xi, yi, block, block).vectorize(xi).unroll(yi);
+
+    // The strided loads of the columns of each block should have
+    // become one dense load per row and a single interleave.
+    CountTransposeOps *counter = new CountTransposeOps(in.name(), block);
+    out.add_custom_lowering_pass(counter);
+    out.compile_jit();
+    if (counter->dense_loads != block ||
+        counter->other_loads != 0 ||
+        counter->interleaves != 1) {
+        printf("Transposing %d x %d blocks: %d dense loads, %d other loads, and %d interleaves "
+               "instead of %d, 0, and 1\n",
+               block, block, counter->dense_loads, counter->other_loads,
+               counter->interleaves, block);
+        return false;
+    }
+
+    Buffer<T> result = out.realize(96, 128);
+    for (int y = 0; y < result.height(); y++) {
+        for (int x = 0; x < result.width(); x++) {
+            if (result(x, y) != in(y, x)) {
+                printf("Transposing %d x %d blocks: out(%d, %d) = %f instead of %f\n",
+                       block, block, x, y, (double)result(x, y), (double)in(y, x));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int block : {4, 8, 16}) {
+        if (!test<uint8_t>(block) ||
+            !test<int16_t>(block) ||
+            !test<int32_t>(block) ||
+            !test<float>(block) ||
+            !test<double>(block)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
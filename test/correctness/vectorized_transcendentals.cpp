@@ -0,0 +1,95 @@
+#include "Halide.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+using namespace Halide;
+
+// Vectorized sin, cos, tan, atan2 and tanh don't call libm. Check that
+// Halide's versions are as accurate as documented, including for large
+// arguments.
+
+double ulp_error(float actual, double correct) {
+    float rounded = (float)correct;
+    if (actual == rounded) {
+        return 0;
+    }
+    int exponent;
+    std::frexp(rounded, &exponent);
+    double ulp = std::ldexp(1.0, std::max(exponent, -125) - 24);
+    return std::fabs(actual - correct) / ulp;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.has_feature(Target::StrictFloat)) {
+        printf("[SKIP] Vectorized transcendentals call libm with strict_float.\n");
+        return 0;
+    }
+
+    const int size = 1 << 16;
+    Buffer<float> in_x(size), in_y(size);
+    for (int i = 0; i < size; i++) {
+        // A dense sweep of x, and a sweep of y in the other direction.
+        in_x(i) = -100.0f + 200.0f * i / size;
+        in_y(i) = 10.0f - 20.0f * i / size;
+    }
+    // Large arguments, some in the same vectors as small ones, for the
+    // fallback to libm in sin, cos and tan.
+    for (int i = size - 1024, k = 0; i < size; i++, k++) {
+        float sign = (k & 1) ? -1.0f : 1.0f;
+        in_x(i) = (k % 3 == 0) ? sign * 1.5f : sign * 8000.0f * std::pow(1.02f, (float)(k / 2));
+    }
+    in_x(size - 1) = 1e6f;
+    in_x(size - 2) = -1e7f;
+    // Edge cases for atan2. Halide assumes there are no infinities or
+    // signed zeros, so don't test those.
+    float special[][2] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, -1.0f}, {50.0f, -50.0f}, {-50.0f, -50.0f}, {1e-20f, 1.0f}, {-1e-20f, -1.0f}};
+    for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        in_x(i) = special[i][0];
+        in_y(i) = special[i][1];
+    }
+
+    Var x;
+    Func f;
+    f(x) = Tuple(sin(in_x(x)), cos(in_x(x)), tan(in_x(x)), atan2(in_x(x), in_y(x)), tanh(in_x(x)));
+    f.vectorize(x, 8);
+    Realization r = f.realize(size, target);
+
+    struct {
+        const char *name;
+        double max_ulp;
+    } functions[] = {{"sin", 3}, {"cos", 3}, {"tan", 4}, {"atan2", 4}, {"tanh", 2}};
+    for (int j = 0; j < 5; j++) {
+        Buffer<float> result = r[j];
+        for (int i = 0; i < size; i++) {
+            double a = in_x(i), b = in_y(i);
+            double correct;
+            switch (j) {
+            case 0:
+                correct = std::sin(a);
+                break;
+            case 1:
+                correct = std::cos(a);
+                break;
+            case 2:
+                correct = std::tan(a);
+                break;
+            case 3:
+                correct = std::atan2(a, b);
+                break;
+            default:
+                correct = std::tanh(a);
+            }
+            double error = ulp_error(result(i), correct);
+            if (error > functions[j].max_ulp) {
+                printf("%s(%.9g, %.9g) = %.9g instead of %.9g (%f ulp)\n",
+                       functions[j].name, a, b, result(i), correct, error);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
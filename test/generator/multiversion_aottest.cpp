@@ -0,0 +1,97 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "multiversion.h"
+
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace Halide::Runtime;
+
+std::atomic<int> can_use_count;
+int can_use_answer = 0;
+
+int my_can_use_target_features(int count, const uint64_t *features) {
+    can_use_count++;
+    can_use_answer = halide_default_can_use_target_features(count, features);
+    return can_use_answer;
+}
+
+// The "multiversion ..." trace tags, one per production of output.
+std::vector<std::string> versions_run;
+
+int32_t my_trace(void *user_context, const halide_trace_event_t *e) {
+    if (e->event == halide_trace_tag && strncmp(e->trace_tag, "multiversion", 12) == 0) {
+        versions_run.push_back(e->trace_tag);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    halide_set_custom_can_use_target_features(my_can_use_target_features);
+    halide_set_custom_trace(my_trace);
+
+    const int W = 100, H = 40;
+    Buffer<float> input(W + 2, H + 2);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = (float)((x * 3 + y * 5) % 17);
+    });
+
+    for (int i = 0; i < 3; i++) {
+        Buffer<float> output(W, H);
+        int result = multiversion(input, output);
+        if (result != 0) {
+            printf("Pipeline failed: %d\n", result);
+            return -1;
+        }
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                float blur_x[3];
+                for (int j = 0; j < 3; j++) {
+                    blur_x[j] = (input(x, y + j) + input(x + 1, y + j) + input(x + 2, y + j)) / 3;
+                }
+                float correct = (blur_x[0] + blur_x[1] + blur_x[2]) / 3;
+                if (fabs(output(x, y) - correct) > 1e-4f) {
+                    printf("output(%d, %d) = %f instead of %f\n", x, y, output(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Whichever version ran, the runtime should only have been asked
+    // once: the answer is cached.
+    if (can_use_count > 1) {
+        printf("halide_can_use_target_features was called %d times\n", can_use_count.load());
+        return -1;
+    }
+
+    // The generator only multiversions on x86, and then the runtime
+    // must have been asked. If the CPU has the extra features, every
+    // run should have used that version, and otherwise the base one.
+    if (can_use_count == 0) {
+        if (!versions_run.empty()) {
+            printf("A version was reported (%s) without checking the CPU\n", versions_run[0].c_str());
+            return -1;
+        }
+    } else {
+        if (versions_run.size() != 3) {
+            printf("Expected 3 productions of output to report a version, not %d\n", (int)versions_run.size());
+            return -1;
+        }
+        for (const std::string &v : versions_run) {
+            const bool ran_extended = (v != "multiversion");
+            if (ran_extended != (can_use_answer != 0)) {
+                printf("The CPU %s the extra features, but \"%s\" ran\n",
+                       can_use_answer ? "has" : "lacks", v.c_str());
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "Halide.h"
+
+namespace {
+
+class Multiversion : public Halide::Generator<Multiversion> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        blur_x(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+        output(x, y) = (blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) / 3;
+    }
+
+    void schedule() {
+        blur_x.compute_at(output, y).vectorize(x, 16);
+        output.vectorize(x, 16);
+
+        // Tracing tells the test which version ran.
+        Func(output).trace_realizations();
+
+        // Add a version for features the target doesn't already
+        // have, so that there's always a dispatch to test.
+        const Target t = get_target();
+        if (t.arch == Target::X86) {
+            if (!t.has_feature(Target::AVX2)) {
+                output.multiversion(std::vector<Target::Feature>{Target::AVX, Target::AVX2, Target::FMA});
+            } else {
+                output.multiversion(std::vector<Target::Feature>{Target::AVX512_Skylake});
+            }
+        }
+    }
+
+private:
+    Var x{"x"}, y{"y"};
+    Func blur_x{"blur_x"};
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(Multiversion, multiversion)
@@ -0,0 +1,86 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "param_profile.h"
+
+#include <stdio.h>
+#include <string>
+
+using namespace Halide::Runtime;
+
+std::string report;
+
+void my_halide_print(void *user_context, const char *str) {
+    report += str;
+}
+
+int run(int width, int height, int offset) {
+    Buffer<int> input(width, height), output(width, height);
+    input.fill(3);
+    int result = param_profile(input, offset, 2.0f, output);
+    if (result != 0) {
+        printf("Pipeline failed: %d\n", result);
+        return -1;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (output(x, y) != 6 + offset) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), 6 + offset);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+bool reported(const std::string &line) {
+    if (report.find(line + "\n") == std::string::npos) {
+        printf("Expected \"%s\" in the report:\n%s", line.c_str(), report.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    halide_param_profile_reset();
+
+    for (int i = 0; i < 3; i++) {
+        if (run(64, 32, 7)) return -1;
+    }
+    if (run(16, 8, 7)) return -1;
+    if (run(16, 8, -1)) return -1;
+
+    // A bounds query shouldn't be recorded.
+    Buffer<int> query_in((int *)nullptr, 0, 0), query_out((int *)nullptr, 64, 32);
+    if (param_profile(query_in, 100, 1.0f, query_out) != 0) {
+        printf("Bounds query failed\n");
+        return -1;
+    }
+
+    halide_set_custom_print(&my_halide_print);
+    halide_param_profile_report(nullptr);
+
+    if (!reported("halide_param_profile param_profile offset 4 7") ||
+        !reported("halide_param_profile param_profile offset 1 -1") ||
+        !reported("halide_param_profile param_profile input.shape 3 64 32 64") ||
+        !reported("halide_param_profile param_profile input.shape 2 16 8 16") ||
+        !reported("halide_param_profile param_profile output.shape 3 64 32 64") ||
+        !reported("halide_param_profile param_profile output.shape 2 16 8 16")) {
+        return -1;
+    }
+    if (report.find("scale") != std::string::npos ||
+        report.find(" 100\n") != std::string::npos) {
+        printf("Unexpected entries in the report:\n%s", report.c_str());
+        return -1;
+    }
+
+    halide_param_profile_reset();
+    report.clear();
+    halide_param_profile_report(nullptr);
+    if (!report.empty()) {
+        printf("Expected an empty report after a reset:\n%s", report.c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "Halide.h"
+
+namespace {
+
+class ParamProfile : public Halide::Generator<ParamProfile> {
+public:
+    Input<Buffer<int>> input{"input", 2};
+    Input<int> offset{"offset"};
+    Input<float> scale{"scale"};
+    Output<Buffer<int>> output{"output", 2};
+
+    void generate() {
+        output(x, y) = cast<int>(input(x, y) * scale) + offset;
+    }
+
+private:
+    Var x{"x"}, y{"y"};
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ParamProfile, param_profile)
@@ -0,0 +1,53 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "param_profile_specialized.h"
+
+#include <stdio.h>
+
+using namespace Halide::Runtime;
+
+int run(int width, int height, int offset) {
+    Buffer<int> input(width, height), output(width, height);
+    input.fill(3);
+    int result = param_profile_specialized(input, offset, output);
+    if (result != 0) {
+        printf("Pipeline failed: %d\n", result);
+        return -1;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (output(x, y) != 6 + offset) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), 6 + offset);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // The generator was built with specialization_profile set to
+    // param_profile_specialized.txt, in which the hot output shape is
+    // 64x32 and the hot offsets are 7 and 5 (but not -1). That gives
+    // path 0 for the shape, paths 1 and 2 for the offsets, and path 3
+    // for everything else.
+    halide_shape_dispatch_reset(nullptr);
+
+    if (run(64, 32, -1)) return -1;  // path 0: the shape wins
+    if (run(16, 8, 7)) return -1;    // path 1
+    if (run(16, 8, 5)) return -1;    // path 2
+    if (run(20, 8, 5)) return -1;    // path 2
+    if (run(16, 8, -1)) return -1;   // generic: cold value
+    if (run(16, 8, 3)) return -1;    // generic: only hot for another pipeline
+
+    uint64_t counts[5];
+    int paths = halide_shape_dispatch_counts(nullptr, "param_profile_specialized", counts, 5);
+    if (paths != 4 || counts[0] != 1 || counts[1] != 1 || counts[2] != 2 || counts[3] != 2) {
+        printf("Unexpected dispatch counts: %d paths, %d %d %d %d\n",
+               paths, (int)counts[0], (int)counts[1], (int)counts[2], (int)counts[3]);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
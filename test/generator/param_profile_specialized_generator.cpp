@@ -0,0 +1,21 @@
+#include "Halide.h"
+
+namespace {
+
+class ParamProfileSpecialized : public Halide::Generator<ParamProfileSpecialized> {
+public:
+    Input<Buffer<int>> input{"input", 2};
+    Input<int> offset{"offset"};
+    Output<Buffer<int>> output{"output", 2};
+
+    void generate() {
+        output(x, y) = input(x, y) * 2 + offset;
+    }
+
+private:
+    Var x{"x"}, y{"y"};
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ParamProfileSpecialized, param_profile_specialized)
@@ -0,0 +1,101 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "profiler_sampling.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace Halide::Runtime;
+
+std::string report;
+
+void my_halide_print(void *user_context, const char *str) {
+    report += str;
+}
+
+int main(int argc, char **argv) {
+    halide_profiler_reset();
+    halide_profiler_set_sampling_period(4);
+
+    Buffer<float> input(65, 32), output(64, 32);
+    input.fill(3.0f);
+    for (int i = 0; i < 10; i++) {
+        if (profiler_sampling(input, output) != 0) {
+            printf("Pipeline failed\n");
+            return -1;
+        }
+    }
+    for (int y = 0; y < output.height(); y++) {
+        for (int x = 0; x < output.width(); x++) {
+            float correct = sqrtf(3.0f) + 1;
+            if (output(x, y) != correct) {
+                printf("output(%d, %d) = %f instead of %f\n", x, y, output(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Runs 0, 4 and 8 are sampled.
+    int count = halide_profiler_snapshot(nullptr, 0);
+    if (count < 2) {
+        printf("Expected at least two Funcs in the snapshot, got %d\n", count);
+        return -1;
+    }
+    std::vector<halide_profiler_func_snapshot> entries(count);
+    if (halide_profiler_snapshot(entries.data(), count) != count) {
+        printf("Snapshot size changed\n");
+        return -1;
+    }
+    bool found_blurred = false, found_output = false;
+    for (const auto &e : entries) {
+        if (std::string(e.pipeline_name) != "profiler_sampling") {
+            printf("Unexpected pipeline %s\n", e.pipeline_name);
+            return -1;
+        }
+        if (e.runs != 10 || e.sampled_runs != 3) {
+            printf("%s: runs = %d, sampled_runs = %d instead of 10 and 3\n",
+                   e.func_name, e.runs, e.sampled_runs);
+            return -1;
+        }
+        std::string name = e.func_name;
+        found_blurred |= name == "blurred";
+        found_output |= name == "output";
+    }
+    if (!found_blurred || !found_output) {
+        printf("Missing Funcs in the snapshot\n");
+        return -1;
+    }
+
+    // Runs that aren't sampled skip all of the profiler's
+    // instrumentation, including its accounting of blurred's
+    // allocation.
+    halide_profiler_pipeline_stats *stats = nullptr;
+    for (halide_profiler_pipeline_stats *p = halide_profiler_get_state()->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)p->next) {
+        if (std::string(p->name) == "profiler_sampling") {
+            stats = p;
+        }
+    }
+    if (!stats || stats->num_allocs != 3) {
+        printf("Expected allocations to be tracked in 3 runs, got %d\n", stats ? stats->num_allocs : -1);
+        return -1;
+    }
+
+    halide_print_t old_print = halide_set_custom_print(my_halide_print);
+    halide_profiler_snapshot_report(nullptr);
+    if (report.find("halide_profiler_snapshot profiler_sampling blurred ") == std::string::npos ||
+        report.find(" 10 3\n") == std::string::npos) {
+        halide_set_custom_print(old_print);
+        printf("Unexpected snapshot report:\n%s", report.c_str());
+        return -1;
+    }
+    halide_set_custom_print(old_print);
+
+    halide_profiler_set_sampling_period(1);
+    halide_profiler_reset();
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "Halide.h"
+
+namespace {
+
+class ProfilerSampling : public Halide::Generator<ProfilerSampling> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        blurred(x, y) = (input(x, y) + input(x + 1, y)) / 2;
+        output(x, y) = sqrt(blurred(x, y)) + 1;
+    }
+
+    void schedule() {
+        blurred.compute_root();
+    }
+
+private:
+    Var x{"x"}, y{"y"};
+    Func blurred{"blurred"};
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ProfilerSampling, profiler_sampling)
@@ -0,0 +1,74 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "shape_specialization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+using namespace Halide::Runtime;
+
+int clamp(int x, int lo, int hi) {
+    return std::min(std::max(x, lo), hi);
+}
+
+int check(const Buffer<uint8_t> &input, const Buffer<uint8_t> &output) {
+    const int W = input.width(), H = input.height();
+    auto in = [&](int x, int y) {
+        return (int)input(clamp(x, 0, W - 1), clamp(y, 0, H - 1));
+    };
+    auto blur_x = [&](int x, int y) {
+        return (in(x - 1, y) + 2 * in(x, y) + in(x + 1, y) + 2) / 4;
+    };
+    for (int y = 0; y < output.height(); y++) {
+        for (int x = 0; x < output.width(); x++) {
+            int correct = (blur_x(x, y - 1) + 2 * blur_x(x, y) + blur_x(x, y + 1) + 2) / 4;
+            if (output(x, y) != correct) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Run the pipeline on an output of the given size, with rows padded
+// out to the given stride.
+int run(int width, int height, int stride) {
+    Buffer<uint8_t> input(width, height);
+    input.for_each_value([](uint8_t &v) { v = (uint8_t)rand(); });
+
+    halide_dimension_t shape[2] = {{0, width, 1}, {0, height, stride}};
+    Buffer<uint8_t> storage(stride, height);
+    Buffer<uint8_t> output(storage.data(), 2, shape);
+
+    int result = shape_specialization(input, output);
+    if (result != 0) {
+        printf("pipeline failed: %d\n", result);
+        return -1;
+    }
+    return check(input, output);
+}
+
+int main(int argc, char **argv) {
+    // The generator was built with shape_specializations=64x32,128x64:160
+    halide_shape_dispatch_reset(nullptr);
+
+    if (run(64, 32, 64)) return -1;    // path 0
+    if (run(64, 32, 64)) return -1;    // path 0
+    if (run(128, 64, 160)) return -1;  // path 1
+    if (run(128, 64, 128)) return -1;  // generic: wrong stride
+    if (run(100, 50, 100)) return -1;  // generic
+    if (run(100, 50, 112)) return -1;  // generic
+
+    uint64_t counts[4];
+    int paths = halide_shape_dispatch_counts(nullptr, "shape_specialization", counts, 4);
+    if (paths != 3 || counts[0] != 2 || counts[1] != 1 || counts[2] != 3) {
+        printf("Unexpected dispatch counts: %d paths, %d %d %d\n",
+               paths, (int)counts[0], (int)counts[1], (int)counts[2]);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
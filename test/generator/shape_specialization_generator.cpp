@@ -0,0 +1,27 @@
+#include "Halide.h"
+
+namespace {
+
+class ShapeSpecialization : public Halide::Generator<ShapeSpecialization> {
+public:
+    Input<Buffer<uint8_t>> input{"input", 2};
+    Output<Buffer<uint8_t>> output{"output", 2};
+
+    void generate() {
+        Func clamped = Halide::BoundaryConditions::repeat_edge(input);
+        Func in16, blur_x;
+        in16(x, y) = cast<uint16_t>(clamped(x, y));
+        blur_x(x, y) = (in16(x - 1, y) + 2 * in16(x, y) + in16(x + 1, y) + 2) / 4;
+        output(x, y) = cast<uint8_t>((blur_x(x, y - 1) + 2 * blur_x(x, y) + blur_x(x, y + 1) + 2) / 4);
+
+        blur_x.compute_at(output, y).vectorize(x, 8, TailStrategy::GuardWithIf);
+        output.vectorize(x, 8, TailStrategy::GuardWithIf);
+    }
+
+private:
+    Var x{"x"}, y{"y"};
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ShapeSpecialization, shape_specialization)
@@ -6,6 +6,7 @@
 
 using namespace Halide;
 using namespace Halide::Tools;
+using namespace Halide::Internal;
 
 enum {
     scalar_trans,
@@ -111,6 +112,69 @@ Buffer<uint16_t> test_transpose_wrap(int mode) {
     return result;
 }
 
+/* A transpose vectorized in x and unrolled in y is recognized, and
+ * done with dense loads of the rows of each block and a transpose in
+ * registers, without staging the blocks in other Funcs. */
+// Counts strided loads, and interleaves of eight vectors, in the
+// lowered code.
+class CountStridedLoads : public IRMutator {
+    using IRMutator::visit;
+
+    Expr visit(const Load *op) override {
+        const Ramp *r = op->index.as<Ramp>();
+        if (r && !is_one(r->stride)) {
+            strided_loads++;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Shuffle *op) override {
+        if (op->is_interleave() && op->vectors.size() == 8) {
+            interleaves++;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    int strided_loads = 0, interleaves = 0;
+};
+
+Buffer<uint16_t> test_transpose_direct() {
+    Func input, output;
+    Var x, y;
+
+    input(x, y) = cast<uint16_t>(x + y);
+    input.compute_root();
+
+    output(x, y) = input(y, x);
+
+    Var xi, yi;
+    output.tile(x, y, xi, yi, 8, 8).vectorize(xi).unroll(yi);
+    output.compile_to_assembly(Internal::get_test_tmp_dir() + "direct_transpose.s", std::vector<Argument>());
+
+    // The block should be transposed in registers, not loaded with
+    // strided loads.
+    CountStridedLoads *counter = new CountStridedLoads;
+    output.add_custom_lowering_pass(counter);
+    output.compile_jit();
+    if (counter->strided_loads != 0 || counter->interleaves != 1) {
+        printf("Direct version has %d strided loads and %d interleaves instead of 0 and 1\n",
+               counter->strided_loads, counter->interleaves);
+        return Buffer<uint16_t>();
+    }
+
+    Buffer<uint16_t> result(1024, 1024);
+
+    output.realize(result);
+
+    double t = benchmark([&]() {
+        output.realize(result);
+    });
+
+    std::cout << "Direct version: Transpose in registers bandwidth " << 1024 * 1024 / t << " byte/s.\n";
+    return result;
+}
+
 int main(int argc, char **argv) {
     test_transpose(scalar_trans);
     test_transpose_wrap(scalar_trans);
@@ -119,8 +183,12 @@ int main(int argc, char **argv) {
 
     Buffer<uint16_t> im1 = test_transpose(vec_x_trans);
     Buffer<uint16_t> im2 = test_transpose_wrap(vec_x_trans);
+    Buffer<uint16_t> im3 = test_transpose_direct();
+    if (!im3.defined()) {
+        return -1;
+    }
 
-    // Check correctness of the wrapper version
+    // Check correctness of the wrapper and direct versions
     for (int y = 0; y < im2.height(); y++) {
         for (int x = 0; x < im2.width(); x++) {
             if (im2(x, y) != im1(x, y)) {
@@ -128,6 +196,11 @@ int main(int argc, char **argv) {
                        x, y, im2(x, y), im1(x, y));
                 return -1;
             }
+            if (im3(x, y) != im1(x, y)) {
+                printf("direct(%d, %d) = %d instead of %d\n",
+                       x, y, im3(x, y), im1(x, y));
+                return -1;
+            }
         }
     }
 
@@ -22,10 +22,14 @@ int main(int argc, char **argv) {
     sin_ref.vectorize(x, 8);
     cos_ref.vectorize(x, 8);
 
+    // Vectorized sin and cos use Halide's own implementations, unless
+    // strict_float asks for libm's.
+    Target libm_target = get_jit_target_from_environment().with_feature(Target::StrictFloat);
+
     double t1 = 1e6 * benchmark([&]() { sin_f.realize(1000); });
     double t2 = 1e6 * benchmark([&]() { cos_f.realize(1000); });
-    double t3 = 1e6 * benchmark([&]() { sin_ref.realize(1000); });
-    double t4 = 1e6 * benchmark([&]() { cos_ref.realize(1000); });
+    double t3 = 1e6 * benchmark([&]() { sin_ref.realize(1000, libm_target); });
+    double t4 = 1e6 * benchmark([&]() { cos_ref.realize(1000, libm_target); });
 
     printf("sin: %f ns per pixel\n"
            "fast_sine: %f ns per pixel\n"
@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <cstdio>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// A memory-bound 3x3 blur, stored in float32, float16 and
+// bfloat16. The 16-bit versions move half as much memory, so with
+// fast conversions they should keep up with float32.
+template<typename T>
+double blur_time(Buffer<float> &result) {
+    const int W = 2048, H = 2048;
+    Buffer<T> in(W + 2, H + 2), out(W, H);
+    in.for_each_element([&](int x, int y) {
+        in(x, y) = T((float)((x * 17 + y * 31) % 256) / 256.0f);
+    });
+
+    Target target = get_jit_target_from_environment();
+    Var x, y, xi, yi;
+    Func blur_x, blur_y;
+    blur_x(x, y) = (in(x, y) + in(x + 1, y) + in(x + 2, y)) * T(1.0f / 3);
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) * T(1.0f / 3);
+
+    const int vec = target.natural_vector_size<float>();
+    blur_y.tile(x, y, xi, yi, 256, 32).vectorize(xi, vec).parallel(y);
+    blur_x.store_at(blur_y, x).compute_at(blur_y, yi).vectorize(x, vec);
+    blur_y.compile_jit(target);
+
+    double t = benchmark([&]() { blur_y.realize(out); });
+
+    result = Buffer<float>(W, H);
+    result.for_each_element([&](int x, int y) {
+        result(x, y) = (float)out(x, y);
+    });
+    return t;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    Buffer<float> f32_result, f16_result, bf16_result;
+    double t_f32 = blur_time<float>(f32_result);
+    double t_f16 = blur_time<float16_t>(f16_result);
+    double t_bf16 = blur_time<bfloat16_t>(bf16_result);
+
+    printf("float32: %f ms\n"
+           "float16: %f ms\n"
+           "bfloat16: %f ms\n",
+           t_f32 * 1e3, t_f16 * 1e3, t_bf16 * 1e3);
+
+    // The half precision results are rounded when blur_x is stored and
+    // at the end, and use rounded weights.
+    for (int y = 0; y < f32_result.height(); y++) {
+        for (int x = 0; x < f32_result.width(); x++) {
+            float correct = f32_result(x, y);
+            if (std::abs(f16_result(x, y) - correct) > 3e-3f ||
+                std::abs(bf16_result(x, y) - correct) > 2e-2f) {
+                printf("blur(%d, %d) = %f in float32, but %f in float16 and %f in bfloat16\n",
+                       x, y, correct, f16_result(x, y), bf16_result(x, y));
+                return -1;
+            }
+        }
+    }
+
+    // Native conversions make float16 storage worth it.
+    if ((target.has_feature(Target::F16C) || (target.arch == Target::ARM && target.bits == 64)) &&
+        t_f16 > 1.5 * t_f32) {
+        printf("float16 is more than 1.5x slower than float32\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+// The libm versions, called once per element. Some of these are macros
+// in some environments, so always wrap them.
+extern "C" DLLEXPORT float exp_ref(float x) {
+    return expf(x);
+}
+extern "C" DLLEXPORT float log_ref(float x) {
+    return logf(x);
+}
+extern "C" DLLEXPORT float pow_ref(float x, float y) {
+    return powf(x, y);
+}
+extern "C" DLLEXPORT float sin_ref(float x) {
+    return sinf(x);
+}
+extern "C" DLLEXPORT float cos_ref(float x) {
+    return cosf(x);
+}
+extern "C" DLLEXPORT float tan_ref(float x) {
+    return tanf(x);
+}
+extern "C" DLLEXPORT float atan2_ref(float y, float x) {
+    return atan2f(y, x);
+}
+extern "C" DLLEXPORT float tanh_ref(float x) {
+    return tanhf(x);
+}
+extern "C" DLLEXPORT float erf_ref(float x) {
+    return erff(x);
+}
+HalideExtern_1(float, exp_ref, float);
+HalideExtern_1(float, log_ref, float);
+HalideExtern_2(float, pow_ref, float, float);
+HalideExtern_1(float, sin_ref, float);
+HalideExtern_1(float, cos_ref, float);
+HalideExtern_1(float, tan_ref, float);
+HalideExtern_2(float, atan2_ref, float, float);
+HalideExtern_1(float, tanh_ref, float);
+HalideExtern_1(float, erf_ref, float);
+
+// The distance from the correctly rounded result, in units of the
+// last place of the result.
+double ulp_error(float actual, double correct) {
+    float rounded = (float)correct;
+    if (actual == rounded || (std::isnan(actual) && std::isnan(correct))) {
+        return 0;
+    }
+    int exponent;
+    std::frexp(rounded, &exponent);
+    double ulp = std::ldexp(1.0, std::max(exponent, -125) - 24);
+    return std::fabs(actual - correct) / ulp;
+}
+
+struct Tier {
+    const char *name;
+    std::function<Expr(Expr, Expr)> f;
+    // The largest error in ulp we expect, or zero if it isn't checked.
+    double max_ulp;
+};
+
+struct Function {
+    const char *name;
+    std::function<double(double, double)> reference;
+    float min_x, max_x, min_y, max_y;
+    std::vector<Tier> tiers;
+};
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    // The accuracy tiers of each function: libm, Halide's version
+    // (which is what vectorized code gets by default), and the fast_
+    // version where there is one.
+    std::vector<Function> functions = {
+        {"exp", [](double x, double) { return std::exp(x); }, -80, 80, 0, 0,
+         {{"libm", [](Expr x, Expr) { return exp_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return exp(x); }, 2},
+          {"fast", [](Expr x, Expr) { return fast_exp(x); }, 0}}},
+        {"log", [](double x, double) { return std::log(x); }, 1e-6f, 1e6f, 0, 0,
+         {{"libm", [](Expr x, Expr) { return log_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return log(x); }, 0},
+          {"fast", [](Expr x, Expr) { return fast_log(x); }, 0}}},
+        {"pow", [](double x, double y) { return std::pow(x, y); }, 0.01f, 4, -8, 8,
+         {{"libm", [](Expr x, Expr y) { return pow_ref(x, y); }, 0},
+          {"halide", [](Expr x, Expr y) { return pow(x, y); }, 0},
+          {"fast", [](Expr x, Expr y) { return fast_pow(x, y); }, 0}}},
+        {"sin", [](double x, double) { return std::sin(x); }, -100, 100, 0, 0,
+         {{"libm", [](Expr x, Expr) { return sin_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return sin(x); }, 3},
+          {"fast", [](Expr x, Expr) { return fast_sin(x); }, 0}}},
+        {"cos", [](double x, double) { return std::cos(x); }, -100, 100, 0, 0,
+         {{"libm", [](Expr x, Expr) { return cos_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return cos(x); }, 3},
+          {"fast", [](Expr x, Expr) { return fast_cos(x); }, 0}}},
+        {"tan", [](double x, double) { return std::tan(x); }, -100, 100, 0, 0,
+         {{"libm", [](Expr x, Expr) { return tan_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return tan(x); }, 4}}},
+        {"atan2", [](double y, double x) { return std::atan2(y, x); }, -10, 10, -10, 10,
+         {{"libm", [](Expr y, Expr x) { return atan2_ref(y, x); }, 0},
+          {"halide", [](Expr y, Expr x) { return atan2(y, x); }, 4}}},
+        {"tanh", [](double x, double) { return std::tanh(x); }, -10, 10, 0, 0,
+         {{"libm", [](Expr x, Expr) { return tanh_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return tanh(x); }, 2}}},
+        {"erf", [](double x, double) { return std::erf(x); }, -4, 4, 0, 0,
+         {{"libm", [](Expr x, Expr) { return erf_ref(x); }, 0},
+          {"halide", [](Expr x, Expr) { return erf(x); }, 0}}},
+    };
+
+    const int size = 1 << 16;
+    Buffer<float> in_x(size), in_y(size), out(size);
+    std::mt19937 rng(0);
+
+    printf("%-8s %-8s %16s %16s %16s\n", "function", "tier", "ns per element", "max ulp error", "rms ulp error");
+    bool ok = true;
+    for (const Function &fn : functions) {
+        std::uniform_real_distribution<float> dist_x(fn.min_x, fn.max_x), dist_y(fn.min_y, fn.max_y);
+        for (int i = 0; i < size; i++) {
+            in_x(i) = dist_x(rng);
+            in_y(i) = dist_y(rng);
+        }
+
+        double libm_time = 0;
+        for (const Tier &tier : fn.tiers) {
+            Func f;
+            Var x;
+            f(x) = tier.f(in_x(x), in_y(x));
+            f.vectorize(x, target.natural_vector_size<float>());
+            f.compile_jit(target);
+
+            double t = 1e9 * benchmark([&]() { f.realize(out); }) / size;
+
+            double max_error = 0, sum_sq_error = 0;
+            for (int i = 0; i < size; i++) {
+                double e = ulp_error(out(i), fn.reference(in_x(i), in_y(i)));
+                max_error = std::max(max_error, e);
+                sum_sq_error += e * e;
+            }
+            printf("%-8s %-8s %16.3f %16.1f %16.3f\n", fn.name, tier.name, t,
+                   max_error, std::sqrt(sum_sq_error / size));
+
+            if (tier.max_ulp > 0 && max_error > tier.max_ulp) {
+                printf("Error for %s's %s is %f ulp, but should be at most %f ulp\n",
+                       tier.name, fn.name, max_error, tier.max_ulp);
+                ok = false;
+            }
+            if (!strcmp(tier.name, "libm")) {
+                libm_time = t;
+            } else if (t > libm_time) {
+                printf("%s's %s is slower than libm's\n", tier.name, fn.name);
+                ok = false;
+            }
+        }
+    }
+
+    if (!ok) {
+        return -1;
+    }
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,20 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f, g;
+    Var x, y;
+    f(x, y) = x + y;
+    g(x, y) = f(x, y - 1) + f(x, y + 1);
+
+    // An async depth can't grow an explicit fold factor, so it should
+    // cause a warning.
+    g.compute_root();
+    f.store_root().compute_at(g, y).fold_storage(y, 4).async(4);
+
+    g.realize(16, 16);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Compares two reports written by halide_profiler_snapshot_report, and
+// prints how much time each Func was billed between them, most
+// expensive first.
+//
+// Usage: profiler_snapshot_diff before.txt after.txt
+//
+// Lines not starting with "halide_profiler_snapshot" are ignored, so
+// the reports can be mixed in with other log output.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Entry {
+    uint64_t time = 0;
+    int64_t runs = 0, sampled_runs = 0;
+};
+
+typedef std::map<std::pair<std::string, std::string>, Entry> Snapshot;
+
+bool load(const char *filename, Snapshot *snapshot) {
+    std::ifstream f(filename);
+    if (!f.is_open()) {
+        std::cerr << "Could not open " << filename << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(f, line)) {
+        std::istringstream in(line);
+        std::string tag, pipeline, func;
+        Entry e;
+        in >> tag;
+        if (tag != "halide_profiler_snapshot") {
+            continue;
+        }
+        if (!(in >> pipeline >> func >> e.time >> e.runs >> e.sampled_runs)) {
+            std::cerr << "Malformed line in " << filename << ": " << line << "\n";
+            return false;
+        }
+        (*snapshot)[{pipeline, func}] = e;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " before.txt after.txt\n";
+        return 1;
+    }
+
+    Snapshot before, after;
+    if (!load(argv[1], &before) || !load(argv[2], &after)) {
+        return 1;
+    }
+
+    struct Delta {
+        std::string pipeline, func;
+        uint64_t time;
+        int64_t runs, sampled_runs;
+    };
+    std::vector<Delta> deltas;
+    for (const auto &it : after) {
+        Entry b;
+        auto prev = before.find(it.first);
+        // A pipeline that has been reset since the first snapshot
+        // starts over from zero.
+        if (prev != before.end() && prev->second.runs <= it.second.runs) {
+            b = prev->second;
+        }
+        const Entry &a = it.second;
+        deltas.push_back({it.first.first, it.first.second,
+                          a.time - std::min(a.time, b.time),
+                          a.runs - b.runs,
+                          a.sampled_runs - b.sampled_runs});
+    }
+    std::stable_sort(deltas.begin(), deltas.end(), [](const Delta &a, const Delta &b) {
+        return a.time > b.time;
+    });
+
+    printf("%-24s %-24s %12s %10s %10s %12s\n",
+           "pipeline", "func", "time (ms)", "runs", "sampled", "ms/run");
+    for (const Delta &d : deltas) {
+        if (d.runs == 0) {
+            continue;
+        }
+        double ms = d.time / 1000000.0;
+        double per_run = d.sampled_runs > 0 ? ms / d.sampled_runs : 0.0;
+        printf("%-24s %-24s %12.3f %10lld %10lld %12.4f\n",
+               d.pipeline.c_str(), d.func.c_str(), ms,
+               (long long)d.runs, (long long)d.sampled_runs, per_run);
+    }
+    return 0;
+}